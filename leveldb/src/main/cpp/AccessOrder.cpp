@@ -0,0 +1,31 @@
+#include "AccessOrder.h"
+#include "Coding.h"
+
+static const std::string kAccessOrderPrefix = InternalKey("ao:");
+static const std::string kAccessStampPrefix = InternalKey("aok:");
+
+std::string AccessOrderPrefix() {
+    return kAccessOrderPrefix;
+}
+
+std::string AccessOrderKey(uint64_t stamp, const leveldb::Slice &key) {
+    std::string entry = kAccessOrderPrefix;
+    PutFixed64BE(entry, stamp);
+    entry.append(key.data(), key.size());
+    return entry;
+}
+
+bool DecodeAccessOrderKey(const leveldb::Slice &entry, uint64_t &stamp, std::string &key) {
+    if (entry.size() < kAccessOrderPrefix.size() + 8 || !entry.starts_with(kAccessOrderPrefix)) {
+        return false;
+    }
+    stamp = DecodeFixed64BE(entry.data() + kAccessOrderPrefix.size());
+    key.assign(entry.data() + kAccessOrderPrefix.size() + 8, entry.size() - kAccessOrderPrefix.size() - 8);
+    return true;
+}
+
+std::string AccessStampKey(const leveldb::Slice &key) {
+    std::string stampKey = kAccessStampPrefix;
+    stampKey.append(key.data(), key.size());
+    return stampKey;
+}
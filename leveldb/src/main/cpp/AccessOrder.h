@@ -0,0 +1,30 @@
+//
+// Created on 2026/10/19.
+//
+// Access-order index of a size-capped database:
+//   ao:  | fixed64 stamp | user key -> empty
+//   aok: | user key                 -> fixed64 stamp
+// Stamps come from one increasing clock, so the oldest entry of "ao:" is the
+// next key to evict. A key's stamp record says which order entry is current;
+// order entries that do not match it are stale and are dropped when met.
+
+#ifndef LEVELDB_ACCESSORDER_H
+#define LEVELDB_ACCESSORDER_H
+
+#include <string>
+#include <stdint.h>
+#include <leveldb/slice.h>
+
+enum CacheEviction : uint8_t {
+    // Reads and writes refresh a key's stamp.
+    kCacheEvictLru = 0,
+    // Only writes do.
+    kCacheEvictFifo = 1,
+};
+
+std::string AccessOrderPrefix();
+std::string AccessOrderKey(uint64_t stamp, const leveldb::Slice &key);
+bool DecodeAccessOrderKey(const leveldb::Slice &entry, uint64_t &stamp, std::string &key);
+std::string AccessStampKey(const leveldb::Slice &key);
+
+#endif // LEVELDB_ACCESSORDER_H
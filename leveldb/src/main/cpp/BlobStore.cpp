@@ -0,0 +1,302 @@
+#include "BlobStore.h"
+#include "Coding.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A file is sealed once it grows past this; only sealed files are collected.
+static const uint64_t kBlobFileSize = 64 << 20;
+static const size_t kBlobRecordHeaderSize = 12;
+static const size_t kBlobPointerSize = 24;
+static const char kBlobFileSuffix[] = ".blob";
+
+static uint32_t Crc32(const char *data, size_t size, uint32_t crc = 0) {
+    static uint32_t table[256];
+    static bool ready = [] {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        return true;
+    }();
+    (void)ready;
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static bool WriteAll(int fd, const std::string &data, uint64_t offset) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = pwrite(fd, data.data() + written, data.size() - written, offset + written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+static bool ReadAll(int fd, char *buf, size_t size, uint64_t offset) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pread(fd, buf + done, size - done, offset + done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+std::string EncodeBlobPointer(const BlobPointer &pointer) {
+    std::string encoded;
+    PutFixed64BE(encoded, pointer.file);
+    PutFixed64BE(encoded, pointer.offset);
+    PutFixed32BE(encoded, pointer.keySize);
+    PutFixed32BE(encoded, pointer.valueSize);
+    return encoded;
+}
+
+bool DecodeBlobPointer(const leveldb::Slice &encoded, BlobPointer &pointer) {
+    if (encoded.size() != kBlobPointerSize) {
+        return false;
+    }
+    pointer.file = DecodeFixed64BE(encoded.data());
+    pointer.offset = DecodeFixed64BE(encoded.data() + 8);
+    pointer.keySize = DecodeFixed32BE(encoded.data() + 16);
+    pointer.valueSize = DecodeFixed32BE(encoded.data() + 20);
+    return true;
+}
+
+uint64_t BlobRecordSize(const BlobPointer &pointer) {
+    return kBlobRecordHeaderSize + pointer.keySize + pointer.valueSize;
+}
+
+BlobStore::File::~File() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+BlobStore::BlobStore() : _activeFile(0), _nextFile(1) {
+}
+
+BlobStore::~BlobStore() {
+    Close();
+}
+
+std::string BlobStore::FilePath(uint64_t number) const {
+    char name[32];
+    snprintf(name, sizeof(name), "/%06llu%s", static_cast<unsigned long long>(number), kBlobFileSuffix);
+    return _dir + name;
+}
+
+bool BlobStore::Open(const std::string &dir, std::string *error) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _dir = dir;
+    _files.clear();
+    _activeFile = 0;
+    _nextFile = 1;
+    DIR *handle = opendir(dir.c_str());
+    if (handle == nullptr) {
+        return true;
+    }
+    bool ok = true;
+    while (struct dirent *entry = readdir(handle)) {
+        std::string name = entry->d_name;
+        size_t suffixSize = sizeof(kBlobFileSuffix) - 1;
+        if (name.size() <= suffixSize || name.compare(name.size() - suffixSize, suffixSize, kBlobFileSuffix) != 0) {
+            continue;
+        }
+        char *end = nullptr;
+        uint64_t number = strtoull(name.c_str(), &end, 10);
+        if (end != name.c_str() + name.size() - suffixSize || number == 0) {
+            continue;
+        }
+        auto file = std::make_shared<File>();
+        file->fd = open(FilePath(number).c_str(), O_RDONLY);
+        struct stat st;
+        if (file->fd < 0 || fstat(file->fd, &st) != 0) {
+            if (error) {
+                *error = "cannot open blob file " + FilePath(number);
+            }
+            ok = false;
+            break;
+        }
+        file->size = st.st_size;
+        _files[number] = file;
+        _nextFile = std::max(_nextFile, number + 1);
+    }
+    closedir(handle);
+    if (!ok) {
+        _files.clear();
+    }
+    return ok;
+}
+
+void BlobStore::Close() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _files.clear();
+    _activeFile = 0;
+}
+
+bool BlobStore::Append(const leveldb::Slice &key, const leveldb::Slice &value, BlobPointer &pointer) {
+    std::string record;
+    record.reserve(kBlobRecordHeaderSize + key.size() + value.size());
+    uint32_t crc = Crc32(value.data(), value.size(), Crc32(key.data(), key.size()));
+    PutFixed32BE(record, crc);
+    PutFixed32BE(record, static_cast<uint32_t>(key.size()));
+    PutFixed32BE(record, static_cast<uint32_t>(value.size()));
+    record.append(key.data(), key.size());
+    record.append(value.data(), value.size());
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto active = _activeFile != 0 ? _files[_activeFile] : nullptr;
+    if (!active || active->size >= kBlobFileSize) {
+        mkdir(_dir.c_str(), 0755);
+        uint64_t number = _nextFile;
+        auto file = std::make_shared<File>();
+        file->fd = open(FilePath(number).c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (file->fd < 0) {
+            return false;
+        }
+        _nextFile++;
+        _files[number] = file;
+        _activeFile = number;
+        active = file;
+    }
+    if (!WriteAll(active->fd, record, active->size)) {
+        // Drop the partial record so the next one starts at a record boundary.
+        if (ftruncate(active->fd, active->size) != 0) {
+            _activeFile = 0;
+        }
+        return false;
+    }
+    pointer.file = _activeFile;
+    pointer.offset = active->size;
+    pointer.keySize = static_cast<uint32_t>(key.size());
+    pointer.valueSize = static_cast<uint32_t>(value.size());
+    active->size += record.size();
+    return true;
+}
+
+bool BlobStore::Sync() {
+    std::shared_ptr<File> active;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_activeFile == 0) {
+            return true;
+        }
+        active = _files[_activeFile];
+    }
+    return fdatasync(active->fd) == 0;
+}
+
+std::shared_ptr<BlobStore::File> BlobStore::FindFile(uint64_t number) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _files.find(number);
+    return it == _files.end() ? nullptr : it->second;
+}
+
+bool BlobStore::Read(const BlobPointer &pointer, const leveldb::Slice &key, std::string &value) {
+    std::shared_ptr<File> file = FindFile(pointer.file);
+    if (!file || pointer.keySize != key.size()) {
+        return false;
+    }
+    std::string record(kBlobRecordHeaderSize + pointer.keySize + pointer.valueSize, '\0');
+    if (!ReadAll(file->fd, &record[0], record.size(), pointer.offset)) {
+        return false;
+    }
+    const char *body = record.data() + kBlobRecordHeaderSize;
+    if (DecodeFixed32BE(record.data() + 4) != pointer.keySize ||
+        DecodeFixed32BE(record.data() + 8) != pointer.valueSize ||
+        memcmp(body, key.data(), key.size()) != 0 ||
+        DecodeFixed32BE(record.data()) != Crc32(body, record.size() - kBlobRecordHeaderSize)) {
+        return false;
+    }
+    value.assign(body + pointer.keySize, pointer.valueSize);
+    return true;
+}
+
+std::vector<BlobFileInfo> BlobStore::SealedFiles() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<BlobFileInfo> sealed;
+    for (const auto& entry : _files) {
+        if (entry.first != _activeFile) {
+            BlobFileInfo info;
+            info.number = entry.first;
+            info.size = entry.second->size;
+            sealed.push_back(info);
+        }
+    }
+    return sealed;
+}
+
+void BlobStore::Seal() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _activeFile = 0;
+}
+
+void BlobStore::ForEachRecord(uint64_t number,
+                              const std::function<bool(const BlobPointer &, const std::string &)> &visit) {
+    std::shared_ptr<File> file = FindFile(number);
+    if (!file) {
+        return;
+    }
+    uint64_t size = file->size;
+    uint64_t offset = 0;
+    char header[kBlobRecordHeaderSize];
+    while (offset + kBlobRecordHeaderSize <= size && ReadAll(file->fd, header, sizeof(header), offset)) {
+        BlobPointer pointer;
+        pointer.file = number;
+        pointer.offset = offset;
+        pointer.keySize = DecodeFixed32BE(header + 4);
+        pointer.valueSize = DecodeFixed32BE(header + 8);
+        uint64_t end = offset + kBlobRecordHeaderSize + pointer.keySize + pointer.valueSize;
+        if (end > size) {
+            break;
+        }
+        std::string key(pointer.keySize, '\0');
+        if (!ReadAll(file->fd, &key[0], key.size(), offset + kBlobRecordHeaderSize) || !visit(pointer, key)) {
+            break;
+        }
+        offset = end;
+    }
+}
+
+void BlobStore::RemoveFile(uint64_t number) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (number == _activeFile) {
+        _activeFile = 0;
+    }
+    if (_files.erase(number) > 0) {
+        unlink(FilePath(number).c_str());
+    }
+}
+
+uint64_t BlobStore::TotalBytes() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint64_t total = 0;
+    for (const auto& entry : _files) {
+        total += entry.second->size;
+    }
+    return total;
+}
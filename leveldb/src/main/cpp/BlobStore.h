@@ -0,0 +1,87 @@
+//
+// Created on 2026/10/19.
+//
+// Append-only blob files for values that are too large to keep in the LSM:
+//   <db>/blobs/<number>.blob
+// Each record is
+//   crc32 (fixed32) | key length (fixed32) | value length (fixed32) | key | value
+// with the checksum covering key and value. The LSM stores a BlobPointer in
+// place of the value; the key in the record lets garbage collection ask the
+// LSM whether the record is still the current value of that key.
+
+#ifndef LEVELDB_BLOBSTORE_H
+#define LEVELDB_BLOBSTORE_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <leveldb/slice.h>
+
+struct BlobPointer {
+    uint64_t file = 0;
+    // Start of the record, not of the value.
+    uint64_t offset = 0;
+    uint32_t keySize = 0;
+    uint32_t valueSize = 0;
+};
+
+std::string EncodeBlobPointer(const BlobPointer &pointer);
+bool DecodeBlobPointer(const leveldb::Slice &encoded, BlobPointer &pointer);
+// Bytes the record takes up in its file.
+uint64_t BlobRecordSize(const BlobPointer &pointer);
+
+struct BlobFileInfo {
+    uint64_t number = 0;
+    uint64_t size = 0;
+};
+
+class BlobStore {
+public:
+    BlobStore();
+    ~BlobStore();
+
+    // Lists the files already in dir; the directory itself is only created
+    // by the first Append().
+    bool Open(const std::string &dir, std::string *error = nullptr);
+    void Close();
+
+    bool Append(const leveldb::Slice &key, const leveldb::Slice &value, BlobPointer &pointer);
+    // Makes everything appended so far durable.
+    bool Sync();
+    // False if the file is gone, or the record is damaged or not for key.
+    bool Read(const BlobPointer &pointer, const leveldb::Slice &key, std::string &value);
+
+    // Files that are no longer appended to, oldest first.
+    std::vector<BlobFileInfo> SealedFiles();
+    // Starts a new file on the next Append().
+    void Seal();
+    // Visits the records of a file without reading their values; stops at the
+    // end of the file, at a truncated record or when visit returns false.
+    void ForEachRecord(uint64_t file, const std::function<bool(const BlobPointer &, const std::string &)> &visit);
+    // Readers that already hold the file can still finish.
+    void RemoveFile(uint64_t file);
+    uint64_t TotalBytes();
+
+private:
+    struct File {
+        int fd = -1;
+        uint64_t size = 0;
+        ~File();
+    };
+
+    std::string FilePath(uint64_t number) const;
+    std::shared_ptr<File> FindFile(uint64_t number);
+
+    std::mutex _mutex;
+    std::string _dir;
+    std::map<uint64_t, std::shared_ptr<File>> _files;
+    // 0 while no file is open for appending.
+    uint64_t _activeFile;
+    uint64_t _nextFile;
+};
+
+#endif // LEVELDB_BLOBSTORE_H
@@ -0,0 +1,117 @@
+#include "Coding.h"
+#include <chrono>
+
+static const char kValueEnvelopeMarker = '\xff';
+
+bool IsInternalKey(const leveldb::Slice &key) {
+    return key.starts_with(kInternalKeyPrefix);
+}
+
+bool IsReservedKey(const leveldb::Slice &key) {
+    return key.size() >= 2 && key[0] == '\xff' && key[1] == '\xff';
+}
+
+std::string PrefixSuccessor(const std::string &prefix) {
+    std::string limit = prefix;
+    while (!limit.empty()) {
+        unsigned char last = static_cast<unsigned char>(limit.back());
+        if (last != 0xff) {
+            limit.back() = static_cast<char>(last + 1);
+            return limit;
+        }
+        limit.pop_back();
+    }
+    return limit;
+}
+
+void PutFixed32BE(std::string &dst, uint32_t value) {
+    char buf[4];
+    for (int i = 3; i >= 0; i--) {
+        buf[i] = static_cast<char>(value & 0xff);
+        value >>= 8;
+    }
+    dst.append(buf, sizeof(buf));
+}
+
+void PutFixed64BE(std::string &dst, uint64_t value) {
+    char buf[8];
+    for (int i = 7; i >= 0; i--) {
+        buf[i] = static_cast<char>(value & 0xff);
+        value >>= 8;
+    }
+    dst.append(buf, sizeof(buf));
+}
+
+uint32_t DecodeFixed32BE(const char *ptr) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value = (value << 8) | static_cast<uint8_t>(ptr[i]);
+    }
+    return value;
+}
+
+uint64_t DecodeFixed64BE(const char *ptr) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value = (value << 8) | static_cast<uint8_t>(ptr[i]);
+    }
+    return value;
+}
+
+void PutVarint64(std::string &dst, uint64_t value) {
+    while (value >= 0x80) {
+        dst.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    dst.push_back(static_cast<char>(value));
+}
+
+bool GetVarint64(leveldb::Slice &input, uint64_t &value) {
+    value = 0;
+    for (uint32_t shift = 0; shift <= 63 && !input.empty(); shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(input[0]);
+        input.remove_prefix(1);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string EncodeValue(const ValueHeader &header, const leveldb::Slice &payload) {
+    std::string raw;
+    raw.reserve(payload.size() + 10);
+    raw.push_back(kValueEnvelopeMarker);
+    raw.push_back(static_cast<char>(header.flags));
+    if (header.flags & kValueFlagExpires) {
+        PutFixed64BE(raw, static_cast<uint64_t>(header.expiresAt));
+    }
+    raw.append(payload.data(), payload.size());
+    return raw;
+}
+
+size_t DecodeValueHeader(const leveldb::Slice &raw, ValueHeader &header) {
+    header = ValueHeader();
+    if (raw.empty() || raw[0] != kValueEnvelopeMarker) {
+        return 0;
+    }
+    if (raw.size() < 2) {
+        return std::string::npos;
+    }
+    size_t offset = 2;
+    header.flags = static_cast<uint8_t>(raw[1]);
+    if (header.flags & kValueFlagExpires) {
+        if (raw.size() < offset + 8) {
+            return std::string::npos;
+        }
+        header.expiresAt = static_cast<int64_t>(DecodeFixed64BE(raw.data() + offset));
+        offset += 8;
+    }
+    return offset;
+}
+
+int64_t NowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
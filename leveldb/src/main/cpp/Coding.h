@@ -0,0 +1,74 @@
+//
+// Created on 2026/10/19.
+//
+// Byte layouts shared by the wrapper: fixed-width big-endian integers, the
+// reserved key namespace used for wrapper metadata and the value envelope.
+
+#ifndef LEVELDB_CODING_H
+#define LEVELDB_CODING_H
+
+#include <string>
+#include <stdint.h>
+#include <leveldb/slice.h>
+
+// Keys written by the wrapper itself (expiry index, ...) start with this
+// prefix. UTF-8 user keys can never contain 0xff and binary user keys may not
+// start with 0xff 0xff, so the namespace sorts after every user key and is
+// skipped by allKeys() and scans.
+const std::string kInternalKeyPrefix("\xff\xff" "ldb:", 6);
+bool IsInternalKey(const leveldb::Slice &key);
+// True for keys in the reserved 0xff 0xff range that users may not write.
+bool IsReservedKey(const leveldb::Slice &key);
+// Inline on purpose: translation units build their prefixes during static
+// initialization, before Coding.cpp's own statics may exist.
+inline std::string InternalKey(const std::string &tag) {
+    return kInternalKeyPrefix + tag;
+}
+// Smallest key (bytewise) greater than every key starting with prefix, or ""
+// if there is none.
+std::string PrefixSuccessor(const std::string &prefix);
+
+void PutFixed32BE(std::string &dst, uint32_t value);
+void PutFixed64BE(std::string &dst, uint64_t value);
+uint32_t DecodeFixed32BE(const char *ptr);
+uint64_t DecodeFixed64BE(const char *ptr);
+// LEB128 varints, as leveldb uses internally.
+void PutVarint64(std::string &dst, uint64_t value);
+// Advances "input" past the varint; false if it is truncated.
+bool GetVarint64(leveldb::Slice &input, uint64_t &value);
+
+// Plain values are the serialized text of the stored type. Values that carry
+// metadata are wrapped in an envelope:
+//   0xff | flags | [expiresAt: fixed64 if kValueFlagExpires] | payload
+// 0xff never starts a plain value (UTF-8 text or ASCII numbers), so both
+// forms can live side by side.
+enum ValueFlags : uint8_t {
+    kValueFlagExpires = 1 << 0,
+    // The payload is an ObjectCodec document rather than text.
+    kValueFlagObject = 1 << 1,
+    // The payload is a BlobPointer (see BlobStore.h) to the actual payload.
+    kValueFlagBlob = 1 << 2,
+    // The payload is varint dictionary id (0 for none) | varint raw length |
+    // LZ data (see Compression.h). Applied before blob separation.
+    kValueFlagCompressed = 1 << 3,
+    // The payload is the ContentHash of a value stored once under
+    // SharedContentKey (see Dedup.h).
+    kValueFlagShared = 1 << 4,
+    // The payload is a record packed by a schema (see Schema.h); readers see
+    // it as an object.
+    kValueFlagPacked = 1 << 5,
+};
+
+struct ValueHeader {
+    uint8_t flags = 0;
+    int64_t expiresAt = 0;
+};
+
+std::string EncodeValue(const ValueHeader &header, const leveldb::Slice &payload);
+// Parses the envelope of "raw" and returns the offset of the payload, or
+// std::string::npos if the envelope is truncated.
+size_t DecodeValueHeader(const leveldb::Slice &raw, ValueHeader &header);
+
+int64_t NowMs();
+
+#endif // LEVELDB_CODING_H
@@ -0,0 +1,217 @@
+#include "Comparators.h"
+#include "Coding.h"
+#include <algorithm>
+
+// leveldb's bytewise shortening, used on candidates that are then checked
+// against the actual ordering.
+static void BytewiseSeparator(std::string &start, const leveldb::Slice &limit) {
+    size_t minLength = std::min(start.size(), limit.size());
+    size_t diff = 0;
+    while (diff < minLength && start[diff] == limit[diff]) {
+        diff++;
+    }
+    if (diff >= minLength) {
+        return;
+    }
+    uint8_t byte = static_cast<uint8_t>(start[diff]);
+    if (byte < 0xff && byte + 1 < static_cast<uint8_t>(limit[diff])) {
+        start[diff]++;
+        start.resize(diff + 1);
+    }
+}
+
+static void BytewiseSuccessor(std::string &key) {
+    for (size_t i = 0; i < key.size(); i++) {
+        if (static_cast<uint8_t>(key[i]) != 0xff) {
+            key[i]++;
+            key.resize(i + 1);
+            return;
+        }
+    }
+}
+
+static std::string ToLowerAscii(const leveldb::Slice &key) {
+    std::string lower(key.data(), key.size());
+    for (char &c : lower) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+    }
+    return lower;
+}
+
+class BuiltinComparator : public leveldb::Comparator {
+public:
+    explicit BuiltinComparator(const char *name) : _name(name) {}
+
+    const char *Name() const override { return _name; }
+
+    int Compare(const leveldb::Slice &a, const leveldb::Slice &b) const override {
+        bool aInternal = IsInternalKey(a);
+        bool bInternal = IsInternalKey(b);
+        if (aInternal || bInternal) {
+            return aInternal == bInternal ? a.compare(b) : (aInternal ? 1 : -1);
+        }
+        return CompareUserKeys(a, b);
+    }
+
+    void FindShortestSeparator(std::string *start, const leveldb::Slice &limit) const override {
+        std::string candidate = *start;
+        if (IsInternalKey(*start) || IsInternalKey(limit)) {
+            BytewiseSeparator(candidate, limit);
+        } else {
+            UserSeparator(candidate, limit);
+        }
+        if (candidate.size() < start->size() && Compare(*start, candidate) <= 0 && Compare(candidate, limit) < 0) {
+            start->swap(candidate);
+        }
+    }
+
+    void FindShortSuccessor(std::string *key) const override {
+        std::string candidate = *key;
+        if (IsInternalKey(*key)) {
+            BytewiseSuccessor(candidate);
+        } else {
+            UserSuccessor(candidate);
+        }
+        if (candidate.size() < key->size() && Compare(*key, candidate) <= 0) {
+            key->swap(candidate);
+        }
+    }
+
+protected:
+    virtual int CompareUserKeys(const leveldb::Slice &a, const leveldb::Slice &b) const = 0;
+    // Propose a shorter key; the caller only keeps it if the order allows.
+    virtual void UserSeparator(std::string &start, const leveldb::Slice &limit) const = 0;
+    virtual void UserSuccessor(std::string &key) const = 0;
+
+private:
+    const char *_name;
+};
+
+class FixedInt64Comparator : public BuiltinComparator {
+public:
+    FixedInt64Comparator(const char *name, bool isSigned) : BuiltinComparator(name), _signed(isSigned) {}
+
+protected:
+    int CompareUserKeys(const leveldb::Slice &a, const leveldb::Slice &b) const override {
+        bool aNumber = a.size() == sizeof(uint64_t);
+        bool bNumber = b.size() == sizeof(uint64_t);
+        if (aNumber && bNumber) {
+            uint64_t x = DecodeFixed64BE(a.data());
+            uint64_t y = DecodeFixed64BE(b.data());
+            if (_signed) {
+                x ^= 1ull << 63;
+                y ^= 1ull << 63;
+            }
+            return x < y ? -1 : (x > y ? 1 : 0);
+        }
+        if (aNumber != bNumber) {
+            return aNumber ? -1 : 1;
+        }
+        return a.compare(b);
+    }
+
+    void UserSeparator(std::string &start, const leveldb::Slice &limit) const override {
+        // Numbers are already as short as they get.
+        if (start.size() != sizeof(uint64_t) && limit.size() != sizeof(uint64_t)) {
+            BytewiseSeparator(start, limit);
+        }
+    }
+
+    void UserSuccessor(std::string &key) const override {
+        if (key.size() == sizeof(uint64_t)) {
+            // The empty key sorts after every number.
+            key.clear();
+        } else {
+            BytewiseSuccessor(key);
+        }
+    }
+
+private:
+    bool _signed;
+};
+
+class ReverseBytewiseComparator : public BuiltinComparator {
+public:
+    ReverseBytewiseComparator() : BuiltinComparator("ohos.leveldb.ReverseBytewiseComparator") {}
+
+protected:
+    int CompareUserKeys(const leveldb::Slice &a, const leveldb::Slice &b) const override {
+        return b.compare(a);
+    }
+
+    void UserSeparator(std::string &start, const leveldb::Slice &limit) const override {
+        // start is bytewise greater than limit; its prefix one byte past the
+        // common part still is.
+        size_t minLength = std::min(start.size(), limit.size());
+        size_t diff = 0;
+        while (diff < minLength && start[diff] == limit[diff]) {
+            diff++;
+        }
+        if (diff < start.size()) {
+            start.resize(diff + 1);
+        }
+    }
+
+    void UserSuccessor(std::string &key) const override {
+        // The empty key is the last user key in descending order.
+        key.clear();
+    }
+};
+
+class CaseInsensitiveAsciiComparator : public BuiltinComparator {
+public:
+    CaseInsensitiveAsciiComparator() : BuiltinComparator("ohos.leveldb.CaseInsensitiveAsciiComparator") {}
+
+protected:
+    int CompareUserKeys(const leveldb::Slice &a, const leveldb::Slice &b) const override {
+        size_t minLength = std::min(a.size(), b.size());
+        for (size_t i = 0; i < minLength; i++) {
+            uint8_t x = Fold(a[i]);
+            uint8_t y = Fold(b[i]);
+            if (x != y) {
+                return x < y ? -1 : 1;
+            }
+        }
+        if (a.size() != b.size()) {
+            return a.size() < b.size() ? -1 : 1;
+        }
+        return a.compare(b);
+    }
+
+    void UserSeparator(std::string &start, const leveldb::Slice &limit) const override {
+        start = ToLowerAscii(start);
+        BytewiseSeparator(start, ToLowerAscii(limit));
+    }
+
+    void UserSuccessor(std::string &key) const override {
+        key = ToLowerAscii(key);
+        BytewiseSuccessor(key);
+    }
+
+private:
+    static uint8_t Fold(char c) {
+        return static_cast<uint8_t>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+    }
+};
+
+const leveldb::Comparator *FindComparator(const std::string &id) {
+    static const FixedInt64Comparator *uint64BE = new FixedInt64Comparator("ohos.leveldb.Uint64BEComparator", false);
+    static const FixedInt64Comparator *int64BE = new FixedInt64Comparator("ohos.leveldb.Int64BEComparator", true);
+    static const ReverseBytewiseComparator *reverseBytewise = new ReverseBytewiseComparator();
+    static const CaseInsensitiveAsciiComparator *caseInsensitiveAscii = new CaseInsensitiveAsciiComparator();
+
+    if (id.empty() || id == "bytewise") {
+        return leveldb::BytewiseComparator();
+    } else if (id == "uint64BE") {
+        return uint64BE;
+    } else if (id == "int64BE") {
+        return int64BE;
+    } else if (id == "reverseBytewise") {
+        return reverseBytewise;
+    } else if (id == "caseInsensitiveAscii") {
+        return caseInsensitiveAscii;
+    }
+    return nullptr;
+}
@@ -0,0 +1,26 @@
+//
+// Created on 2026/10/19.
+//
+// Built-in key orderings selectable when a database is opened. Every
+// comparator keeps the wrapper's internal keys after all user keys, in
+// bytewise order among themselves, so the expiry index, merge deltas and
+// other metadata work the same under any ordering.
+
+#ifndef LEVELDB_COMPARATORS_H
+#define LEVELDB_COMPARATORS_H
+
+#include <string>
+#include <leveldb/comparator.h>
+
+// Ids accepted by open():
+//   bytewise              leveldb's default ordering
+//   uint64BE / int64BE    8-byte keys as big-endian unsigned / signed
+//                         integers; keys of any other length follow them in
+//                         bytewise order
+//   reverseBytewise       bytewise, descending
+//   caseInsensitiveAscii  ASCII letters compared case-insensitively, ties
+//                         broken bytewise
+// Returns nullptr for an unknown id. The returned comparators live forever.
+const leveldb::Comparator *FindComparator(const std::string &id);
+
+#endif // LEVELDB_COMPARATORS_H
@@ -0,0 +1,142 @@
+#include "Completion.h"
+#include "Json.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+// Length of the UTF-8 sequence a byte starts; stray continuation bytes count
+// as one so malformed text still advances.
+static size_t CodePointLength(unsigned char byte) {
+    if ((byte & 0xe0) == 0xc0) {
+        return 2;
+    } else if ((byte & 0xf0) == 0xe0) {
+        return 3;
+    } else if ((byte & 0xf8) == 0xf0) {
+        return 4;
+    }
+    return 1;
+}
+
+// Bytes taken by the first count code points of text.
+static size_t CodePointPrefix(const std::string &text, size_t count) {
+    size_t offset = 0;
+    for (; count > 0 && offset < text.size(); count--) {
+        offset = std::min(text.size(), offset + CodePointLength(static_cast<unsigned char>(text[offset])));
+    }
+    return offset;
+}
+
+// Letters, digits and everything outside ASCII; the rest separates words.
+static bool IsWordByte(char c) {
+    unsigned char byte = static_cast<unsigned char>(c);
+    return byte >= 0x80 || isalnum(byte);
+}
+
+std::string NormalizeCompletionText(const std::string &text) {
+    std::string normalized;
+    normalized.reserve(text.size());
+    bool space = false;
+    for (char c : text) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (isspace(byte)) {
+            space = !normalized.empty();
+            continue;
+        }
+        if (space) {
+            normalized.push_back(' ');
+            space = false;
+        }
+        normalized.push_back(byte >= 'A' && byte <= 'Z' ? static_cast<char>(byte - 'A' + 'a') : c);
+    }
+    return normalized;
+}
+
+void ExtractCompletionEntries(const IndexSpec &spec, const std::string &value, const std::string &key,
+                              std::vector<std::string> &entries) {
+    entries.clear();
+    std::vector<std::string> texts;
+    double score = 0;
+    JsonValue root;
+    if (ParseJson(value, root)) {
+        const JsonValue *json = root.FindPath(spec.field);
+        if (json != nullptr && json->type == JsonValue::kString) {
+            texts.push_back(json->text);
+        } else if (json != nullptr && json->type == JsonValue::kArray) {
+            for (const auto& item : json->items) {
+                if (item.type == JsonValue::kString) {
+                    texts.push_back(item.text);
+                }
+            }
+        }
+        const JsonValue *jsonScore = spec.scoreField.empty() ? nullptr : root.FindPath(spec.scoreField);
+        if (jsonScore != nullptr && jsonScore->type == JsonValue::kNumber && std::isfinite(jsonScore->number)) {
+            score = jsonScore->number;
+        }
+    } else if (spec.field.empty()) {
+        texts.push_back(value);
+    }
+
+    // Negated so that higher scores sort first; 0 is kept positive because
+    // -0.0 encodes differently.
+    KeyPart rank;
+    rank.type = kKeyPartDouble;
+    rank.number = score == 0 ? 0 : -score;
+    KeyPart primary;
+    primary.type = kKeyPartBytes;
+    primary.bytes = key;
+    KeyPart term;
+    term.type = kKeyPartString;
+    size_t terms = 0;
+    for (const auto& text : texts) {
+        std::string normalized = NormalizeCompletionText(text);
+        for (size_t start = 0; start < normalized.size() && terms < kMaxCompletionTerms; start++) {
+            if (!IsWordByte(normalized[start]) || (start > 0 && IsWordByte(normalized[start - 1]))) {
+                continue;
+            }
+            terms++;
+            size_t length = std::min(normalized.size() - start, kMaxCompletionTermBytes);
+            while (start + length < normalized.size() && (normalized[start + length] & 0xc0) == 0x80) {
+                length--;
+            }
+            term.bytes = normalized.substr(start, length);
+            size_t previous = 0;
+            for (size_t count = 1; count <= kMaxCompletionPrefix; count++) {
+                size_t bytes = CodePointPrefix(term.bytes, count);
+                if (bytes == previous) {
+                    break;
+                }
+                previous = bytes;
+                std::string entry = CompletionSection(spec.name, term.bytes.substr(0, bytes));
+                EncodeKeyPart(entry, rank);
+                EncodeKeyPart(entry, primary);
+                EncodeKeyPart(entry, term);
+                entries.push_back(std::move(entry));
+            }
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+}
+
+std::string CompletionSection(const std::string &name, const std::string &input) {
+    KeyPart part;
+    part.type = kKeyPartString;
+    part.bytes = input.substr(0, CodePointPrefix(input, kMaxCompletionPrefix));
+    std::string section = IndexEntryPrefix(name);
+    EncodeKeyPart(section, part);
+    return section;
+}
+
+bool DecodeCompletionEntry(const leveldb::Slice &entry, size_t sectionSize, CompletionMatch &match) {
+    std::vector<KeyPart> parts;
+    if (entry.size() < sectionSize ||
+        !DecodeKeyTuple(leveldb::Slice(entry.data() + sectionSize, entry.size() - sectionSize), parts) ||
+        parts.size() != 3 || parts[0].type != kKeyPartDouble || parts[1].type != kKeyPartBytes ||
+        parts[2].type != kKeyPartString) {
+        return false;
+    }
+    match.score = parts[0].number == 0 ? 0 : -parts[0].number;
+    match.key = std::move(parts[1].bytes);
+    match.term = std::move(parts[2].bytes);
+    return true;
+}
@@ -0,0 +1,48 @@
+//
+// Created on 2026/10/19.
+//
+// Completion indexes are secondary indexes of type kIndexValueCompletion that
+// suggest keys for what a user has typed so far. The indexed text is
+// normalized (ASCII lowercase, whitespace collapsed) and every word start
+// begins a term running to the end of the text, so "ali" and "alice s" both
+// reach "Alice Smith". A term is stored under each of its first
+// kMaxCompletionPrefix code points:
+//   idx: | tuple(name, prefix, -score, key, term)
+// with an empty value. The entries of one prefix are ordered best first, so
+// a completion reads about as many entries as it returns however large the
+// index grows. Longer input reads the entries of its first
+// kMaxCompletionPrefix code points and keeps the terms it starts.
+
+#ifndef LEVELDB_COMPLETION_H
+#define LEVELDB_COMPLETION_H
+
+#include <string>
+#include <vector>
+#include "SecondaryIndex.h"
+
+const size_t kMaxCompletionPrefix = 8;
+// Terms are cut to this many bytes (on a code point boundary).
+const size_t kMaxCompletionTermBytes = 64;
+// Word starts indexed per value; later ones are not completed.
+const size_t kMaxCompletionTerms = 32;
+
+struct CompletionMatch {
+    std::string key;
+    // The normalized term the input completed to.
+    std::string term;
+    double score = 0;
+};
+
+std::string NormalizeCompletionText(const std::string &text);
+// Entry keys for a value, sorted and without duplicates. The text is the
+// field (a string or an array of strings); the score is read from
+// spec.scoreField and is 0 when it is missing or not a number.
+void ExtractCompletionEntries(const IndexSpec &spec, const std::string &value, const std::string &key,
+                              std::vector<std::string> &entries);
+// The entries holding the completions of normalized input start with the
+// section; terms must additionally start with input when it is longer than
+// kMaxCompletionPrefix code points.
+std::string CompletionSection(const std::string &name, const std::string &input);
+bool DecodeCompletionEntry(const leveldb::Slice &entry, size_t sectionSize, CompletionMatch &match);
+
+#endif // LEVELDB_COMPLETION_H
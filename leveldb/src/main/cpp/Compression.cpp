@@ -0,0 +1,245 @@
+#include "Compression.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+static const size_t kMinMatch = 4;
+static const int kHashBits = 13;
+static const uint32_t kNoPosition = UINT32_MAX;
+// Dictionary training: substrings of kGramSize bytes are counted, and
+// segments of kSegmentSize bytes starting every kSegmentStep bytes compete
+// for a place in the dictionary.
+static const size_t kGramSize = 8;
+static const size_t kSegmentSize = 64;
+static const size_t kSegmentStep = 16;
+
+static inline uint32_t Load32(const char *ptr) {
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static inline uint64_t Load64(const char *ptr) {
+    uint64_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static inline uint32_t HashOf(uint32_t value) {
+    return (value * 2654435761u) >> (32 - kHashBits);
+}
+
+static void PutLength(std::string &output, size_t length) {
+    while (length >= 255) {
+        output.push_back('\xff');
+        length -= 255;
+    }
+    output.push_back(static_cast<char>(length));
+}
+
+static bool GetLength(const uint8_t *&ptr, const uint8_t *end, size_t &length) {
+    uint8_t byte;
+    do {
+        if (ptr == end || length > SIZE_MAX - 255) {
+            return false;
+        }
+        byte = *ptr++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// matchLength 0 writes the final, literal-only sequence.
+static void PutSequence(std::string &output, const char *literals, size_t literalLength, size_t offset,
+                        size_t matchLength) {
+    size_t matchCode = matchLength > 0 ? matchLength - kMinMatch : 0;
+    output.push_back(static_cast<char>((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchCode, 15)));
+    if (literalLength >= 15) {
+        PutLength(output, literalLength - 15);
+    }
+    output.append(literals, literalLength);
+    if (matchLength == 0) {
+        return;
+    }
+    output.push_back(static_cast<char>(offset & 0xff));
+    output.push_back(static_cast<char>(offset >> 8));
+    if (matchCode >= 15) {
+        PutLength(output, matchCode - 15);
+    }
+}
+
+void LzCompress(const leveldb::Slice &input, const std::string &dictionary, std::string &output) {
+    // Matches are searched in dictionary + input as one buffer.
+    std::string joined;
+    const char *base = input.data();
+    size_t start = 0;
+    if (!dictionary.empty()) {
+        joined.reserve(dictionary.size() + input.size());
+        joined.append(dictionary);
+        joined.append(input.data(), input.size());
+        base = joined.data();
+        start = dictionary.size();
+    }
+    size_t end = start + input.size();
+    std::vector<uint32_t> table(1 << kHashBits, kNoPosition);
+    for (size_t i = start > kLzWindowSize ? start - kLzWindowSize : 0; i + kMinMatch <= start; i++) {
+        table[HashOf(Load32(base + i))] = static_cast<uint32_t>(i);
+    }
+
+    size_t anchor = start;
+    size_t i = start;
+    while (i + kMinMatch <= end) {
+        uint32_t word = Load32(base + i);
+        uint32_t &slot = table[HashOf(word)];
+        uint32_t candidate = slot;
+        slot = static_cast<uint32_t>(i);
+        if (candidate == kNoPosition || i - candidate > kLzWindowSize || Load32(base + candidate) != word) {
+            i++;
+            continue;
+        }
+        size_t length = kMinMatch;
+        while (i + length < end && base[candidate + length] == base[i + length]) {
+            length++;
+        }
+        PutSequence(output, base + anchor, i - anchor, i - candidate, length);
+        i += length;
+        anchor = i;
+        if (i >= 2 && i - 2 + kMinMatch <= end) {
+            table[HashOf(Load32(base + i - 2))] = static_cast<uint32_t>(i - 2);
+        }
+    }
+    PutSequence(output, base + anchor, end - anchor, 0, 0);
+}
+
+bool LzDecompress(const leveldb::Slice &input, const std::string &dictionary, size_t rawLength,
+                  std::string &output) {
+    // Offsets may reach into the dictionary, which sits right before the value.
+    std::string window;
+    window.reserve(dictionary.size() + rawLength);
+    window.append(dictionary);
+    size_t limit = dictionary.size() + rawLength;
+    const uint8_t *ptr = reinterpret_cast<const uint8_t *>(input.data());
+    const uint8_t *end = ptr + input.size();
+    while (ptr < end) {
+        uint8_t token = *ptr++;
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !GetLength(ptr, end, literalLength)) {
+            return false;
+        }
+        if (static_cast<size_t>(end - ptr) < literalLength || literalLength > limit - window.size()) {
+            return false;
+        }
+        window.append(reinterpret_cast<const char *>(ptr), literalLength);
+        ptr += literalLength;
+        if (ptr == end) {
+            break;
+        }
+        if (end - ptr < 2) {
+            return false;
+        }
+        size_t offset = ptr[0] | (static_cast<size_t>(ptr[1]) << 8);
+        ptr += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !GetLength(ptr, end, matchLength)) {
+            return false;
+        }
+        matchLength += kMinMatch;
+        if (offset == 0 || offset > window.size() || matchLength > limit - window.size()) {
+            return false;
+        }
+        size_t at = window.size();
+        size_t from = at - offset;
+        window.resize(at + matchLength);
+        if (offset >= matchLength) {
+            memcpy(&window[at], &window[from], matchLength);
+        } else {
+            // Overlapping copy repeats the last "offset" bytes.
+            for (size_t k = 0; k < matchLength; k++) {
+                window[at + k] = window[from + k];
+            }
+        }
+    }
+    if (window.size() != limit) {
+        return false;
+    }
+    output.append(window, dictionary.size(), rawLength);
+    return true;
+}
+
+std::string TrainDictionary(const std::vector<std::string> &samples, size_t maxSize) {
+    maxSize = std::min(maxSize, kMaxDictionarySize);
+    // In how many samples each substring occurs.
+    std::unordered_map<uint64_t, uint32_t> frequency;
+    for (const auto& sample : samples) {
+        std::unordered_set<uint64_t> seen;
+        for (size_t i = 0; i + kGramSize <= sample.size(); i++) {
+            seen.insert(Load64(sample.data() + i));
+        }
+        for (uint64_t gram : seen) {
+            frequency[gram]++;
+        }
+    }
+    auto shared = [&frequency](uint64_t gram) {
+        auto it = frequency.find(gram);
+        return it != frequency.end() && it->second >= 2 ? it->second : 0;
+    };
+
+    struct Segment {
+        uint64_t score;
+        size_t sample;
+        size_t offset;
+        size_t length;
+    };
+    std::vector<Segment> segments;
+    for (size_t s = 0; s < samples.size(); s++) {
+        const std::string &sample = samples[s];
+        for (size_t offset = 0; offset + kGramSize <= sample.size(); offset += kSegmentStep) {
+            size_t length = std::min(kSegmentSize, sample.size() - offset);
+            uint64_t score = 0;
+            for (size_t i = offset; i + kGramSize <= offset + length; i++) {
+                score += shared(Load64(sample.data() + i));
+            }
+            if (score > 0) {
+                segments.push_back({score, s, offset, length});
+            }
+        }
+    }
+    std::stable_sort(segments.begin(), segments.end(),
+                     [](const Segment &a, const Segment &b) { return a.score > b.score; });
+
+    // Segments that mostly repeat what is already in the dictionary are skipped.
+    std::unordered_set<uint64_t> covered;
+    std::vector<const Segment *> chosen;
+    size_t total = 0;
+    for (const auto& segment : segments) {
+        if (total + segment.length > maxSize) {
+            continue;
+        }
+        const char *data = samples[segment.sample].data() + segment.offset;
+        size_t grams = segment.length - kGramSize + 1;
+        size_t fresh = 0;
+        for (size_t i = 0; i < grams; i++) {
+            uint64_t gram = Load64(data + i);
+            fresh += shared(gram) > 0 && covered.count(gram) == 0;
+        }
+        if (fresh * 2 < grams) {
+            continue;
+        }
+        for (size_t i = 0; i < grams; i++) {
+            covered.insert(Load64(data + i));
+        }
+        chosen.push_back(&segment);
+        total += segment.length;
+        if (maxSize - total < kGramSize) {
+            break;
+        }
+    }
+    // The best segments go last, right in front of the data.
+    std::string dictionary;
+    dictionary.reserve(total);
+    for (auto it = chosen.rbegin(); it != chosen.rend(); ++it) {
+        dictionary.append(samples[(*it)->sample], (*it)->offset, (*it)->length);
+    }
+    return dictionary;
+}
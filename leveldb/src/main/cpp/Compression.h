@@ -0,0 +1,42 @@
+//
+// Created on 2026/10/19.
+//
+// Value compression done by the wrapper, because the bundled leveldb has no
+// snappy linked in and stores blocks raw. The codec is a small LZ77 in the
+// style of LZ4: sequences of
+//   token | [literal length bytes] | literals | offset (2 bytes LE) | [match length bytes]
+// where the token holds the literal length in its high nibble and the match
+// length minus 4 in its low one (15 means more length bytes follow, each
+// adding up to 255). The last sequence has literals only.
+//
+// A dictionary is a preset window in front of the input, so the first bytes
+// of a small value can already refer to common strings. Dictionaries are
+// trained from sample values by picking the segments whose 8-byte substrings
+// occur in the most samples.
+
+#ifndef LEVELDB_COMPRESSION_H
+#define LEVELDB_COMPRESSION_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <leveldb/slice.h>
+
+enum ValueCompression : uint8_t {
+    kCompressionNone = 0,
+    kCompressionLz = 1,
+};
+
+// Matches reach back at most this far, across the dictionary and the input.
+const size_t kLzWindowSize = 65535;
+const size_t kMaxDictionarySize = 32 << 10;
+
+void LzCompress(const leveldb::Slice &input, const std::string &dictionary, std::string &output);
+// Appends exactly rawLength bytes to output; false on malformed input.
+bool LzDecompress(const leveldb::Slice &input, const std::string &dictionary, size_t rawLength,
+                  std::string &output);
+
+// Empty if the samples share nothing worth keeping.
+std::string TrainDictionary(const std::vector<std::string> &samples, size_t maxSize);
+
+#endif // LEVELDB_COMPRESSION_H
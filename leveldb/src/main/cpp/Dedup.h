@@ -0,0 +1,26 @@
+//
+// Created on 2026/10/19.
+//
+// Content-addressed storage of repeated values:
+//   cas:  | sha256 -> envelope of the shared payload (may itself be
+//                     compressed or separated into a blob file)
+//   casr: | sha256 -> fixed64 number of user keys referring to it
+// A user key holding a shared value stores the 32-byte hash with
+// kValueFlagShared set. Reference counts change in the batch of the write
+// that adds or drops the reference; the payload goes with the last one.
+
+#ifndef LEVELDB_DEDUP_H
+#define LEVELDB_DEDUP_H
+
+#include <string>
+#include <leveldb/slice.h>
+
+const size_t kContentHashSize = 32;
+
+// SHA-256, so equal hashes can be taken for equal content.
+std::string ContentHash(const leveldb::Slice &value);
+std::string SharedContentKey(const leveldb::Slice &hash);
+std::string SharedRefPrefix();
+std::string SharedRefKey(const leveldb::Slice &hash);
+
+#endif // LEVELDB_DEDUP_H
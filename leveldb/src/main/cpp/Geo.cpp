@@ -0,0 +1,264 @@
+#include "Geo.h"
+#include "Coding.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const std::string kGeoPointPrefix = InternalKey("geo:");
+static const std::string kGeoCellPrefix = InternalKey("geoc:");
+static const double kDegreesToRadians = M_PI / 180.0;
+
+static uint32_t Quantize(double value, double min, double span) {
+    double scaled = (value - min) / span * 4294967296.0;
+    if (scaled <= 0) {
+        return 0;
+    }
+    return scaled >= 4294967295.0 ? UINT32_MAX : static_cast<uint32_t>(scaled);
+}
+
+static uint32_t QuantizeLat(double lat) {
+    return Quantize(lat, -90.0, 180.0);
+}
+
+static uint32_t QuantizeLon(double lon) {
+    return Quantize(lon, -180.0, 360.0);
+}
+
+// Moves bit i of value to bit 2i.
+static uint64_t SpreadBits(uint32_t value) {
+    uint64_t x = value;
+    x = (x | (x << 16)) & 0x0000ffff0000ffffULL;
+    x = (x | (x << 8)) & 0x00ff00ff00ff00ffULL;
+    x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    x = (x | (x << 2)) & 0x3333333333333333ULL;
+    x = (x | (x << 1)) & 0x5555555555555555ULL;
+    return x;
+}
+
+static void PutDouble(std::string &dst, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    PutFixed64BE(dst, bits);
+}
+
+static double LoadDouble(const char *ptr) {
+    uint64_t bits = DecodeFixed64BE(ptr);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+bool IsValidGeoPoint(double lat, double lon) {
+    return lat >= -90.0 && lat <= 90.0 && lon >= -180.0 && lon <= 180.0;
+}
+
+bool IsValidGeoBox(const GeoBox &box) {
+    return IsValidGeoPoint(box.minLat, box.minLon) && IsValidGeoPoint(box.maxLat, box.maxLon) &&
+           box.minLat <= box.maxLat;
+}
+
+uint64_t GeoCell(double lat, double lon) {
+    return (SpreadBits(QuantizeLon(lon)) << 1) | SpreadBits(QuantizeLat(lat));
+}
+
+double GeoDistance(double lat1, double lon1, double lat2, double lon2) {
+    double sinLat = std::sin((lat2 - lat1) * kDegreesToRadians / 2);
+    double sinLon = std::sin((lon2 - lon1) * kDegreesToRadians / 2);
+    double a = sinLat * sinLat +
+               std::cos(lat1 * kDegreesToRadians) * std::cos(lat2 * kDegreesToRadians) * sinLon * sinLon;
+    return 2 * kEarthRadiusMeters * std::asin(std::min(1.0, std::sqrt(a)));
+}
+
+std::string GeoPointKey(const std::string &key) {
+    return kGeoPointPrefix + key;
+}
+
+std::string GeoCellPrefix() {
+    return kGeoCellPrefix;
+}
+
+std::string GeoCellKey(uint64_t cell, const std::string &key) {
+    std::string entry = kGeoCellPrefix;
+    PutFixed64BE(entry, cell);
+    entry.append(key);
+    return entry;
+}
+
+bool DecodeGeoCellKey(const leveldb::Slice &entry, uint64_t &cell, leveldb::Slice &key) {
+    if (!entry.starts_with(kGeoCellPrefix) || entry.size() < kGeoCellPrefix.size() + 8) {
+        return false;
+    }
+    cell = DecodeFixed64BE(entry.data() + kGeoCellPrefix.size());
+    key = leveldb::Slice(entry.data() + kGeoCellPrefix.size() + 8, entry.size() - kGeoCellPrefix.size() - 8);
+    return true;
+}
+
+std::string EncodeGeoPoint(double lat, double lon) {
+    std::string value;
+    PutDouble(value, lat);
+    PutDouble(value, lon);
+    return value;
+}
+
+bool DecodeGeoPoint(const leveldb::Slice &value, double &lat, double &lon) {
+    if (value.size() != 16) {
+        return false;
+    }
+    lat = LoadDouble(value.data());
+    lon = LoadDouble(value.data() + 8);
+    return true;
+}
+
+std::vector<GeoBox> SplitGeoBox(const GeoBox &box) {
+    if (box.minLon <= box.maxLon) {
+        return {box};
+    }
+    GeoBox east = box;
+    east.maxLon = 180.0;
+    GeoBox west = box;
+    west.minLon = -180.0;
+    return {east, west};
+}
+
+std::vector<GeoBox> GeoBoxesAround(double lat, double lon, double radiusMeters) {
+    double angle = radiusMeters / kEarthRadiusMeters;
+    double deltaLat = angle / kDegreesToRadians;
+    GeoBox box;
+    box.minLat = lat - deltaLat;
+    box.maxLat = lat + deltaLat;
+    box.minLon = -180.0;
+    box.maxLon = 180.0;
+    if (box.minLat <= -90.0 || box.maxLat >= 90.0) {
+        box.minLat = std::max(box.minLat, -90.0);
+        box.maxLat = std::min(box.maxLat, 90.0);
+        return {box};
+    }
+    // The widest point of the circle is not on its center's latitude, so the
+    // longitude span comes from the tangent meridians.
+    double ratio = std::sin(angle) / std::cos(lat * kDegreesToRadians);
+    if (ratio >= 1.0) {
+        return {box};
+    }
+    double deltaLon = std::asin(ratio) / kDegreesToRadians;
+    box.minLon = lon - deltaLon;
+    box.maxLon = lon + deltaLon;
+    if (box.minLon < -180.0) {
+        box.minLon += 360.0;
+    } else if (box.maxLon > 180.0) {
+        box.maxLon -= 360.0;
+    }
+    return SplitGeoBox(box);
+}
+
+bool GeoBoxesContain(const std::vector<GeoBox> &boxes, double lat, double lon) {
+    for (const auto& box : boxes) {
+        if (lat >= box.minLat && lat <= box.maxLat && lon >= box.minLon && lon <= box.maxLon) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A quadtree node: the cells whose top 2 * level bits interleave x and y.
+struct GeoNode {
+    int level;
+    uint32_t x;
+    uint32_t y;
+};
+
+// Inclusive bounds in quantized coordinates.
+struct GeoQuantizedBox {
+    uint64_t x0;
+    uint64_t x1;
+    uint64_t y0;
+    uint64_t y1;
+};
+
+static GeoCellRange NodeRange(const GeoNode &node) {
+    GeoCellRange range;
+    if (node.level == 0) {
+        range.first = 0;
+        range.last = UINT64_MAX;
+        return range;
+    }
+    int shift = 64 - 2 * node.level;
+    range.first = ((SpreadBits(node.x) << 1) | SpreadBits(node.y)) << shift;
+    range.last = range.first + ((uint64_t(1) << shift) - 1);
+    return range;
+}
+
+std::vector<GeoCellRange> CoverGeoBoxes(const std::vector<GeoBox> &boxes, size_t maxRanges) {
+    std::vector<GeoQuantizedBox> quantized;
+    for (const auto& box : boxes) {
+        quantized.push_back({QuantizeLon(box.minLon), QuantizeLon(box.maxLon), QuantizeLat(box.minLat),
+                             QuantizeLat(box.maxLat)});
+    }
+    // 0: outside every box, 1: overlaps one, 2: inside one.
+    auto classify = [&quantized](const GeoNode &node) {
+        int shift = 32 - node.level;
+        uint64_t x0 = uint64_t(node.x) << shift;
+        uint64_t x1 = ((uint64_t(node.x) + 1) << shift) - 1;
+        uint64_t y0 = uint64_t(node.y) << shift;
+        uint64_t y1 = ((uint64_t(node.y) + 1) << shift) - 1;
+        int result = 0;
+        for (const auto& box : quantized) {
+            if (x0 >= box.x0 && x1 <= box.x1 && y0 >= box.y0 && y1 <= box.y1) {
+                return 2;
+            }
+            if (x0 <= box.x1 && x1 >= box.x0 && y0 <= box.y1 && y1 >= box.y0) {
+                result = 1;
+            }
+        }
+        return result;
+    };
+
+    std::vector<GeoCellRange> ranges;
+    std::vector<GeoNode> partial;
+    GeoNode root = {0, 0, 0};
+    int rootClass = classify(root);
+    if (rootClass == 2) {
+        ranges.push_back(NodeRange(root));
+    } else if (rootClass == 1) {
+        partial.push_back(root);
+    }
+    // Nodes on the boundary are split one level at a time while the ranges
+    // still fit; the last boundary nodes are then scanned whole.
+    while (!partial.empty()) {
+        std::vector<GeoCellRange> inside;
+        std::vector<GeoNode> next;
+        bool deepest = partial[0].level == 32;
+        if (!deepest) {
+            for (const auto& node : partial) {
+                for (uint32_t quadrant = 0; quadrant < 4; quadrant++) {
+                    GeoNode child = {node.level + 1, node.x * 2 + (quadrant >> 1), node.y * 2 + (quadrant & 1)};
+                    int childClass = classify(child);
+                    if (childClass == 2) {
+                        inside.push_back(NodeRange(child));
+                    } else if (childClass == 1) {
+                        next.push_back(child);
+                    }
+                }
+            }
+        }
+        if (deepest || ranges.size() + inside.size() + next.size() > maxRanges) {
+            for (const auto& node : partial) {
+                ranges.push_back(NodeRange(node));
+            }
+            break;
+        }
+        ranges.insert(ranges.end(), inside.begin(), inside.end());
+        partial.swap(next);
+    }
+
+    std::sort(ranges.begin(), ranges.end(),
+              [](const GeoCellRange &a, const GeoCellRange &b) { return a.first < b.first; });
+    std::vector<GeoCellRange> merged;
+    for (const auto& range : ranges) {
+        if (!merged.empty() && (merged.back().last == UINT64_MAX || range.first <= merged.back().last + 1)) {
+            merged.back().last = std::max(merged.back().last, range.last);
+        } else {
+            merged.push_back(range);
+        }
+    }
+    return merged;
+}
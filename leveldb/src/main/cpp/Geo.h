@@ -0,0 +1,77 @@
+//
+// Created on 2026/10/19.
+//
+// Points stored next to the key space and indexed by a Z-order cell:
+//   geo:  | key                     -> double lat | double lon
+//   geoc: | fixed64BE cell | key    -> double lat | double lon
+// Latitude and longitude are each quantized to 32 bits and interleaved into
+// the 64-bit cell (longitude bit first), so the cells of one quadtree node
+// are one contiguous key range. A query covers its bounding box with a few
+// such ranges, scans them and keeps the points that really match. Doubles
+// are stored as big-endian IEEE bits.
+
+#ifndef LEVELDB_GEO_H
+#define LEVELDB_GEO_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <leveldb/slice.h>
+
+const double kEarthRadiusMeters = 6371008.8;
+// Upper bound on the cell ranges one query scans; coarser ranges read more
+// points that the exact test then drops.
+const size_t kMaxGeoCoverRanges = 16;
+
+// minLon > maxLon selects a box that crosses the antimeridian.
+struct GeoBox {
+    double minLat = 0;
+    double minLon = 0;
+    double maxLat = 0;
+    double maxLon = 0;
+};
+
+struct GeoQueryOptions {
+    // Only points whose key starts with prefix.
+    std::string prefix;
+    // 0 returns every match.
+    size_t limit = 0;
+};
+
+struct GeoMatch {
+    std::string key;
+    double lat = 0;
+    double lon = 0;
+    // Meters from the center of a radius query; 0 for box queries.
+    double distance = 0;
+};
+
+// Inclusive range of cells.
+struct GeoCellRange {
+    uint64_t first = 0;
+    uint64_t last = 0;
+};
+
+bool IsValidGeoPoint(double lat, double lon);
+bool IsValidGeoBox(const GeoBox &box);
+uint64_t GeoCell(double lat, double lon);
+// Great-circle distance in meters.
+double GeoDistance(double lat1, double lon1, double lat2, double lon2);
+
+std::string GeoPointKey(const std::string &key);
+std::string GeoCellPrefix();
+std::string GeoCellKey(uint64_t cell, const std::string &key);
+bool DecodeGeoCellKey(const leveldb::Slice &entry, uint64_t &cell, leveldb::Slice &key);
+std::string EncodeGeoPoint(double lat, double lon);
+bool DecodeGeoPoint(const leveldb::Slice &value, double &lat, double &lon);
+
+// Splits a box crossing the antimeridian in two.
+std::vector<GeoBox> SplitGeoBox(const GeoBox &box);
+// Boxes bounding the circle of radiusMeters around a point, split at the
+// antimeridian; a circle reaching a pole takes every longitude.
+std::vector<GeoBox> GeoBoxesAround(double lat, double lon, double radiusMeters);
+bool GeoBoxesContain(const std::vector<GeoBox> &boxes, double lat, double lon);
+// Sorted, disjoint cell ranges covering the boxes, at most maxRanges of them.
+std::vector<GeoCellRange> CoverGeoBoxes(const std::vector<GeoBox> &boxes, size_t maxRanges);
+
+#endif // LEVELDB_GEO_H
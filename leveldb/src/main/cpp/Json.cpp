@@ -0,0 +1,338 @@
+#include "Json.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// Deep enough for any record we store, shallow enough to keep the recursion
+// off the end of a worker's stack.
+static const int kMaxJsonDepth = 64;
+
+class JsonParser {
+public:
+    explicit JsonParser(const leveldb::Slice &text) : _p(text.data()), _limit(text.data() + text.size()) {}
+
+    bool Parse(JsonValue &value) {
+        if (!ParseValue(value, 0)) {
+            return false;
+        }
+        SkipSpace();
+        return _p == _limit;
+    }
+
+private:
+    const char *_p;
+    const char *_limit;
+
+    void SkipSpace() {
+        while (_p < _limit && (*_p == ' ' || *_p == '\t' || *_p == '\n' || *_p == '\r')) {
+            _p++;
+        }
+    }
+
+    bool Consume(const char *literal) {
+        const char *p = _p;
+        for (; *literal; literal++, p++) {
+            if (p == _limit || *p != *literal) {
+                return false;
+            }
+        }
+        _p = p;
+        return true;
+    }
+
+    bool ParseValue(JsonValue &value, int depth) {
+        if (depth > kMaxJsonDepth) {
+            return false;
+        }
+        SkipSpace();
+        if (_p == _limit) {
+            return false;
+        }
+        switch (*_p) {
+            case '{':
+                return ParseObject(value, depth);
+            case '[':
+                return ParseArray(value, depth);
+            case '"':
+                value.type = JsonValue::kString;
+                return ParseString(value.text);
+            case 't':
+                value.type = JsonValue::kBool;
+                value.boolean = true;
+                return Consume("true");
+            case 'f':
+                value.type = JsonValue::kBool;
+                return Consume("false");
+            case 'n':
+                value.type = JsonValue::kNull;
+                return Consume("null");
+            default:
+                return ParseNumber(value);
+        }
+    }
+
+    bool ParseObject(JsonValue &value, int depth) {
+        value.type = JsonValue::kObject;
+        _p++;
+        SkipSpace();
+        if (_p < _limit && *_p == '}') {
+            _p++;
+            return true;
+        }
+        for (;;) {
+            SkipSpace();
+            std::pair<std::string, JsonValue> member;
+            if (_p == _limit || *_p != '"' || !ParseString(member.first)) {
+                return false;
+            }
+            SkipSpace();
+            if (_p == _limit || *_p++ != ':' || !ParseValue(member.second, depth + 1)) {
+                return false;
+            }
+            value.members.push_back(std::move(member));
+            SkipSpace();
+            if (_p == _limit) {
+                return false;
+            }
+            char c = *_p++;
+            if (c == '}') {
+                return true;
+            } else if (c != ',') {
+                return false;
+            }
+        }
+    }
+
+    bool ParseArray(JsonValue &value, int depth) {
+        value.type = JsonValue::kArray;
+        _p++;
+        SkipSpace();
+        if (_p < _limit && *_p == ']') {
+            _p++;
+            return true;
+        }
+        for (;;) {
+            JsonValue item;
+            if (!ParseValue(item, depth + 1)) {
+                return false;
+            }
+            value.items.push_back(std::move(item));
+            SkipSpace();
+            if (_p == _limit) {
+                return false;
+            }
+            char c = *_p++;
+            if (c == ']') {
+                return true;
+            } else if (c != ',') {
+                return false;
+            }
+        }
+    }
+
+    bool ParseHex4(uint32_t &code) {
+        if (_limit - _p < 4) {
+            return false;
+        }
+        code = 0;
+        for (int i = 0; i < 4; i++) {
+            char c = *_p++;
+            code <<= 4;
+            if (c >= '0' && c <= '9') {
+                code |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                code |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                code |= c - 'A' + 10;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void AppendUtf8(std::string &out, uint32_t code) {
+        if (code < 0x80) {
+            out.push_back(static_cast<char>(code));
+        } else if (code < 0x800) {
+            out.push_back(static_cast<char>(0xc0 | (code >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+        } else if (code < 0x10000) {
+            out.push_back(static_cast<char>(0xe0 | (code >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+        } else {
+            out.push_back(static_cast<char>(0xf0 | (code >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3f)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+        }
+    }
+
+    bool ParseString(std::string &out) {
+        _p++;
+        while (_p < _limit) {
+            char c = *_p++;
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                out.push_back(c);
+                continue;
+            }
+            if (_p == _limit) {
+                return false;
+            }
+            c = *_p++;
+            switch (c) {
+                case '"': out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/': out.push_back('/'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'n': out.push_back('\n'); break;
+                case 'r': out.push_back('\r'); break;
+                case 't': out.push_back('\t'); break;
+                case 'u': {
+                    uint32_t code;
+                    if (!ParseHex4(code)) {
+                        return false;
+                    }
+                    if (code >= 0xd800 && code < 0xdc00 && Consume("\\u")) {
+                        uint32_t low;
+                        if (!ParseHex4(low) || low < 0xdc00 || low >= 0xe000) {
+                            return false;
+                        }
+                        code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                    }
+                    AppendUtf8(out, code);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return false;
+    }
+
+    bool ParseNumber(JsonValue &value) {
+        const char *start = _p;
+        if (_p < _limit && *_p == '-') {
+            _p++;
+        }
+        while (_p < _limit && ((*_p >= '0' && *_p <= '9') || *_p == '.' || *_p == 'e' || *_p == 'E' ||
+                               *_p == '+' || *_p == '-')) {
+            _p++;
+        }
+        value.type = JsonValue::kNumber;
+        value.text.assign(start, _p - start);
+        if (value.text.empty()) {
+            return false;
+        }
+        char *end = nullptr;
+        value.number = strtod(value.text.c_str(), &end);
+        return *end == '\0';
+    }
+};
+
+const JsonValue *JsonValue::Find(const std::string &name) const {
+    for (const auto& member : members) {
+        if (member.first == name) {
+            return &member.second;
+        }
+    }
+    return nullptr;
+}
+
+const JsonValue *JsonValue::FindPath(const std::string &path) const {
+    const JsonValue *value = this;
+    size_t begin = 0;
+    while (value != nullptr && begin < path.size()) {
+        size_t end = path.find('.', begin);
+        if (end == std::string::npos) {
+            end = path.size();
+        }
+        value = value->type == kObject ? value->Find(path.substr(begin, end - begin)) : nullptr;
+        begin = end + 1;
+    }
+    return value;
+}
+
+bool ParseJson(const leveldb::Slice &text, JsonValue &value) {
+    value = JsonValue();
+    return JsonParser(text).Parse(value);
+}
+
+std::string JsonQuote(const std::string &value) {
+    std::string quoted = "\"";
+    for (unsigned char c : value) {
+        switch (c) {
+            case '"': quoted += "\\\""; break;
+            case '\\': quoted += "\\\\"; break;
+            case '\n': quoted += "\\n"; break;
+            case '\r': quoted += "\\r"; break;
+            case '\t': quoted += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    quoted += buf;
+                } else {
+                    quoted.push_back(static_cast<char>(c));
+                }
+        }
+    }
+    quoted.push_back('"');
+    return quoted;
+}
+
+void AppendJson(std::string &dst, const JsonValue &value) {
+    switch (value.type) {
+        case JsonValue::kNull:
+            dst += "null";
+            break;
+        case JsonValue::kBool:
+            dst += value.boolean ? "true" : "false";
+            break;
+        case JsonValue::kNumber:
+            if (!value.text.empty()) {
+                dst += value.text;
+            } else if (std::isfinite(value.number)) {
+                // Shortest of the two forms that reads back as the same double.
+                char buf[32];
+                snprintf(buf, sizeof(buf), "%.15g", value.number);
+                if (strtod(buf, nullptr) != value.number) {
+                    snprintf(buf, sizeof(buf), "%.17g", value.number);
+                }
+                dst += buf;
+            } else {
+                dst += "null";
+            }
+            break;
+        case JsonValue::kString:
+            dst += JsonQuote(value.text);
+            break;
+        case JsonValue::kArray:
+            dst.push_back('[');
+            for (size_t i = 0; i < value.items.size(); i++) {
+                if (i > 0) {
+                    dst.push_back(',');
+                }
+                AppendJson(dst, value.items[i]);
+            }
+            dst.push_back(']');
+            break;
+        case JsonValue::kObject:
+            dst.push_back('{');
+            for (size_t i = 0; i < value.members.size(); i++) {
+                if (i > 0) {
+                    dst.push_back(',');
+                }
+                dst += JsonQuote(value.members[i].first);
+                dst.push_back(':');
+                AppendJson(dst, value.members[i].second);
+            }
+            dst.push_back('}');
+            break;
+    }
+}
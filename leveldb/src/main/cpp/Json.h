@@ -0,0 +1,38 @@
+//
+// Created on 2026/10/19.
+//
+// Minimal JSON support for looking into stored values (index fields, ...).
+// Values are kept as a small DOM; numbers also keep their literal so int64
+// fields survive without a round trip through double.
+
+#ifndef LEVELDB_JSON_H
+#define LEVELDB_JSON_H
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <leveldb/slice.h>
+
+struct JsonValue {
+    enum Type { kNull, kBool, kNumber, kString, kArray, kObject };
+
+    Type type = kNull;
+    bool boolean = false;
+    double number = 0;
+    // String contents, or the literal of a number.
+    std::string text;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    const JsonValue *Find(const std::string &name) const;
+    // Follows a dotted path ("address.city"); an empty path is the value itself.
+    const JsonValue *FindPath(const std::string &path) const;
+};
+
+// Returns false unless "text" is exactly one JSON value (surrounding
+// whitespace allowed).
+bool ParseJson(const leveldb::Slice &text, JsonValue &value);
+std::string JsonQuote(const std::string &value);
+void AppendJson(std::string &dst, const JsonValue &value);
+
+#endif // LEVELDB_JSON_H
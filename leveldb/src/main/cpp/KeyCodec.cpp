@@ -0,0 +1,101 @@
+#include "KeyCodec.h"
+#include "Coding.h"
+#include <cstring>
+
+static const uint64_t kSignBit = 1ull << 63;
+
+static uint64_t DoubleToOrderedBits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & kSignBit) ? ~bits : bits | kSignBit;
+}
+
+static double OrderedBitsToDouble(uint64_t bits) {
+    bits = (bits & kSignBit) ? bits & ~kSignBit : ~bits;
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void EncodeKeyPart(std::string &dst, const KeyPart &part) {
+    dst.push_back(static_cast<char>(part.type));
+    switch (part.type) {
+        case kKeyPartBytes:
+        case kKeyPartString:
+            for (char c : part.bytes) {
+                dst.push_back(c);
+                if (c == '\0') {
+                    dst.push_back('\xff');
+                }
+            }
+            dst.push_back('\0');
+            break;
+        case kKeyPartInt64:
+            PutFixed64BE(dst, static_cast<uint64_t>(part.int64) ^ kSignBit);
+            break;
+        case kKeyPartUInt64:
+            PutFixed64BE(dst, part.uint64);
+            break;
+        case kKeyPartDouble:
+            PutFixed64BE(dst, DoubleToOrderedBits(part.number));
+            break;
+    }
+}
+
+std::string EncodeKeyTuple(const std::vector<KeyPart> &parts) {
+    std::string key;
+    for (const auto& part : parts) {
+        EncodeKeyPart(key, part);
+    }
+    return key;
+}
+
+bool DecodeKeyTuple(const leveldb::Slice &key, std::vector<KeyPart> &parts) {
+    parts.clear();
+    const char *p = key.data();
+    const char *limit = p + key.size();
+    while (p < limit) {
+        KeyPart part;
+        part.type = static_cast<KeyPartType>(static_cast<uint8_t>(*p++));
+        switch (part.type) {
+            case kKeyPartBytes:
+            case kKeyPartString:
+                for (;;) {
+                    if (p == limit) {
+                        return false;
+                    }
+                    char c = *p++;
+                    if (c != '\0') {
+                        part.bytes.push_back(c);
+                    } else if (p < limit && *p == '\xff') {
+                        part.bytes.push_back('\0');
+                        p++;
+                    } else {
+                        break;
+                    }
+                }
+                break;
+            case kKeyPartInt64:
+            case kKeyPartUInt64:
+            case kKeyPartDouble: {
+                if (limit - p < 8) {
+                    return false;
+                }
+                uint64_t bits = DecodeFixed64BE(p);
+                p += 8;
+                if (part.type == kKeyPartInt64) {
+                    part.int64 = static_cast<int64_t>(bits ^ kSignBit);
+                } else if (part.type == kKeyPartUInt64) {
+                    part.uint64 = bits;
+                } else {
+                    part.number = OrderedBitsToDouble(bits);
+                }
+                break;
+            }
+            default:
+                return false;
+        }
+        parts.push_back(std::move(part));
+    }
+    return true;
+}
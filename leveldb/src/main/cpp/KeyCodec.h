@@ -0,0 +1,44 @@
+//
+// Created on 2026/10/19.
+//
+// Order-preserving encoding of key tuples. Encoded keys compare under the
+// default bytewise comparator exactly like the tuples do element by element,
+// so numeric and composite keys can be range-scanned without zero padding.
+
+#ifndef LEVELDB_KEYCODEC_H
+#define LEVELDB_KEYCODEC_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <leveldb/slice.h>
+
+// Each element starts with its tag, so elements of different types order by
+// tag. No tag is 0xff, which keeps encoded keys out of the internal namespace.
+enum KeyPartType : uint8_t {
+    kKeyPartBytes = 0x01,
+    kKeyPartString = 0x02,
+    kKeyPartInt64 = 0x10,
+    kKeyPartUInt64 = 0x11,
+    kKeyPartDouble = 0x20,
+};
+
+struct KeyPart {
+    KeyPartType type = kKeyPartString;
+    std::string bytes;     // kKeyPartBytes, kKeyPartString
+    int64_t int64 = 0;     // kKeyPartInt64
+    uint64_t uint64 = 0;   // kKeyPartUInt64
+    double number = 0;     // kKeyPartDouble
+};
+
+// Strings and bytes: tag | data with 0x00 escaped as 0x00 0xff | 0x00
+// int64: tag | big-endian with the sign bit flipped
+// uint64: tag | big-endian
+// double: tag | big-endian IEEE bits, sign bit flipped for positives and all
+//         bits flipped for negatives
+void EncodeKeyPart(std::string &dst, const KeyPart &part);
+std::string EncodeKeyTuple(const std::vector<KeyPart> &parts);
+// Returns false if "key" is not a well-formed tuple.
+bool DecodeKeyTuple(const leveldb::Slice &key, std::vector<KeyPart> &parts);
+
+#endif // LEVELDB_KEYCODEC_H
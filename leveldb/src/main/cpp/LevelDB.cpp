@@ -1,28 +1,2556 @@
 #include "LevelDB.h"
+#include "Comparators.h"
+#include "Json.h"
+#include "ObjectCodec.h"
+#include "Stream.h"
+#include "VectorKernels.h"
+#include <cstdio>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
 
-LevelDB::LevelDB() : _db(nullptr) {}
+// Mirrors leveldb::config::kNumLevels, which is not part of the public headers.
+static const int kNumLevels = 7;
+// Upper bound used for size estimates of ranges without a limit. It is an
+// internal key, so it sorts last under every comparator.
+static const std::string kMaxKey = kInternalKeyPrefix + std::string(16, '\xff');
+static const int kMaxCompactionRanges = 16;
+static const size_t kMaxVectorSearchThreads = 8;
+// A quantized search rescores this many candidates per requested match.
+static const size_t kVectorRescoreFactor = 4;
+static const size_t kMaxTombstonePrefixes = 1024;
+static const size_t kIndexBackfillBatchSize = 1000;
+static const uint64_t kQueueAckBatchSize = 1000;
+static const int64_t kCacheCheckIntervalMs = 2000;
+static const size_t kCacheEvictionBatchSize = 256;
+// Eviction goes below the cap so that it does not run on every write.
+static const uint64_t kCacheLowWatermarkPercent = 90;
+static const size_t kMaxPendingAccesses = 8192;
+// Acknowledged items a queue collects before their range is compacted.
+static const uint64_t kQueueCompactionThreshold = 4096;
+static const int64_t kBlobGcIntervalMs = 5 * 60 * 1000;
+static const size_t kBlobGcBatchSize = 64;
+static const size_t kBlockCacheSize = 8 << 20;
+// leveldb::config triggers: compaction starts at 4 level-0 files, writes are
+// delayed from 8 and stopped at 12.
+static const int kL0CompactionTrigger = 4;
+static const int kL0SlowdownTrigger = 8;
+static const int kL0CriticalFiles = 10;
+static const int64_t kPressurePollMs = 200;
+static const int64_t kLatencyWindowMs = 5000;
+static const double kElevatedLatencyUs = 1000;
+static const double kHighLatencyUs = 10000;
+static const double kCriticalLatencyUs = 100000;
+static const int64_t kDefaultExpirySweepIntervalMs = 60 * 1000;
+static const size_t kDefaultExpirySweepBatchSize = 1000;
+// Expiry index: prefix | expiresAt (fixed64) | user key, so a scan from the
+// start of the prefix visits entries in expiry order.
+static const std::string kExpiryIndexPrefix = InternalKey("ttl:");
+
+static std::string ExpiryIndexKey(int64_t expiresAt, const std::string &key) {
+    std::string indexKey = kExpiryIndexPrefix;
+    PutFixed64BE(indexKey, static_cast<uint64_t>(expiresAt));
+    indexKey.append(key);
+    return indexKey;
+}
+
+static const uint32_t kDefaultMergeCollapseThreshold = 64;
+// Merge delta: prefix | key length (fixed32) | key | sequence (fixed64) ->
+// operator byte | operand. The length keeps one key's deltas contiguous and
+// apart from keys that merely share a prefix.
+static const std::string kMergePrefix = InternalKey("mrg:");
+// Compression dictionaries: prefix | fixed32 id -> dictionary bytes.
+static const std::string kDictionaryPrefix = InternalKey("dict:");
+
+static std::string MergeDeltaPrefix(const std::string &key) {
+    std::string prefix = kMergePrefix;
+    PutFixed32BE(prefix, static_cast<uint32_t>(key.size()));
+    prefix.append(key);
+    return prefix;
+}
+
+static bool ParseInt64(const std::string &text, int64_t &value) {
+    char *end = nullptr;
+    errno = 0;
+    value = strtoll(text.c_str(), &end, 10);
+    return !text.empty() && *end == '\0' && errno != ERANGE;
+}
+
+static void ApplyMerge(MergeOperator op, const leveldb::Slice &operand, bool &exists, std::string &value) {
+    int64_t base = 0;
+    int64_t delta = 0;
+    switch (op) {
+        // Like Increment, a base that is not an int64 is kept as it is, and
+        // so is one that the delta would overflow.
+        case kMergeAdd:
+            if (!ParseInt64(operand.ToString(), delta) || (exists && !ParseInt64(value, base)) ||
+                __builtin_add_overflow(base, delta, &base)) {
+                return;
+            }
+            value = std::to_string(base);
+            break;
+        case kMergeMax:
+            if (!ParseInt64(operand.ToString(), delta) || (exists && !ParseInt64(value, base))) {
+                return;
+            }
+            if (!exists || delta > base) {
+                value = std::to_string(delta);
+            }
+            break;
+        case kMergeAppend:
+            if (!exists || value.empty()) {
+                value = "[" + JsonQuote(operand.ToString()) + "]";
+            } else if (value.front() != '[' || value.back() != ']') {
+                value = "[" + JsonQuote(value) + "," + JsonQuote(operand.ToString()) + "]";
+            } else if (value == "[]") {
+                value = "[" + JsonQuote(operand.ToString()) + "]";
+            } else {
+                value.insert(value.size() - 1, "," + JsonQuote(operand.ToString()));
+            }
+            break;
+        default:
+            return;
+    }
+    exists = true;
+}
+
+// Flags that have to be undone (ResolvePayload) before a payload is readable.
+static const uint8_t kStoredValueFlags = kValueFlagBlob | kValueFlagCompressed | kValueFlagShared | kValueFlagPacked;
+
+static bool IsExpired(const ValueHeader &header, int64_t now) {
+    return (header.flags & kValueFlagExpires) && header.expiresAt <= now;
+}
+
+// Whether the raw LSM value is a blob pointer to exactly this record.
+static bool PointsAt(const std::string &raw, const BlobPointer &pointer) {
+    ValueHeader header;
+    size_t offset = DecodeValueHeader(raw, header);
+    BlobPointer current;
+    return offset != std::string::npos && (header.flags & kValueFlagBlob) &&
+           DecodeBlobPointer(leveldb::Slice(raw.data() + offset, raw.size() - offset), current) &&
+           current.file == pointer.file && current.offset == pointer.offset;
+}
+
+// Replaces an encoded object payload by its JSON text, for code that works on
+// text (merges, read-modify-write helpers, the string getters).
+static void ObjectPayloadToText(std::string &payload, ValueHeader &header) {
+    if (header.flags & kValueFlagObject) {
+        std::string json;
+        ObjectToJson(payload, json);
+        payload = std::move(json);
+        header.flags &= ~kValueFlagObject;
+    }
+}
+
+LevelDB::LevelDB()
+    : _db(nullptr), _blockCache(nullptr), _comparator(leveldb::BytewiseComparator()), _writeBufferSize(0), _compactionEpoch(0), _runningTasks(0), _closing(false), _maintenanceStop(false),
+      _idleCompactionEnabled(false), _idleCompactionIntervalMs(0), _idleCompactionMaxRanges(kMaxCompactionRanges),
+      _deviceIdle(false), _deviceCharging(false), _tombstoneTracking(false), _tombstoneThreshold(0),
+      _writeLatencyEwmaUs(0), _recentMaxLatencyUs(0), _lastPressureLevel(0), _pressurePolling(false),
+      _expirySweepActive(false), _expirySweepIntervalMs(kDefaultExpirySweepIntervalMs),
+      _expirySweepBatchSize(kDefaultExpirySweepBatchSize), _mergeSequence(0), _pendingMergeKeys(0),
+      _mergeCollapseThreshold(kDefaultMergeCollapseThreshold), _cacheMaxBytes(0), _cacheEviction(kCacheEvictLru),
+      _blobThreshold(0), _blobGcRatio(0.5), _blobGcActive(false), _compression(kCompressionNone),
+      _compressionMinBytes(0), _dedupThreshold(0), _dedupActive(false) {
+    for (auto& version : _keyVersions) {
+        version = 0;
+    }
+    _indexCount = 0;
+    _tagIndexCount = 0;
+    _accessClock = 0;
+    _streamGeneration = 0;
+}
 
 LevelDB::~LevelDB() {
     Close();
 }
 
-bool LevelDB::Open(const std::string &path) {
-    leveldb::Options options;
-    options.create_if_missing = true;
-    leveldb::Status status = leveldb::DB::Open(options, path, &_db);
-    return status.ok();
+bool LevelDB::Open(const std::string &path, const OpenOptions &openOptions, std::string *error) {
+    const leveldb::Comparator *comparator = FindComparator(openOptions.comparator);
+    if (comparator == nullptr) {
+        if (error) {
+            *error = "unknown comparator: " + openOptions.comparator;
+        }
+        return false;
+    }
+    leveldb::Options options;
+    options.create_if_missing = true;
+    options.comparator = comparator;
+    // Owned here so its charge can be told apart from memtable usage.
+    _blockCache = leveldb::NewLRUCache(kBlockCacheSize);
+    options.block_cache = _blockCache;
+    if (openOptions.compression != kCompressionNone) {
+        // Blocks of compressed values would not shrink any further.
+        options.compression = leveldb::kNoCompression;
+    }
+    _writeBufferSize = options.write_buffer_size;
+    leveldb::Status status = leveldb::DB::Open(options, path, &_db);
+    if (!status.ok()) {
+        if (error) {
+            *error = status.ToString();
+        }
+        delete _blockCache;
+        _blockCache = nullptr;
+        return false;
+    }
+    std::string blobError;
+    if (!_blobs.Open(path + "/blobs", &blobError)) {
+        if (error) {
+            *error = blobError;
+        }
+        delete _db;
+        _db = nullptr;
+        delete _blockCache;
+        _blockCache = nullptr;
+        return false;
+    }
+    _closing = false;
+    _comparator = comparator;
+    _streamGeneration = NextStreamGeneration(_db, _readOptions);
+    // Set before the sweeper can start removing keys. Counts written by an
+    // earlier session are kept up to date even with deduplication off.
+    _dedupThreshold = openOptions.dedupThreshold;
+    std::string refPrefix = SharedRefPrefix();
+    leveldb::Iterator* refs = _db->NewIterator(_readOptions);
+    refs->Seek(refPrefix);
+    _dedupActive = _dedupThreshold > 0 || (refs->Valid() && refs->key().starts_with(refPrefix));
+    delete refs;
+
+    leveldb::Iterator* it = _db->NewIterator(_readOptions);
+    it->Seek(kExpiryIndexPrefix);
+    bool hasExpiringKeys = it->Valid() && it->key().starts_with(kExpiryIndexPrefix);
+    delete it;
+    if (hasExpiringKeys) {
+        ActivateExpirySweep();
+    }
+    // Resuming an index backfill reads values, which may need both.
+    LoadDictionaries();
+    LoadSchemas();
+    LoadPendingMerges();
+    LoadIndexes();
+    _compression = openOptions.compression;
+    _compressionMinBytes = openOptions.compressionMinBytes;
+    _cacheMaxBytes = openOptions.maxBytes;
+    _cacheEviction = openOptions.eviction;
+    if (_cacheMaxBytes > 0) {
+        LoadAccessOrder();
+        _nextCacheCheck = std::chrono::steady_clock::now();
+    }
+    _blobThreshold = openOptions.blobThreshold;
+    _blobGcRatio = openOptions.blobGcRatio;
+    // Files left by earlier sessions are collected even with separation off;
+    // their live values then move back into the LSM.
+    _blobGcActive = _blobThreshold > 0 || !_blobs.SealedFiles().empty();
+    if (_blobGcActive) {
+        _nextBlobGc = std::chrono::steady_clock::now() + std::chrono::milliseconds(kBlobGcIntervalMs);
+    }
+    if (!_mergeCollapseQueue.empty() || _cacheMaxBytes > 0 || _blobGcActive) {
+        EnsureMaintenanceThread();
+    }
+    return true;
+}
+
+void LevelDB::Close() {
+    if (!_db) {
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(_maintenanceMutex);
+        _closing = true;
+        _compactionEpoch++;
+        _maintenanceCond.wait(lock, [this] { return _runningTasks == 0; });
+    }
+    StopMaintenanceThread();
+    {
+        std::lock_guard<std::mutex> lock(_pressureMutex);
+        _pressureListener = nullptr;
+    }
+    delete _db;
+    _db = nullptr;
+    delete _blockCache;
+    _blockCache = nullptr;
+    _blobs.Close();
+    std::lock_guard<std::mutex> lock(_queueMutex);
+    _queues.clear();
+}
+
+bool LevelDB::Commit(leveldb::WriteBatch &batch) {
+    std::unique_lock<std::recursive_mutex> dedupLock(_dedupMutex, std::defer_lock);
+    if (_dedupActive) {
+        dedupLock.lock();
+        StageSharedRefs(batch);
+    }
+    std::unique_lock<std::mutex> tagLock(_tagMutex, std::defer_lock);
+    if (_tagIndexCount > 0) {
+        tagLock.lock();
+        StageTagContainers(batch);
+    }
+    if (_cacheMaxBytes > 0) {
+        StageAccessOrder(batch);
+    }
+    auto begin = std::chrono::steady_clock::now();
+    leveldb::Status status = _db->Write(_writeOptions, &batch);
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    RecordWriteLatency(std::chrono::duration<double, std::micro>(elapsed).count());
+    if (!status.ok()) {
+        return false;
+    }
+
+    // Versions move only after the write is visible, so a transaction that
+    // sees the same version before and after a read knows the value belongs
+    // to it; callers hold the key stripes, which commit validation also takes.
+    struct VersionBumper : public leveldb::WriteBatch::Handler {
+        LevelDB *db = nullptr;
+        void Put(const leveldb::Slice &key, const leveldb::Slice &) override { Bump(key); }
+        void Delete(const leveldb::Slice &key) override { Bump(key); }
+        void Bump(const leveldb::Slice &key) {
+            if (!IsInternalKey(key)) {
+                db->BumpKeyVersion(key.ToString());
+            }
+        }
+    } bumper;
+    bumper.db = this;
+    batch.Iterate(&bumper);
+    return true;
+}
+
+bool LevelDB::KeyLess(const std::string &a, const std::string &b) const {
+    return _comparator->Compare(a, b) < 0;
+}
+
+size_t LevelDB::KeyStripe(const std::string &key) const {
+    return std::hash<std::string>()(key) % kKeyLockStripes;
+}
+
+uint64_t LevelDB::KeyVersion(const std::string &key) const {
+    return _keyVersions[(std::hash<std::string>()(key) / kKeyLockStripes) % kKeyVersionSlots];
+}
+
+void LevelDB::BumpKeyVersion(const std::string &key) {
+    _keyVersions[(std::hash<std::string>()(key) / kKeyLockStripes) % kKeyVersionSlots]++;
+}
+
+LevelDB::KeyLockGuard::KeyLockGuard(LevelDB &db, const std::string &key) : _db(db) {
+    _stripes.push_back(db.KeyStripe(key));
+    _db._keyLocks[_stripes[0]].lock();
+}
+
+LevelDB::KeyLockGuard::KeyLockGuard(LevelDB &db, const std::vector<std::string> &keys) : _db(db) {
+    bool used[kKeyLockStripes] = {false};
+    for (const auto& key : keys) {
+        used[db.KeyStripe(key)] = true;
+    }
+    // Always in stripe order so that overlapping guards cannot deadlock.
+    for (size_t stripe = 0; stripe < kKeyLockStripes; stripe++) {
+        if (used[stripe]) {
+            _stripes.push_back(stripe);
+            _db._keyLocks[stripe].lock();
+        }
+    }
+}
+
+LevelDB::KeyLockGuard::~KeyLockGuard() {
+    for (auto it = _stripes.rbegin(); it != _stripes.rend(); ++it) {
+        _db._keyLocks[*it].unlock();
+    }
+}
+
+void LevelDB::StageValue(leveldb::WriteBatch &batch, const std::string &key, const std::string &payload,
+                         const ValueHeader &header) {
+    if (header.flags == 0) {
+        batch.Put(key, payload);
+    } else {
+        batch.Put(key, EncodeValue(header, payload));
+    }
+}
+
+bool LevelDB::StagePayload(leveldb::WriteBatch &batch, const std::string &key, const std::string &value,
+                           ValueHeader header) {
+    const std::string *payload = &value;
+    std::string compressed;
+    if (CompressValue(value, compressed)) {
+        header.flags |= kValueFlagCompressed;
+        payload = &compressed;
+    }
+    if (_blobThreshold > 0 && payload->size() >= _blobThreshold) {
+        BlobPointer pointer;
+        if (!_blobs.Append(key, *payload, pointer)) {
+            return false;
+        }
+        header.flags |= kValueFlagBlob;
+        StageValue(batch, key, EncodeBlobPointer(pointer), header);
+    } else {
+        StageValue(batch, key, *payload, header);
+    }
+    return true;
+}
+
+bool LevelDB::StageUserValue(leveldb::WriteBatch &batch, const std::string &key, const std::string &value,
+                             ValueHeader header, std::unique_lock<std::recursive_mutex> &dedupLock) {
+    if (_dedupThreshold == 0 || value.size() < _dedupThreshold) {
+        return StagePayload(batch, key, value, header);
+    }
+    std::string hash = ContentHash(value);
+    header.flags |= kValueFlagShared;
+    StageValue(batch, key, hash, header);
+    // Taken after the key stripe, in the same order as Commit().
+    if (!dedupLock.owns_lock()) {
+        dedupLock.lock();
+    }
+    std::string count;
+    return _db->Get(_readOptions, SharedRefKey(hash), &count).ok() ||
+           StagePayload(batch, SharedContentKey(hash), value, ValueHeader());
+}
+
+bool LevelDB::PutValue(const std::string &key, const std::string &value, int64_t ttlMs, uint8_t flags) {
+    ValueHeader header;
+    header.flags = flags;
+    leveldb::WriteBatch batch;
+    if (ttlMs > 0) {
+        header.flags |= kValueFlagExpires;
+        header.expiresAt = NowMs() + ttlMs;
+        batch.Put(ExpiryIndexKey(header.expiresAt, key), leveldb::Slice());
+    }
+
+    KeyLockGuard lock(*this, key);
+    std::unique_lock<std::recursive_mutex> dedupLock(_dedupMutex, std::defer_lock);
+    if (!StageUserValue(batch, key, value, header, dedupLock)) {
+        return false;
+    }
+    // Index fields are read from the document form of packed records.
+    const std::string *indexed = &value;
+    std::string unpacked;
+    ValueHeader document;
+    document.flags = flags;
+    if ((flags & kValueFlagPacked) && !IndexesFor(key).empty()) {
+        unpacked = value;
+        if (UnpackPayload(unpacked, document)) {
+            indexed = &unpacked;
+        }
+    }
+    StageIndexChange(batch, key, indexed, (document.flags & kValueFlagObject) != 0);
+    StageDropMerges(batch, key);
+    if (!Commit(batch)) {
+        return false;
+    }
+    ForgetMerges(key);
+    if (ttlMs > 0) {
+        ActivateExpirySweep();
+    }
+    return true;
+}
+
+bool LevelDB::PutObject(const std::string &key, const JsonValue &value, int64_t ttlMs) {
+    std::string encoded;
+    EncodeObject(value, encoded);
+    return PutValue(key, encoded, ttlMs, kValueFlagObject);
+}
+
+bool LevelDB::GetObject(const std::string &key, JsonValue &value) {
+    std::string payload;
+    ValueHeader header;
+    if (!ReadValue(key, payload, header, false, true)) {
+        return false;
+    }
+    RecordAccess(key);
+    if (header.flags & kValueFlagObject) {
+        return DecodeObject(payload, value);
+    }
+    if (!ParseJson(payload, value)) {
+        value = JsonValue();
+        value.type = JsonValue::kString;
+        value.text = std::move(payload);
+    }
+    return true;
+}
+
+bool LevelDB::DefineSchema(const std::string &name, const std::vector<SchemaField> &fields, std::string *error) {
+    RecordSchema schema;
+    schema.name = name;
+    schema.fields = fields;
+    if (!ValidateSchema(schema, error)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(_schemaMutex);
+    auto latest = _schemaVersions.find(name);
+    if (latest != _schemaVersions.end() && SameFields(*_schemas[latest->second], schema)) {
+        return true;
+    }
+    schema.id = _schemas.empty() ? 1 : _schemas.rbegin()->first + 1;
+    if (!_db->Put(_writeOptions, SchemaKey(schema.id), EncodeRecordSchema(schema)).ok()) {
+        if (error) {
+            *error = "failed to store schema " + name;
+        }
+        return false;
+    }
+    _schemas[schema.id] = std::make_shared<const RecordSchema>(schema);
+    _schemaVersions[name] = schema.id;
+    return true;
+}
+
+bool LevelDB::PutRecord(const std::string &key, const std::string &schemaName, const JsonValue &record, int64_t ttlMs,
+                        std::string *error) {
+    std::shared_ptr<const RecordSchema> schema;
+    {
+        std::lock_guard<std::mutex> lock(_schemaMutex);
+        auto latest = _schemaVersions.find(schemaName);
+        if (latest != _schemaVersions.end()) {
+            schema = _schemas[latest->second];
+        }
+    }
+    if (!schema) {
+        if (error) {
+            *error = "unknown schema: " + schemaName;
+        }
+        return false;
+    }
+    std::string packed;
+    return PackRecord(*schema, record, packed, error) && PutValue(key, packed, ttlMs, kValueFlagPacked);
+}
+
+bool LevelDB::GetFields(const std::string &key, const std::vector<std::string> &fields, JsonValue &record) {
+    std::string payload;
+    ValueHeader header;
+    if (!ReadValue(key, payload, header, false, true, true)) {
+        return false;
+    }
+    RecordAccess(key);
+    if ((header.flags & kValueFlagPacked) == 0) {
+        ProjectFields(fields, payload, (header.flags & kValueFlagObject) != 0, record);
+        return true;
+    }
+    std::shared_ptr<const RecordSchema> schema = PackedSchema(payload);
+    return schema && ProjectPackedRecord(*schema, payload, fields, record);
+}
+
+std::shared_ptr<const RecordSchema> LevelDB::PackedSchema(const leveldb::Slice &packed) {
+    uint32_t id = 0;
+    if (!PackedSchemaId(packed, id)) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(_schemaMutex);
+    auto it = _schemas.find(id);
+    return it == _schemas.end() ? nullptr : it->second;
+}
+
+bool LevelDB::UnpackPayload(std::string &payload, ValueHeader &header) {
+    std::shared_ptr<const RecordSchema> schema = PackedSchema(payload);
+    JsonValue record;
+    if (!schema || !UnpackRecord(*schema, payload, record)) {
+        return false;
+    }
+    std::string encoded;
+    EncodeObject(record, encoded);
+    payload = std::move(encoded);
+    header.flags = (header.flags & ~kValueFlagPacked) | kValueFlagObject;
+    return true;
+}
+
+void LevelDB::LoadSchemas() {
+    std::lock_guard<std::mutex> lock(_schemaMutex);
+    _schemas.clear();
+    _schemaVersions.clear();
+    std::string prefix = SchemaPrefix();
+    leveldb::Iterator* it = _db->NewIterator(_readOptions);
+    for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+        RecordSchema schema;
+        if (it->key().size() == prefix.size() + 4 && DecodeRecordSchema(it->value(), schema)) {
+            schema.id = DecodeFixed32BE(it->key().data() + prefix.size());
+            // Ids only grow, so the last one seen is the latest version.
+            _schemaVersions[schema.name] = schema.id;
+            _schemas[schema.id] = std::make_shared<const RecordSchema>(std::move(schema));
+        }
+    }
+    delete it;
+}
+
+bool LevelDB::ReadValue(const std::string &key, std::string &payload, ValueHeader &header, bool includeExpired,
+                        bool keepObject, bool keepPacked) {
+    std::string raw;
+    bool exists = false;
+    bool merges = HasPendingMerges(key);
+    if (_db->Get(_readOptions, key, &raw).ok()) {
+        size_t offset = DecodeValueHeader(raw, header);
+        if (offset != std::string::npos && (includeExpired || !IsExpired(header, NowMs()))) {
+            payload = offset == 0 ? std::move(raw) : raw.substr(offset);
+            exists = ResolvePayload(key, payload, header, keepPacked && !merges);
+        }
+    }
+    if (!exists) {
+        header = ValueHeader();
+    }
+    if (!keepObject || merges) {
+        ObjectPayloadToText(payload, header);
+    }
+    if (merges) {
+        exists = FoldMerges(key, exists, payload, nullptr);
+    }
+    return exists;
+}
+
+bool LevelDB::LoadBlob(const std::string &key, std::string &payload, ValueHeader &header) {
+    BlobPointer pointer;
+    if (DecodeBlobPointer(payload, pointer) && _blobs.Read(pointer, key, payload)) {
+        header.flags &= ~kValueFlagBlob;
+        return true;
+    }
+    // Garbage collection may have moved the value since the pointer was read;
+    // the LSM points at the new copy before the old file is removed.
+    std::string raw;
+    if (!_db->Get(_readOptions, key, &raw).ok()) {
+        return false;
+    }
+    size_t offset = DecodeValueHeader(raw, header);
+    if (offset == std::string::npos) {
+        return false;
+    }
+    payload = raw.substr(offset);
+    if ((header.flags & kValueFlagBlob) == 0) {
+        return true;
+    }
+    header.flags &= ~kValueFlagBlob;
+    return DecodeBlobPointer(payload, pointer) && _blobs.Read(pointer, key, payload);
+}
+
+bool LevelDB::LoadShared(const std::string &key, std::string &payload, ValueHeader &header) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        std::string raw;
+        ValueHeader content;
+        size_t offset = std::string::npos;
+        std::string contentKey = SharedContentKey(payload);
+        if (_db->Get(_readOptions, contentKey, &raw).ok()) {
+            offset = DecodeValueHeader(raw, content);
+        }
+        if (offset != std::string::npos) {
+            payload = raw.substr(offset);
+            header.flags &= ~kValueFlagShared;
+            return ResolvePayload(contentKey, payload, content);
+        }
+        // The key may have been overwritten since the hash was read, taking
+        // the last reference with it; its current value is read instead.
+        if (attempt > 0 || !_db->Get(_readOptions, key, &raw).ok()) {
+            return false;
+        }
+        offset = DecodeValueHeader(raw, header);
+        if (offset == std::string::npos) {
+            return false;
+        }
+        payload = raw.substr(offset);
+        if ((header.flags & kValueFlagShared) == 0) {
+            return ResolvePayload(key, payload, header);
+        }
+    }
+    return false;
+}
+
+bool LevelDB::ResolvePayload(const std::string &key, std::string &payload, ValueHeader &header, bool keepPacked) {
+    if (header.flags & kValueFlagShared) {
+        if (!LoadShared(key, payload, header)) {
+            return false;
+        }
+    } else if (((header.flags & kValueFlagBlob) && !LoadBlob(key, payload, header)) ||
+               ((header.flags & kValueFlagCompressed) && !DecompressValue(payload, header))) {
+        return false;
+    }
+    return keepPacked || (header.flags & kValueFlagPacked) == 0 || UnpackPayload(payload, header);
+}
+
+bool LevelDB::CompressValue(const std::string &value, std::string &compressed) {
+    if (_compression == kCompressionNone || value.size() < _compressionMinBytes) {
+        return false;
+    }
+    uint32_t dictionaryId = 0;
+    std::shared_ptr<const std::string> dictionary;
+    {
+        std::lock_guard<std::mutex> lock(_dictionaryMutex);
+        if (!_dictionaries.empty()) {
+            dictionaryId = _dictionaries.rbegin()->first;
+            dictionary = _dictionaries.rbegin()->second;
+        }
+    }
+    PutVarint64(compressed, dictionaryId);
+    PutVarint64(compressed, value.size());
+    LzCompress(value, dictionary ? *dictionary : std::string(), compressed);
+    // Plain values need no envelope, so compression has to save its two bytes.
+    return compressed.size() + 2 < value.size();
+}
+
+bool LevelDB::DecompressValue(std::string &payload, ValueHeader &header) {
+    leveldb::Slice input(payload);
+    uint64_t dictionaryId = 0;
+    uint64_t rawLength = 0;
+    if (!GetVarint64(input, dictionaryId) || !GetVarint64(input, rawLength)) {
+        return false;
+    }
+    std::shared_ptr<const std::string> dictionary;
+    if (dictionaryId != 0) {
+        std::lock_guard<std::mutex> lock(_dictionaryMutex);
+        auto it = _dictionaries.find(static_cast<uint32_t>(dictionaryId));
+        if (it == _dictionaries.end()) {
+            return false;
+        }
+        dictionary = it->second;
+    }
+    std::string value;
+    if (!LzDecompress(input, dictionary ? *dictionary : std::string(), rawLength, value)) {
+        return false;
+    }
+    payload = std::move(value);
+    header.flags &= ~kValueFlagCompressed;
+    return true;
+}
+
+void LevelDB::LoadDictionaries() {
+    std::lock_guard<std::mutex> lock(_dictionaryMutex);
+    _dictionaries.clear();
+    leveldb::Iterator* it = _db->NewIterator(_readOptions);
+    for (it->Seek(kDictionaryPrefix); it->Valid() && it->key().starts_with(kDictionaryPrefix); it->Next()) {
+        if (it->key().size() == kDictionaryPrefix.size() + 4) {
+            uint32_t id = DecodeFixed32BE(it->key().data() + kDictionaryPrefix.size());
+            _dictionaries[id] = std::make_shared<const std::string>(it->value().ToString());
+        }
+    }
+    delete it;
+}
+
+bool LevelDB::TrainCompressionDictionary(const DictionaryOptions &options, uint32_t &id, std::string *error) {
+    ScanOptions range;
+    range.prefix = options.prefix;
+    leveldb::ReadOptions readOptions = _readOptions;
+    readOptions.fill_cache = false;
+    std::vector<std::string> samples;
+    ScanEach(range, readOptions, [&](const leveldb::Slice &, const leveldb::Slice &payload, bool) {
+        samples.push_back(payload.ToString());
+        return samples.size() < options.sampleCount;
+    });
+    std::string dictionary = TrainDictionary(samples, options.maxSize);
+    if (dictionary.empty()) {
+        if (error) {
+            *error = "the sampled values have nothing in common";
+        }
+        return false;
+    }
+
+    // Dictionaries are never removed: values compressed with them may
+    // still exist anywhere in the database.
+    std::lock_guard<std::mutex> lock(_dictionaryMutex);
+    id = _dictionaries.empty() ? 1 : _dictionaries.rbegin()->first + 1;
+    std::string key = kDictionaryPrefix;
+    PutFixed32BE(key, id);
+    leveldb::WriteBatch batch;
+    batch.Put(key, dictionary);
+    if (!Commit(batch)) {
+        if (error) {
+            *error = "failed to store the dictionary";
+        }
+        return false;
+    }
+    _dictionaries[id] = std::make_shared<const std::string>(std::move(dictionary));
+    return true;
+}
+
+bool LevelDB::GetValue(const std::string &key, std::string &value) {
+    ValueHeader header;
+    if (!ReadValue(key, value, header)) {
+        return false;
+    }
+    RecordAccess(key);
+    return true;
+}
+
+bool LevelDB::Increment(const std::string &key, int64_t delta, int64_t &result) {
+    KeyLockGuard lock(*this, key);
+    std::string payload;
+    ValueHeader header;
+    int64_t current = 0;
+    if (ReadValue(key, payload, header)) {
+        char *end = nullptr;
+        errno = 0;
+        current = strtoll(payload.c_str(), &end, 10);
+        if (payload.empty() || *end != '\0' || errno == ERANGE) {
+            return false;
+        }
+    }
+    if (__builtin_add_overflow(current, delta, &result)) {
+        return false;
+    }
+    // The expiry (if any) is kept, so counters with a TTL keep their window.
+    std::string value = Serialize(result);
+    leveldb::WriteBatch batch;
+    std::unique_lock<std::recursive_mutex> dedupLock(_dedupMutex, std::defer_lock);
+    StageIndexChange(batch, key, &value);
+    if (!StageUserValue(batch, key, value, header, dedupLock)) {
+        return false;
+    }
+    StageDropMerges(batch, key);
+    if (!Commit(batch)) {
+        return false;
+    }
+    ForgetMerges(key);
+    return true;
+}
+
+bool LevelDB::CompareAndSwap(const std::string &key, const std::string *expected, const std::string &value) {
+    KeyLockGuard lock(*this, key);
+    std::string current;
+    ValueHeader header;
+    bool exists = ReadValue(key, current, header);
+    if (expected == nullptr ? exists : (!exists || current != *expected)) {
+        return false;
+    }
+    // Like Increment, the expiry (if any) is kept.
+    leveldb::WriteBatch batch;
+    std::unique_lock<std::recursive_mutex> dedupLock(_dedupMutex, std::defer_lock);
+    StageIndexChange(batch, key, &value);
+    if (!StageUserValue(batch, key, value, header, dedupLock)) {
+        return false;
+    }
+    StageDropMerges(batch, key);
+    if (!Commit(batch)) {
+        return false;
+    }
+    ForgetMerges(key);
+    return true;
+}
+
+bool LevelDB::GetAndSet(const std::string &key, const std::string &value, std::string &previous) {
+    KeyLockGuard lock(*this, key);
+    ValueHeader header;
+    bool exists = ReadValue(key, previous, header);
+    // Like Increment, the expiry (if any) is kept.
+    leveldb::WriteBatch batch;
+    std::unique_lock<std::recursive_mutex> dedupLock(_dedupMutex, std::defer_lock);
+    StageIndexChange(batch, key, &value);
+    if (!StageUserValue(batch, key, value, header, dedupLock)) {
+        return false;
+    }
+    StageDropMerges(batch, key);
+    if (!Commit(batch)) {
+        return false;
+    }
+    ForgetMerges(key);
+    return exists;
+}
+
+bool LevelDB::IsValidMergeOperand(MergeOperator op, const std::string &operand) {
+    int64_t number = 0;
+    switch (op) {
+        case kMergeAdd:
+        case kMergeMax:
+            return ParseInt64(operand, number);
+        case kMergeAppend:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool LevelDB::Merge(const std::string &key, MergeOperator op, const std::string &operand) {
+    if (!IsValidMergeOperand(op, operand)) {
+        return false;
+    }
+    bool collapse = false;
+    {
+        KeyLockGuard lock(*this, key);
+        if (!IndexesFor(key).empty()) {
+            // Index entries need the new value, so indexed keys are folded
+            // right away instead of getting a delta.
+            std::string payload;
+            ValueHeader header;
+            bool exists = ReadValue(key, payload, header);
+            ApplyMerge(op, operand, exists, payload);
+            leveldb::WriteBatch folded;
+            std::unique_lock<std::recursive_mutex> dedupLock(_dedupMutex, std::defer_lock);
+            StageIndexChange(folded, key, &payload);
+            if (!StageUserValue(folded, key, payload, header, dedupLock)) {
+                return false;
+            }
+            StageDropMerges(folded, key);
+            if (!Commit(folded)) {
+                return false;
+            }
+            ForgetMerges(key);
+            return true;
+        }
+        // Numbered under the key stripe so that the deltas of one key are
+        // folded in the order they were committed.
+        std::string deltaKey = MergeDeltaPrefix(key);
+        PutFixed64BE(deltaKey, ++_mergeSequence);
+        std::string delta(1, static_cast<char>(op));
+        delta.append(operand);
+        leveldb::WriteBatch batch;
+        batch.Put(deltaKey, delta);
+        if (!Commit(batch)) {
+            return false;
+        }
+        // The batch only holds an internal delta key.
+        BumpKeyVersion(key);
+        std::lock_guard<std::mutex> mergeLock(_mergeMutex);
+        uint32_t &count = _pendingMerges[key];
+        if (count++ == 0) {
+            _pendingMergeKeys++;
+        }
+        collapse = count >= _mergeCollapseThreshold && _mergeCollapseQueued.insert(key).second;
+    }
+    if (collapse) {
+        {
+            std::lock_guard<std::mutex> lock(_maintenanceMutex);
+            _mergeCollapseQueue.push_back(key);
+            _maintenanceCond.notify_all();
+        }
+        EnsureMaintenanceThread();
+    }
+    return true;
+}
+
+static size_t CountTagIndexes(const std::vector<IndexSpec> &specs) {
+    return std::count_if(specs.begin(), specs.end(),
+                         [](const IndexSpec &spec) { return spec.type == kIndexValueTags; });
+}
+
+std::vector<IndexSpec> LevelDB::IndexesFor(const std::string &key) {
+    std::vector<IndexSpec> specs;
+    if (_indexCount == 0) {
+        return specs;
+    }
+    std::lock_guard<std::mutex> lock(_indexMutex);
+    for (const auto& spec : _indexes) {
+        if (leveldb::Slice(key).starts_with(spec.keyPrefix)) {
+            specs.push_back(spec);
+        }
+    }
+    return specs;
+}
+
+void LevelDB::StageIndexChange(leveldb::WriteBatch &batch, const std::string &key, const std::string *newValue,
+                               bool newIsObject) {
+    std::vector<IndexSpec> specs = IndexesFor(key);
+    if (specs.empty()) {
+        return;
+    }
+    // Index fields are extracted from JSON text.
+    std::string newJson;
+    if (newValue && newIsObject) {
+        ObjectToJson(*newValue, newJson);
+        newValue = &newJson;
+    }
+    std::string oldValue;
+    ValueHeader header;
+    bool existed = ReadValue(key, oldValue, header, true);
+    for (const auto& spec : specs) {
+        if (spec.type == kIndexValueTags) {
+            StageTagChange(batch, spec, key, existed ? &oldValue : nullptr, newValue);
+            continue;
+        }
+        if (spec.type == kIndexValueCompletion) {
+            // Only entries that differ are rewritten, so a score change moves
+            // the key and an unchanged text costs no writes.
+            std::vector<std::string> oldEntries;
+            std::vector<std::string> newEntries;
+            if (existed) {
+                ExtractCompletionEntries(spec, oldValue, key, oldEntries);
+            }
+            if (newValue) {
+                ExtractCompletionEntries(spec, *newValue, key, newEntries);
+            }
+            std::vector<std::string> changed;
+            std::set_difference(oldEntries.begin(), oldEntries.end(), newEntries.begin(), newEntries.end(),
+                                std::back_inserter(changed));
+            for (const auto& entry : changed) {
+                batch.Delete(entry);
+            }
+            changed.clear();
+            std::set_difference(newEntries.begin(), newEntries.end(), oldEntries.begin(), oldEntries.end(),
+                                std::back_inserter(changed));
+            for (const auto& entry : changed) {
+                batch.Put(entry, leveldb::Slice());
+            }
+            continue;
+        }
+        KeyPart field;
+        std::string oldEntry;
+        std::string newEntry;
+        if (existed && ExtractIndexField(spec, oldValue, field)) {
+            oldEntry = IndexEntryKey(spec.name, field, key);
+        }
+        if (newValue && ExtractIndexField(spec, *newValue, field)) {
+            newEntry = IndexEntryKey(spec.name, field, key);
+        }
+        if (oldEntry == newEntry) {
+            continue;
+        }
+        if (!oldEntry.empty()) {
+            batch.Delete(oldEntry);
+        }
+        if (!newEntry.empty()) {
+            batch.Put(newEntry, leveldb::Slice());
+        }
+    }
+}
+
+void LevelDB::WaitForIndexWriters() {
+    // Writers read the index list while holding their key's stripe.
+    for (auto& stripe : _keyLocks) {
+        std::lock_guard<std::mutex> lock(stripe);
+    }
+}
+
+void LevelDB::LoadIndexes() {
+    std::vector<std::pair<IndexSpec, bool>> specs;
+    std::string prefix = IndexSpecPrefix();
+    leveldb::Iterator* it = _db->NewIterator(_readOptions);
+    for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+        IndexSpec spec;
+        bool ready = false;
+        if (DecodeIndexSpec(it->value(), spec, ready)) {
+            spec.name = it->key().ToString().substr(prefix.size());
+            specs.emplace_back(spec, ready);
+        }
+    }
+    delete it;
+
+    {
+        std::lock_guard<std::mutex> lock(_indexMutex);
+        _indexes.clear();
+        for (const auto& entry : specs) {
+            _indexes.push_back(entry.first);
+        }
+        _indexCount = _indexes.size();
+        _tagIndexCount = CountTagIndexes(_indexes);
+    }
+    // A backfill cut short by a crash is finished before the index is used.
+    for (const auto& entry : specs) {
+        if (!entry.second && BackfillIndex(entry.first)) {
+            _db->Put(_writeOptions, IndexSpecKey(entry.first.name), EncodeIndexSpec(entry.first, true));
+        }
+    }
+}
+
+bool LevelDB::BackfillIndex(const IndexSpec &spec) {
+    // Under bytewise order the prefix is one contiguous range; otherwise the
+    // whole key space is walked.
+    bool prefixRange = _comparator == leveldb::BytewiseComparator();
+    leveldb::ReadOptions scanOptions;
+    scanOptions.fill_cache = false;
+    std::string cursor;
+    bool started = false;
+    for (;;) {
+        std::vector<std::string> keys;
+        leveldb::Iterator* it = _db->NewIterator(scanOptions);
+        if (started) {
+            it->Seek(cursor);
+            if (it->Valid() && it->key() == cursor) {
+                it->Next();
+            }
+        } else if (prefixRange) {
+            it->Seek(spec.keyPrefix);
+        } else {
+            it->SeekToFirst();
+        }
+        for (; it->Valid() && !IsInternalKey(it->key()) && keys.size() < kIndexBackfillBatchSize; it->Next()) {
+            if (it->key().starts_with(spec.keyPrefix)) {
+                keys.push_back(it->key().ToString());
+            } else if (prefixRange) {
+                break;
+            }
+        }
+        bool more = keys.size() == kIndexBackfillBatchSize;
+        delete it;
+
+        if (!more) {
+            // Keys that so far only exist as merge deltas.
+            std::lock_guard<std::mutex> lock(_mergeMutex);
+            for (const auto& entry : _pendingMerges) {
+                if (leveldb::Slice(entry.first).starts_with(spec.keyPrefix)) {
+                    keys.push_back(entry.first);
+                }
+            }
+        }
+        if (!keys.empty()) {
+            KeyLockGuard lock(*this, keys);
+            leveldb::WriteBatch batch;
+            for (const auto& key : keys) {
+                std::string value;
+                ValueHeader header;
+                KeyPart field;
+                if (!ReadValue(key, value, header, true)) {
+                    continue;
+                }
+                if (spec.type == kIndexValueTags) {
+                    // Keys a writer already indexed keep their id and tags.
+                    StageTagChange(batch, spec, key, &value, &value);
+                } else if (spec.type == kIndexValueCompletion) {
+                    std::vector<std::string> entries;
+                    ExtractCompletionEntries(spec, value, key, entries);
+                    for (const auto& entry : entries) {
+                        batch.Put(entry, leveldb::Slice());
+                    }
+                } else if (ExtractIndexField(spec, value, field)) {
+                    batch.Put(IndexEntryKey(spec.name, field, key), leveldb::Slice());
+                }
+            }
+            if (!Commit(batch)) {
+                return false;
+            }
+        }
+        if (!more || _closing) {
+            return !_closing;
+        }
+        cursor = keys.back();
+        started = true;
+    }
+}
+
+bool LevelDB::DefineIndex(const IndexSpec &spec, std::string *error) {
+    if (spec.name.empty() || !IsValidIndexType(spec.type) ||
+        (!spec.scoreField.empty() && spec.type != kIndexValueCompletion)) {
+        if (error) {
+            *error = "invalid index definition";
+        }
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_indexMutex);
+        for (const auto& existing : _indexes) {
+            if (existing.name == spec.name) {
+                if (!(existing == spec) && error) {
+                    *error = "index " + spec.name + " already exists with different options";
+                }
+                return existing == spec;
+            }
+        }
+        // Recorded as unfinished before writers see the index, so an
+        // interrupted backfill resumes on the next open and a failed write
+        // leaves no entries behind.
+        if (!_db->Put(_writeOptions, IndexSpecKey(spec.name), EncodeIndexSpec(spec, false)).ok()) {
+            if (error) {
+                *error = "failed to store index " + spec.name;
+            }
+            return false;
+        }
+        _indexes.push_back(spec);
+        _indexCount = _indexes.size();
+        _tagIndexCount = CountTagIndexes(_indexes);
+    }
+    WaitForIndexWriters();
+    if (!BackfillIndex(spec) ||
+        !_db->Put(_writeOptions, IndexSpecKey(spec.name), EncodeIndexSpec(spec, true)).ok()) {
+        if (error) {
+            *error = "failed to build index " + spec.name;
+        }
+        return false;
+    }
+    return true;
+}
+
+bool LevelDB::DropIndex(const std::string &name) {
+    {
+        std::lock_guard<std::mutex> lock(_indexMutex);
+        auto it = std::find_if(_indexes.begin(), _indexes.end(),
+                               [&name](const IndexSpec &spec) { return spec.name == name; });
+        if (it == _indexes.end()) {
+            return false;
+        }
+        _indexes.erase(it);
+        _indexCount = _indexes.size();
+    }
+    WaitForIndexWriters();
+    {
+        // Only now, so that tag deltas staged before the drop are still folded.
+        std::lock_guard<std::mutex> lock(_indexMutex);
+        _tagIndexCount = CountTagIndexes(_indexes);
+    }
+
+    _db->Delete(_writeOptions, IndexSpecKey(name));
+    std::string prefix = IndexEntryPrefix(name);
+    leveldb::ReadOptions scanOptions;
+    scanOptions.fill_cache = false;
+    for (;;) {
+        leveldb::WriteBatch batch;
+        size_t count = 0;
+        leveldb::Iterator* it = _db->NewIterator(scanOptions);
+        for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix) && count < kIndexBackfillBatchSize;
+             it->Next()) {
+            batch.Delete(it->key());
+            count++;
+        }
+        delete it;
+        if (count == 0 || !Commit(batch) || count < kIndexBackfillBatchSize) {
+            break;
+        }
+    }
+    std::lock_guard<std::mutex> lock(_tagMutex);
+    _tagNextIds.erase(name);
+    return true;
+}
+
+std::vector<IndexSpec> LevelDB::GetIndexes() {
+    std::lock_guard<std::mutex> lock(_indexMutex);
+    return _indexes;
+}
+
+bool LevelDB::QueryIndex(const std::string &name, const IndexQuery &query, std::vector<ScanEntry> &entries) {
+    IndexSpec spec;
+    {
+        std::lock_guard<std::mutex> lock(_indexMutex);
+        auto it = std::find_if(_indexes.begin(), _indexes.end(),
+                               [&name](const IndexSpec &spec) { return spec.name == name; });
+        // Tag and completion indexes have their own queries.
+        if (it == _indexes.end() || it->type == kIndexValueTags || it->type == kIndexValueCompletion) {
+            return false;
+        }
+        spec = *it;
+    }
+
+    // Entries are ordered by field and then key, so a field bound maps to
+    // the start (or the end) of all entries sharing that field.
+    std::string prefix = IndexEntryPrefix(name);
+    std::string lower = prefix;
+    std::string upper = PrefixSuccessor(prefix);
+    if (query.hasLower) {
+        KeyPart bound = query.lower;
+        if (!CoerceIndexField(spec, bound)) {
+            return false;
+        }
+        std::string fieldPrefix = prefix;
+        EncodeKeyPart(fieldPrefix, bound);
+        lower = query.lowerInclusive ? fieldPrefix : PrefixSuccessor(fieldPrefix);
+    }
+    if (query.hasUpper) {
+        KeyPart bound = query.upper;
+        if (!CoerceIndexField(spec, bound)) {
+            return false;
+        }
+        std::string fieldPrefix = prefix;
+        EncodeKeyPart(fieldPrefix, bound);
+        upper = query.upperInclusive ? PrefixSuccessor(fieldPrefix) : fieldPrefix;
+    }
+
+    leveldb::Iterator* it = _db->NewIterator(_readOptions);
+    if (query.reverse) {
+        it->Seek(upper);
+        if (it->Valid()) {
+            it->Prev();
+        } else {
+            it->SeekToLast();
+        }
+    } else {
+        it->Seek(lower);
+    }
+    for (; it->Valid() && (query.limit == 0 || entries.size() < query.limit);
+         query.reverse ? it->Prev() : it->Next()) {
+        leveldb::Slice entry = it->key();
+        if (!IsInternalKey(entry) || entry.compare(lower) < 0 || entry.compare(upper) >= 0) {
+            break;
+        }
+        KeyPart field;
+        std::string key;
+        if (!DecodeIndexEntryKey(entry, field, key)) {
+            continue;
+        }
+        // The entry is only trusted if the live value still maps to it;
+        // expired values have entries until the sweeper removes them.
+        std::string value;
+        ValueHeader header;
+        KeyPart current;
+        if (!ReadValue(key, value, header) || !ExtractIndexField(spec, value, current) ||
+            IndexEntryKey(name, current, key) != entry) {
+            continue;
+        }
+        ScanEntry hit;
+        hit.key = std::move(key);
+        hit.value = std::move(value);
+        entries.push_back(std::move(hit));
+    }
+    delete it;
+    return true;
+}
+
+void LevelDB::StageTagChange(leveldb::WriteBatch &batch, const IndexSpec &spec, const std::string &key,
+                             const std::string *oldValue, const std::string *newValue) {
+    std::string idKey = TagKeyIdKey(spec.name, key);
+    std::string stored;
+    bool indexed = _db->Get(_readOptions, idKey, &stored).ok() && stored.size() == 4;
+    if (!indexed && newValue == nullptr) {
+        return;
+    }
+    std::string universe = TagUniversePrefix(spec.name);
+    std::string deltaKey;
+    std::string deltaValue;
+    uint32_t id = 0;
+    std::vector<std::string> oldTags;
+    if (indexed) {
+        id = DecodeFixed32BE(stored.data());
+        if (oldValue) {
+            ExtractIndexTags(spec, *oldValue, oldTags);
+        }
+    } else {
+        {
+            std::lock_guard<std::mutex> lock(_tagMutex);
+            id = NextTagIdLocked(spec.name);
+        }
+        stored.clear();
+        PutFixed32BE(stored, id);
+        batch.Put(idKey, stored);
+        batch.Put(TagIdKey(spec.name, id), key);
+        PutTagDelta(deltaKey, deltaValue, universe, id, true);
+        batch.Put(deltaKey, deltaValue);
+    }
+    std::vector<std::string> newTags;
+    if (newValue) {
+        ExtractIndexTags(spec, *newValue, newTags);
+    } else {
+        batch.Delete(idKey);
+        batch.Delete(TagIdKey(spec.name, id));
+        PutTagDelta(deltaKey, deltaValue, universe, id, false);
+        batch.Put(deltaKey, deltaValue);
+    }
+    // Both lists are sorted, so one merge pass finds the dropped and added tags.
+    size_t i = 0;
+    size_t j = 0;
+    while (i < oldTags.size() || j < newTags.size()) {
+        int order = i == oldTags.size() ? 1 : j == newTags.size() ? -1 : oldTags[i].compare(newTags[j]);
+        if (order == 0) {
+            i++;
+            j++;
+            continue;
+        }
+        bool add = order > 0;
+        PutTagDelta(deltaKey, deltaValue, TagBitmapPrefix(spec.name, add ? newTags[j++] : oldTags[i++]), id, add);
+        batch.Put(deltaKey, deltaValue);
+    }
+}
+
+void LevelDB::StageTagContainers(leveldb::WriteBatch &batch) {
+    struct Splitter : public leveldb::WriteBatch::Handler {
+        leveldb::WriteBatch rest;
+        // Changes per container key, in batch order.
+        std::map<std::string, std::vector<std::pair<uint16_t, bool>>> deltas;
+        std::string containerKey;
+        void Put(const leveldb::Slice &key, const leveldb::Slice &value) override {
+            uint16_t low = 0;
+            bool add = false;
+            if (DecodeTagDelta(key, value, containerKey, low, add)) {
+                deltas[containerKey].emplace_back(low, add);
+            } else {
+                rest.Put(key, value);
+            }
+        }
+        void Delete(const leveldb::Slice &key) override { rest.Delete(key); }
+    } splitter;
+    batch.Iterate(&splitter);
+    if (splitter.deltas.empty()) {
+        return;
+    }
+    for (const auto& entry : splitter.deltas) {
+        std::string value;
+        RoaringContainer container;
+        if (_db->Get(_readOptions, entry.first, &value).ok()) {
+            DecodeRoaringContainer(value, container);
+        }
+        for (const auto& change : entry.second) {
+            if (change.second) {
+                container.Add(change.first);
+            } else {
+                container.Remove(change.first);
+            }
+        }
+        if (container.cardinality > 0) {
+            splitter.rest.Put(entry.first, EncodeRoaringContainer(container));
+        } else {
+            splitter.rest.Delete(entry.first);
+        }
+    }
+    batch = splitter.rest;
+}
+
+uint32_t LevelDB::NextTagIdLocked(const std::string &name) {
+    auto found = _tagNextIds.find(name);
+    if (found == _tagNextIds.end()) {
+        // One past the highest id in use. Ids of removed keys are not handed
+        // out again while the database is open.
+        std::string prefix = TagIdPrefix(name);
+        uint32_t next = 0;
+        uint32_t last = 0;
+        leveldb::Iterator* it = _db->NewIterator(_readOptions);
+        it->Seek(PrefixSuccessor(prefix));
+        if (it->Valid()) {
+            it->Prev();
+        } else {
+            it->SeekToLast();
+        }
+        if (it->Valid() && it->key().starts_with(prefix) && DecodeTagIdKey(it->key(), prefix.size(), last)) {
+            next = last + 1;
+        }
+        delete it;
+        found = _tagNextIds.emplace(name, next).first;
+    }
+    return found->second++;
+}
+
+bool LevelDB::MatchTags(const std::string &name, const std::string &expression, const leveldb::ReadOptions &options,
+                        RoaringBitmap &result, std::string *error) {
+    bool known = false;
+    {
+        std::lock_guard<std::mutex> lock(_indexMutex);
+        known = std::any_of(_indexes.begin(), _indexes.end(), [&name](const IndexSpec &spec) {
+            return spec.name == name && spec.type == kIndexValueTags;
+        });
+    }
+    if (!known) {
+        if (error) {
+            *error = "unknown tag index: " + name;
+        }
+        return false;
+    }
+    TagExpression parsed;
+    std::string message;
+    if (!ParseTagExpression(expression, parsed, message)) {
+        if (error) {
+            *error = "invalid tag expression: " + message;
+        }
+        return false;
+    }
+    // One iterator for every bitmap, so they all come from the same state.
+    leveldb::Iterator* it = _db->NewIterator(options);
+    auto load = [&](const std::string *tag) {
+        RoaringBitmap bitmap;
+        std::string prefix = tag ? TagBitmapPrefix(name, *tag) : TagUniversePrefix(name);
+        for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+            uint16_t high = 0;
+            RoaringContainer container;
+            if (DecodeTagContainerKey(it->key(), prefix.size(), high) &&
+                DecodeRoaringContainer(it->value(), container)) {
+                bitmap.Containers().emplace_hint(bitmap.Containers().end(), high, std::move(container));
+            }
+        }
+        return bitmap;
+    };
+    result = EvaluateTagExpression(parsed, load);
+    delete it;
+    return true;
+}
+
+bool LevelDB::QueryTags(const std::string &name, const std::string &expression, size_t limit,
+                        std::vector<std::string> &keys, std::string *error) {
+    keys.clear();
+    leveldb::ReadOptions options = _readOptions;
+    options.snapshot = _db->GetSnapshot();
+    RoaringBitmap matched;
+    bool found = MatchTags(name, expression, options, matched, error);
+    if (found) {
+        std::vector<uint32_t> ids;
+        matched.ToIds(ids, limit);
+        keys.reserve(ids.size());
+        // Ids ascend like their entries, so dense matches are reached by
+        // stepping the iterator rather than seeking.
+        leveldb::Iterator* it = _db->NewIterator(options);
+        std::string entry;
+        for (uint32_t id : ids) {
+            entry = TagIdKey(name, id);
+            if (it->Valid() && it->key().compare(entry) < 0) {
+                it->Next();
+            }
+            if (!it->Valid() || it->key() != entry) {
+                it->Seek(entry);
+            }
+            if (it->Valid() && it->key() == entry) {
+                keys.push_back(it->value().ToString());
+            }
+        }
+        delete it;
+    }
+    _db->ReleaseSnapshot(options.snapshot);
+    return found;
+}
+
+bool LevelDB::CountTags(const std::string &name, const std::string &expression, uint64_t &count,
+                        std::string *error) {
+    RoaringBitmap matched;
+    if (!MatchTags(name, expression, _readOptions, matched, error)) {
+        return false;
+    }
+    count = matched.Cardinality();
+    return true;
+}
+
+bool LevelDB::Complete(const std::string &name, const std::string &input, size_t k,
+                       std::vector<CompletionMatch> &matches) {
+    matches.clear();
+    bool known = false;
+    {
+        std::lock_guard<std::mutex> lock(_indexMutex);
+        known = std::any_of(_indexes.begin(), _indexes.end(), [&name](const IndexSpec &spec) {
+            return spec.name == name && spec.type == kIndexValueCompletion;
+        });
+    }
+    if (!known) {
+        return false;
+    }
+    std::string normalized = NormalizeCompletionText(input);
+    if (normalized.empty() || k == 0) {
+        return true;
+    }
+    std::string section = CompletionSection(name, normalized);
+    leveldb::Iterator* it = _db->NewIterator(_readOptions);
+    for (it->Seek(section); it->Valid() && it->key().starts_with(section) && matches.size() < k; it->Next()) {
+        CompletionMatch match;
+        // Every term of the section starts with input unless input is longer
+        // than the indexed prefixes.
+        if (!DecodeCompletionEntry(it->key(), section.size(), match) ||
+            !leveldb::Slice(match.term).starts_with(normalized)) {
+            continue;
+        }
+        // The entries of one key share its score, so its other terms follow
+        // right after.
+        if (!matches.empty() && matches.back().key == match.key) {
+            continue;
+        }
+        matches.push_back(std::move(match));
+    }
+    delete it;
+    return true;
+}
+
+static uint64_t ReadCount(leveldb::DB *db, const leveldb::ReadOptions &options, const std::string &key) {
+    std::string value;
+    if (!db->Get(options, key, &value).ok() || value.size() != 8) {
+        return 0;
+    }
+    return DecodeFixed64BE(value.data());
+}
+
+bool LevelDB::ZAdd(const std::string &name, const std::vector<SortedSetMember> &members, uint64_t &added) {
+    added = 0;
+    for (const auto& entry : members) {
+        if (std::isnan(entry.score)) {
+            return false;
+        }
+    }
+    std::string countKey = SortedSetCountKey(name);
+    KeyLockGuard lock(*this, countKey);
+    leveldb::WriteBatch batch;
+    // Scores written earlier in this call, which the batch hides from Get().
+    std::unordered_map<std::string, double> staged;
+    bool changed = false;
+    for (const auto& entry : members) {
+        // -0 and 0 are the same score but encode differently.
+        double score = entry.score == 0 ? 0 : entry.score;
+        std::string memberKey = SortedSetMemberKey(name, entry.member);
+        double previous = 0;
+        bool existed = false;
+        auto it = staged.find(entry.member);
+        if (it != staged.end()) {
+            previous = it->second;
+            existed = true;
+        } else {
+            std::string value;
+            existed = _db->Get(_readOptions, memberKey, &value).ok() && DecodeScore(value, previous);
+        }
+        staged[entry.member] = score;
+        if (existed && previous == score) {
+            continue;
+        }
+        if (existed) {
+            batch.Delete(SortedSetScoreKey(name, previous, entry.member));
+        } else {
+            added++;
+        }
+        changed = true;
+        batch.Put(memberKey, EncodeScore(score));
+        batch.Put(SortedSetScoreKey(name, score, entry.member), leveldb::Slice());
+    }
+    if (added > 0) {
+        std::string count;
+        PutFixed64BE(count, ReadCount(_db, _readOptions, countKey) + added);
+        batch.Put(countKey, count);
+    }
+    return !changed || Commit(batch);
+}
+
+bool LevelDB::ZRem(const std::string &name, const std::vector<std::string> &members, uint64_t &removed) {
+    removed = 0;
+    std::string countKey = SortedSetCountKey(name);
+    KeyLockGuard lock(*this, countKey);
+    leveldb::WriteBatch batch;
+    std::unordered_set<std::string> seen;
+    for (const auto& member : members) {
+        std::string memberKey = SortedSetMemberKey(name, member);
+        std::string value;
+        double score = 0;
+        if (!seen.insert(member).second || !_db->Get(_readOptions, memberKey, &value).ok() ||
+            !DecodeScore(value, score)) {
+            continue;
+        }
+        batch.Delete(memberKey);
+        batch.Delete(SortedSetScoreKey(name, score, member));
+        removed++;
+    }
+    if (removed == 0) {
+        return true;
+    }
+    uint64_t count = ReadCount(_db, _readOptions, countKey);
+    if (count > removed) {
+        std::string value;
+        PutFixed64BE(value, count - removed);
+        batch.Put(countKey, value);
+    } else {
+        batch.Delete(countKey);
+    }
+    return Commit(batch);
+}
+
+bool LevelDB::ZScore(const std::string &name, const std::string &member, double &score) {
+    std::string value;
+    return _db->Get(_readOptions, SortedSetMemberKey(name, member), &value).ok() && DecodeScore(value, score);
+}
+
+uint64_t LevelDB::ZCard(const std::string &name) {
+    return ReadCount(_db, _readOptions, SortedSetCountKey(name));
+}
+
+bool LevelDB::ZRank(const std::string &name, const std::string &member, bool reverse, uint64_t &rank) {
+    // Both reads come from one snapshot so the entry cannot move in between.
+    leveldb::ReadOptions readOptions = _readOptions;
+    readOptions.snapshot = _db->GetSnapshot();
+    std::string value;
+    double score = 0;
+    bool found = _db->Get(readOptions, SortedSetMemberKey(name, member), &value).ok() && DecodeScore(value, score);
+    if (found) {
+        std::string prefix = SortedSetScorePrefix(name);
+        std::string target = SortedSetScoreKey(name, score, member);
+        leveldb::Iterator* it = _db->NewIterator(readOptions);
+        rank = 0;
+        if (reverse) {
+            // Entries after the member's own, up to the end of the set.
+            std::string limit = PrefixSuccessor(prefix);
+            for (it->Seek(target), it->Next(); it->Valid() && it->key().compare(limit) < 0; it->Next()) {
+                rank++;
+            }
+        } else {
+            for (it->Seek(prefix); it->Valid() && it->key().compare(target) < 0; it->Next()) {
+                rank++;
+            }
+        }
+        delete it;
+    }
+    _db->ReleaseSnapshot(readOptions.snapshot);
+    return found;
+}
+
+std::vector<SortedSetMember> LevelDB::ZRangeByScore(const std::string &name, const ScoreRange &range) {
+    std::vector<SortedSetMember> members;
+    // Score entries are ordered by score and then member, so a score bound
+    // maps to the start (or the end) of all entries sharing that score.
+    std::string prefix = SortedSetScorePrefix(name);
+    std::string lower = prefix;
+    std::string upper = PrefixSuccessor(prefix);
+    KeyPart bound;
+    bound.type = kKeyPartDouble;
+    if (range.hasMin) {
+        std::string scorePrefix = prefix;
+        bound.number = range.min == 0 ? 0 : range.min;
+        EncodeKeyPart(scorePrefix, bound);
+        lower = range.minInclusive ? scorePrefix : PrefixSuccessor(scorePrefix);
+    }
+    if (range.hasMax) {
+        std::string scorePrefix = prefix;
+        bound.number = range.max == 0 ? 0 : range.max;
+        EncodeKeyPart(scorePrefix, bound);
+        upper = range.maxInclusive ? PrefixSuccessor(scorePrefix) : scorePrefix;
+    }
+
+    leveldb::Iterator* it = _db->NewIterator(_readOptions);
+    if (range.reverse) {
+        it->Seek(upper);
+        if (it->Valid()) {
+            it->Prev();
+        } else {
+            it->SeekToLast();
+        }
+    } else {
+        it->Seek(lower);
+    }
+    size_t skipped = 0;
+    for (; it->Valid() && (range.limit == 0 || members.size() < range.limit);
+         range.reverse ? it->Prev() : it->Next()) {
+        leveldb::Slice entry = it->key();
+        if (!IsInternalKey(entry) || entry.compare(lower) < 0 || entry.compare(upper) >= 0) {
+            break;
+        }
+        SortedSetMember member;
+        if (!DecodeSortedSetScoreKey(entry, member) || skipped++ < range.offset) {
+            continue;
+        }
+        members.push_back(std::move(member));
+    }
+    delete it;
+    return members;
+}
+
+void LevelDB::StageSharedRefs(leveldb::WriteBatch &batch) {
+    // The batch is replayed in order against the stored values, so a key
+    // written twice only counts its last value.
+    struct Collector : public leveldb::WriteBatch::Handler {
+        std::vector<std::pair<std::string, std::string>> writes;
+        std::vector<bool> puts;
+        void Put(const leveldb::Slice &key, const leveldb::Slice &value) override { Record(key, value, true); }
+        void Delete(const leveldb::Slice &key) override { Record(key, leveldb::Slice(), false); }
+        void Record(const leveldb::Slice &key, const leveldb::Slice &value, bool put) {
+            if (!IsInternalKey(key)) {
+                writes.emplace_back(key.ToString(), value.ToString());
+                puts.push_back(put);
+            }
+        }
+    } collector;
+    batch.Iterate(&collector);
+    if (collector.writes.empty()) {
+        return;
+    }
+    auto sharedHash = [](const leveldb::Slice &raw, std::string &hash) {
+        ValueHeader header;
+        size_t offset = DecodeValueHeader(raw, header);
+        if (offset == std::string::npos || (header.flags & kValueFlagShared) == 0) {
+            return false;
+        }
+        hash.assign(raw.data() + offset, raw.size() - offset);
+        return true;
+    };
+    // Current raw value per key, or absent for "no value".
+    std::unordered_map<std::string, std::pair<bool, std::string>> current;
+    std::map<std::string, int64_t> deltas;
+    std::string hash;
+    for (size_t i = 0; i < collector.writes.size(); i++) {
+        const std::string &key = collector.writes[i].first;
+        auto found = current.find(key);
+        if (found == current.end()) {
+            std::pair<bool, std::string> stored;
+            stored.first = _db->Get(_readOptions, key, &stored.second).ok();
+            found = current.emplace(key, std::move(stored)).first;
+        }
+        if (found->second.first && sharedHash(found->second.second, hash)) {
+            deltas[hash]--;
+        }
+        found->second.first = collector.puts[i];
+        found->second.second = collector.writes[i].second;
+        if (collector.puts[i] && sharedHash(collector.writes[i].second, hash)) {
+            deltas[hash]++;
+        }
+    }
+    for (const auto& delta : deltas) {
+        if (delta.second == 0) {
+            continue;
+        }
+        std::string refKey = SharedRefKey(delta.first);
+        std::string value;
+        int64_t count = 0;
+        if (_db->Get(_readOptions, refKey, &value).ok() && value.size() == 8) {
+            count = static_cast<int64_t>(DecodeFixed64BE(value.data()));
+        }
+        count += delta.second;
+        if (count > 0) {
+            value.clear();
+            PutFixed64BE(value, static_cast<uint64_t>(count));
+            batch.Put(refKey, value);
+        } else {
+            // Its blob record, if any, is left to blob garbage collection.
+            batch.Delete(refKey);
+            batch.Delete(SharedContentKey(delta.first));
+        }
+    }
+}
+
+void LevelDB::StageAccessOrder(leveldb::WriteBatch &batch) {
+    // The last operation on each user key decides whether it gets a new stamp.
+    struct Collector : public leveldb::WriteBatch::Handler {
+        std::vector<std::string> keys;
+        std::unordered_map<std::string, bool> written;
+        void Put(const leveldb::Slice &key, const leveldb::Slice &) override { Record(key, true); }
+        void Delete(const leveldb::Slice &key) override { Record(key, false); }
+        void Record(const leveldb::Slice &key, bool put) {
+            if (IsInternalKey(key)) {
+                return;
+            }
+            auto inserted = written.emplace(key.ToString(), put);
+            if (inserted.second) {
+                keys.push_back(key.ToString());
+            } else {
+                inserted.first->second = put;
+            }
+        }
+    } collector;
+    batch.Iterate(&collector);
+    for (const auto& key : collector.keys) {
+        std::string stampKey = AccessStampKey(key);
+        std::string previous;
+        if (_db->Get(_readOptions, stampKey, &previous).ok() && previous.size() == 8) {
+            batch.Delete(AccessOrderKey(DecodeFixed64BE(previous.data()), key));
+        }
+        if (collector.written[key]) {
+            uint64_t stamp = ++_accessClock;
+            std::string value;
+            PutFixed64BE(value, stamp);
+            batch.Put(AccessOrderKey(stamp, key), leveldb::Slice());
+            batch.Put(stampKey, value);
+        } else if (!previous.empty()) {
+            batch.Delete(stampKey);
+        }
+    }
+}
+
+void LevelDB::RecordAccess(const std::string &key) {
+    if (_cacheMaxBytes == 0 || _cacheEviction != kCacheEvictLru) {
+        return;
+    }
+    // Reads are only noted here; the maintenance thread writes them out in
+    // batches. Past the bound a read is simply not counted.
+    std::lock_guard<std::mutex> lock(_cacheMutex);
+    if (_pendingAccesses.size() < kMaxPendingAccesses) {
+        _pendingAccesses.insert(key);
+    }
+}
+
+void LevelDB::FlushAccesses() {
+    std::vector<std::string> keys;
+    {
+        std::lock_guard<std::mutex> lock(_cacheMutex);
+        keys.assign(_pendingAccesses.begin(), _pendingAccesses.end());
+        _pendingAccesses.clear();
+    }
+    for (size_t begin = 0; begin < keys.size(); begin += kCacheEvictionBatchSize) {
+        std::vector<std::string> chunk(keys.begin() + begin,
+                                       keys.begin() + std::min(keys.size(), begin + kCacheEvictionBatchSize));
+        KeyLockGuard lock(*this, chunk);
+        leveldb::WriteBatch batch;
+        for (const auto& key : chunk) {
+            std::string stampKey = AccessStampKey(key);
+            std::string previous;
+            if (!_db->Get(_readOptions, stampKey, &previous).ok() || previous.size() != 8) {
+                continue;
+            }
+            uint64_t stamp = ++_accessClock;
+            std::string value;
+            PutFixed64BE(value, stamp);
+            batch.Delete(AccessOrderKey(DecodeFixed64BE(previous.data()), key));
+            batch.Put(AccessOrderKey(stamp, key), leveldb::Slice());
+            batch.Put(stampKey, value);
+        }
+        Commit(batch);
+    }
+}
+
+void LevelDB::LoadAccessOrder() {
+    std::string prefix = AccessOrderPrefix();
+    leveldb::Iterator* it = _db->NewIterator(_readOptions);
+    it->Seek(PrefixSuccessor(prefix));
+    if (it->Valid()) {
+        it->Prev();
+    } else {
+        it->SeekToLast();
+    }
+    uint64_t stamp = 0;
+    std::string key;
+    if (it->Valid() && DecodeAccessOrderKey(it->key(), stamp, key)) {
+        _accessClock = stamp;
+        delete it;
+        return;
+    }
+
+    // First open in cache mode: existing keys get stamps in key order.
+    leveldb::WriteBatch batch;
+    size_t staged = 0;
+    for (it->SeekToFirst(); it->Valid() && !IsInternalKey(it->key()); it->Next()) {
+        std::string value;
+        PutFixed64BE(value, ++_accessClock);
+        batch.Put(AccessOrderKey(_accessClock, it->key()), leveldb::Slice());
+        batch.Put(AccessStampKey(it->key()), value);
+        if (++staged == kIndexBackfillBatchSize) {
+            _db->Write(_writeOptions, &batch);
+            batch.Clear();
+            staged = 0;
+        }
+    }
+    if (staged > 0) {
+        _db->Write(_writeOptions, &batch);
+    }
+    delete it;
+}
+
+void LevelDB::EnforceCacheLimit() {
+    FlushAccesses();
+    KeyRange all;
+    leveldb::Iterator* it = _db->NewIterator(_readOptions);
+    it->SeekToFirst();
+    if (!it->Valid()) {
+        delete it;
+        return;
+    }
+    all.start = it->key().ToString();
+    delete it;
+    // Table sizes miss what is still in the memtable, which is all of it
+    // until the first flush, and the values kept in blob files.
+    uint64_t size = GetApproximateSizes({ all })[0] + MemtableBytes() + _blobs.TotalBytes();
+    uint64_t target = _cacheMaxBytes / 100 * kCacheLowWatermarkPercent;
+    if (size <= _cacheMaxBytes) {
+        return;
+    }
+
+    // Value sizes stand in for the space each key frees once compacted.
+    uint64_t excess = size - target;
+    uint64_t freed = 0;
+    bool evictedBlobs = false;
+    std::string firstEvicted;
+    std::string lastEvicted;
+    std::string orderPrefix = AccessOrderPrefix();
+    while (freed < excess && !_closing) {
+        std::vector<std::pair<uint64_t, std::string>> candidates;
+        it = _db->NewIterator(_readOptions);
+        for (it->Seek(orderPrefix); it->Valid() && candidates.size() < kCacheEvictionBatchSize; it->Next()) {
+            uint64_t stamp = 0;
+            std::string key;
+            if (!DecodeAccessOrderKey(it->key(), stamp, key)) {
+                break;
+            }
+            candidates.emplace_back(stamp, std::move(key));
+        }
+        delete it;
+        if (candidates.empty()) {
+            break;
+        }
+
+        std::vector<std::string> keys;
+        for (const auto& candidate : candidates) {
+            keys.push_back(candidate.second);
+        }
+        KeyLockGuard lock(*this, keys);
+        leveldb::WriteBatch batch;
+        std::vector<std::string> evicted;
+        for (const auto& candidate : candidates) {
+            const std::string &key = candidate.second;
+            std::string stampKey = AccessStampKey(key);
+            std::string current;
+            if (!_db->Get(_readOptions, stampKey, &current).ok() || current.size() != 8 ||
+                DecodeFixed64BE(current.data()) != candidate.first) {
+                // Stale: the key was touched or removed since this entry was written.
+                batch.Delete(AccessOrderKey(candidate.first, key));
+                continue;
+            }
+            std::string raw;
+            if (!_db->Get(_readOptions, key, &raw).ok()) {
+                batch.Delete(AccessOrderKey(candidate.first, key));
+                batch.Delete(stampKey);
+                continue;
+            }
+            if (freed >= excess) {
+                break;
+            }
+            freed += key.size() + raw.size();
+            ValueHeader header;
+            size_t offset = DecodeValueHeader(raw, header);
+            BlobPointer pointer;
+            if (offset != std::string::npos && (header.flags & kValueFlagBlob) &&
+                DecodeBlobPointer(leveldb::Slice(raw.data() + offset, raw.size() - offset), pointer)) {
+                freed += pointer.valueSize;
+                evictedBlobs = true;
+            }
+            StageIndexChange(batch, key, nullptr);
+            StageDropMerges(batch, key);
+            // Commit() removes the order entry and stamp along with the key.
+            batch.Delete(key);
+            evicted.push_back(key);
+            if (firstEvicted.empty() || KeyLess(key, firstEvicted)) {
+                firstEvicted = key;
+            }
+            if (lastEvicted.empty() || KeyLess(lastEvicted, key)) {
+                lastEvicted = key;
+            }
+        }
+        if (!Commit(batch)) {
+            break;
+        }
+        for (const auto& key : evicted) {
+            ForgetMerges(key);
+        }
+        RecordTombstones(evicted);
+    }
+
+    // The space only comes back once the deletions are compacted; doing it
+    // here also keeps the next size estimate honest.
+    if (!firstEvicted.empty() && !_closing) {
+        CompactSubRange(KeyRange{ firstEvicted, lastEvicted });
+        CompactSubRange(KeyRange{ orderPrefix, PrefixSuccessor(orderPrefix) });
+    }
+    // Evicted blob values are only returned once their files are rewritten;
+    // they are most likely in the active file, so that one is sealed too.
+    if (evictedBlobs && !_closing) {
+        CollectBlobGarbage(true);
+    }
+}
+
+QueueState &LevelDB::QueueStateLocked(const std::string &name) {
+    auto it = _queues.find(name);
+    if (it == _queues.end()) {
+        QueueState state;
+        std::string value;
+        if (!_db->Get(_readOptions, QueueMetaKey(name), &value).ok() || !DecodeQueueMeta(value, state)) {
+            state = QueueState();
+        }
+        it = _queues.emplace(name, state).first;
+    }
+    return it->second;
+}
+
+bool LevelDB::Enqueue(const std::string &name, const std::vector<std::string> &items, uint64_t &firstSeq) {
+    std::string metaKey = QueueMetaKey(name);
+    KeyLockGuard lock(*this, metaKey);
+    QueueState state;
+    {
+        std::lock_guard<std::mutex> queueLock(_queueMutex);
+        state = QueueStateLocked(name);
+    }
+    firstSeq = state.tail;
+    if (items.empty()) {
+        return true;
+    }
+    leveldb::WriteBatch batch;
+    for (const auto& item : items) {
+        batch.Put(QueueItemKey(name, state.tail++), item);
+    }
+    batch.Put(metaKey, EncodeQueueMeta(state));
+    if (!Commit(batch)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> queueLock(_queueMutex);
+    QueueStateLocked(name).tail = state.tail;
+    return true;
 }
 
-void LevelDB::Close() {
-    if (_db) {
-        delete _db;
-        _db = nullptr;
+std::vector<QueueItem> LevelDB::Peek(const std::string &name, size_t maxItems) {
+    std::vector<QueueItem> items;
+    uint64_t head = 0;
+    {
+        std::lock_guard<std::mutex> queueLock(_queueMutex);
+        head = QueueStateLocked(name).head;
+    }
+    std::string prefix = QueueItemPrefix(name);
+    leveldb::Iterator* it = _db->NewIterator(_readOptions);
+    for (it->Seek(QueueItemKey(name, head)); it->Valid() && items.size() < maxItems; it->Next()) {
+        QueueItem item;
+        if (!DecodeQueueItemKey(prefix, it->key(), item.seq)) {
+            break;
+        }
+        item.value = it->value().ToString();
+        items.push_back(std::move(item));
+    }
+    delete it;
+    return items;
+}
+
+bool LevelDB::Ack(const std::string &name, uint64_t upToSeq, uint64_t &acked) {
+    acked = 0;
+    std::string metaKey = QueueMetaKey(name);
+    KeyLockGuard lock(*this, metaKey);
+    QueueState state;
+    {
+        std::lock_guard<std::mutex> queueLock(_queueMutex);
+        state = QueueStateLocked(name);
+    }
+    uint64_t end = upToSeq < state.tail ? upToSeq + 1 : state.tail;
+    // Bounded batches keep each write (and the memtable) small; every batch
+    // moves head along with the deletes, so a crash in between loses nothing.
+    while (state.head < end) {
+        uint64_t chunkEnd = std::min(end, state.head + kQueueAckBatchSize);
+        leveldb::WriteBatch batch;
+        for (uint64_t seq = state.head; seq < chunkEnd; seq++) {
+            batch.Delete(QueueItemKey(name, seq));
+        }
+        QueueState next = state;
+        next.head = chunkEnd;
+        batch.Put(metaKey, EncodeQueueMeta(next));
+        if (!Commit(batch)) {
+            return false;
+        }
+        acked += chunkEnd - state.head;
+        state.head = chunkEnd;
+        std::lock_guard<std::mutex> queueLock(_queueMutex);
+        QueueStateLocked(name).head = state.head;
+    }
+
+    KeyRange range;
+    {
+        std::lock_guard<std::mutex> queueLock(_queueMutex);
+        QueueState &cached = QueueStateLocked(name);
+        if (cached.head - cached.compactFrom < kQueueCompactionThreshold) {
+            return true;
+        }
+        range.start = QueueItemKey(name, cached.compactFrom);
+        range.limit = QueueItemKey(name, cached.head);
+        cached.compactFrom = cached.head;
+    }
+    ScheduleCompaction(range);
+    return true;
+}
+
+uint64_t LevelDB::QueueLength(const std::string &name) {
+    std::lock_guard<std::mutex> queueLock(_queueMutex);
+    QueueState &state = QueueStateLocked(name);
+    return state.tail - state.head;
+}
+
+bool LevelDB::GetStreamLength(const std::string &key, uint64_t &length) {
+    std::string value;
+    StreamManifest manifest;
+    if (!_db->Get(_readOptions, StreamManifestKey(key), &value).ok() || !DecodeStreamManifest(value, manifest)) {
+        return false;
+    }
+    length = manifest.length;
+    return true;
+}
+
+bool LevelDB::RemoveStream(const std::string &key) {
+    std::string manifestKey = StreamManifestKey(key);
+    KeyLockGuard lock(*this, manifestKey);
+    std::string value;
+    StreamManifest manifest;
+    if (!_db->Get(_readOptions, manifestKey, &value).ok() || !DecodeStreamManifest(value, manifest)) {
+        return false;
+    }
+    leveldb::WriteBatch batch;
+    batch.Delete(manifestKey);
+    // Chunks of writers that have not finished yet are theirs to publish.
+    std::string prefix = StreamChunkPrefix(key);
+    std::string limit = prefix;
+    PutFixed64BE(limit, manifest.generation + 1);
+    leveldb::ReadOptions readOptions = _readOptions;
+    readOptions.fill_cache = false;
+    leveldb::Iterator* it = _db->NewIterator(readOptions);
+    for (it->Seek(prefix); it->Valid() && it->key().compare(limit) < 0; it->Next()) {
+        batch.Delete(it->key());
+    }
+    delete it;
+    return Commit(batch);
+}
+
+bool LevelDB::PutVector(const std::string &key, const float *values, size_t dimension, bool quantize) {
+    if (dimension == 0 || dimension > kMaxVectorDimension) {
+        return false;
+    }
+    for (size_t i = 0; i < dimension; i++) {
+        if (!std::isfinite(values[i])) {
+            return false;
+        }
+    }
+    leveldb::WriteBatch batch;
+    batch.Put(VectorKey(key), EncodeVector(values, dimension));
+    if (quantize) {
+        batch.Put(QuantizedVectorKey(key), EncodeQuantizedVector(values, dimension));
+    } else {
+        batch.Delete(QuantizedVectorKey(key));
+    }
+    return Commit(batch);
+}
+
+bool LevelDB::GetVector(const std::string &key, std::vector<float> &values) {
+    std::string value;
+    float norm = 0;
+    return _db->Get(_readOptions, VectorKey(key), &value).ok() && DecodeVector(value, norm, values);
+}
+
+bool LevelDB::RemoveVector(const std::string &key) {
+    leveldb::WriteBatch batch;
+    batch.Delete(VectorKey(key));
+    batch.Delete(QuantizedVectorKey(key));
+    return Commit(batch);
+}
+
+std::vector<VectorMatch> LevelDB::SearchVectors(const std::vector<float> &query,
+                                                const VectorSearchOptions &options) {
+    std::vector<VectorMatch> matches;
+    if (query.empty() || options.k == 0) {
+        return matches;
+    }
+    const VectorKernels &kernels = GetVectorKernels();
+    size_t dimension = query.size();
+    float queryNorm = std::sqrt(kernels.dot(query.data(), query.data(), dimension));
+    // Scores are ranked higher-is-better; L2 uses the negated squared distance.
+    auto score = [&options, queryNorm](float dot, float squaredL2, float norm, float &result) {
+        switch (options.metric) {
+            case kVectorDot:
+                result = dot;
+                break;
+            case kVectorCosine:
+                if (norm == 0 || queryNorm == 0) {
+                    return false;
+                }
+                result = dot / (norm * queryNorm);
+                break;
+            case kVectorL2:
+                result = -squaredL2;
+                break;
+        }
+        return std::isfinite(result);
+    };
+    auto better = [](const VectorMatch &a, const VectorMatch &b) { return a.score > b.score; };
+    // Min-heap of the best "keep" matches: the weakest is at the front.
+    auto offer = [&better](std::vector<VectorMatch> &heap, size_t keep, const leveldb::Slice &key, float value) {
+        if (heap.size() == keep && value <= heap.front().score) {
+            return;
+        }
+        if (heap.size() == keep) {
+            std::pop_heap(heap.begin(), heap.end(), better);
+            heap.pop_back();
+        }
+        heap.push_back({key.ToString(), value});
+        std::push_heap(heap.begin(), heap.end(), better);
+    };
+
+    // The int8 query is scaled like the stored copies.
+    std::string quantizedQuery = options.quantized ? EncodeQuantizedVector(query.data(), dimension) : std::string();
+    float queryScale = 0;
+    float unused = 0;
+    const int8_t *queryValues = nullptr;
+    size_t queryDimension = 0;
+    if (options.quantized) {
+        DecodeQuantizedVector(quantizedQuery, queryScale, unused, queryValues, queryDimension);
+    }
+    size_t keep = options.quantized ? options.k * kVectorRescoreFactor : options.k;
+    std::string prefix = (options.quantized ? QuantizedVectorPrefix() : VectorPrefix()) + options.prefix;
+    size_t namespaceSize = prefix.size() - options.prefix.size();
+
+    leveldb::ReadOptions readOptions = _readOptions;
+    readOptions.fill_cache = false;
+    readOptions.snapshot = _db->GetSnapshot();
+    size_t threads = options.threads > 0 ? options.threads : std::max(std::thread::hardware_concurrency(), 1u);
+    threads = std::min(threads, kMaxVectorSearchThreads);
+    KeyRange range;
+    range.start = prefix;
+    range.limit = PrefixSuccessor(prefix);
+    std::vector<KeyRange> parts = SplitRange(range, static_cast<int>(threads));
+    std::vector<std::vector<VectorMatch>> found(parts.size());
+    auto scanPart = [&](size_t index) {
+        const KeyRange &part = parts[index];
+        std::vector<VectorMatch> &heap = found[index];
+        std::vector<float> values;
+        leveldb::Iterator* it = _db->NewIterator(readOptions);
+        for (it->Seek(part.start); it->Valid() && _comparator->Compare(it->key(), part.limit) < 0; it->Next()) {
+            leveldb::Slice key = it->key();
+            key.remove_prefix(namespaceSize);
+            float norm = 0;
+            float result = 0;
+            if (options.quantized) {
+                float scale = 0;
+                const int8_t *stored = nullptr;
+                size_t storedDimension = 0;
+                if (!DecodeQuantizedVector(it->value(), scale, norm, stored, storedDimension) ||
+                    storedDimension != dimension) {
+                    continue;
+                }
+                float dot = scale * queryScale * kernels.dotInt8(stored, queryValues, dimension);
+                if (score(dot, norm * norm + queryNorm * queryNorm - 2 * dot, norm, result)) {
+                    offer(heap, keep, key, result);
+                }
+            } else if (DecodeVector(it->value(), norm, values) && values.size() == dimension) {
+                float dot = options.metric == kVectorL2 ? 0 : kernels.dot(values.data(), query.data(), dimension);
+                float squaredL2 = options.metric == kVectorL2
+                                      ? kernels.squaredL2(values.data(), query.data(), dimension) : 0;
+                if (score(dot, squaredL2, norm, result)) {
+                    offer(heap, keep, key, result);
+                }
+            }
+        }
+        delete it;
+    };
+    std::vector<std::thread> workers;
+    for (size_t index = 1; index < parts.size(); index++) {
+        workers.emplace_back(scanPart, index);
+    }
+    scanPart(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    std::vector<VectorMatch> candidates;
+    for (auto& heap : found) {
+        for (auto& match : heap) {
+            candidates.push_back(std::move(match));
+        }
+    }
+    if (options.quantized) {
+        // The approximate ranking only picks candidates; the float vectors
+        // decide the order.
+        std::vector<VectorMatch> rescored;
+        std::vector<float> values;
+        for (const auto& candidate : candidates) {
+            std::string value;
+            float norm = 0;
+            float result = 0;
+            if (!_db->Get(readOptions, VectorKey(candidate.key), &value).ok() ||
+                !DecodeVector(value, norm, values) || values.size() != dimension) {
+                continue;
+            }
+            float dot = kernels.dot(values.data(), query.data(), dimension);
+            float squaredL2 = options.metric == kVectorL2 ? kernels.squaredL2(values.data(), query.data(), dimension) : 0;
+            if (score(dot, squaredL2, norm, result)) {
+                offer(rescored, options.k, candidate.key, result);
+            }
+        }
+        candidates = std::move(rescored);
+    }
+    _db->ReleaseSnapshot(readOptions.snapshot);
+
+    std::sort(candidates.begin(), candidates.end(), better);
+    if (candidates.size() > options.k) {
+        candidates.resize(options.k);
+    }
+    if (options.metric == kVectorL2) {
+        for (auto& match : candidates) {
+            match.score = std::sqrt(-match.score);
+        }
+    }
+    return candidates;
+}
+
+bool LevelDB::PutPoint(const std::string &key, double lat, double lon) {
+    if (!IsValidGeoPoint(lat, lon)) {
+        return false;
+    }
+    std::string pointKey = GeoPointKey(key);
+    KeyLockGuard lock(*this, pointKey);
+    leveldb::WriteBatch batch;
+    std::string value;
+    double oldLat = 0;
+    double oldLon = 0;
+    if (_db->Get(_readOptions, pointKey, &value).ok() && DecodeGeoPoint(value, oldLat, oldLon)) {
+        batch.Delete(GeoCellKey(GeoCell(oldLat, oldLon), key));
+    }
+    value = EncodeGeoPoint(lat, lon);
+    batch.Put(pointKey, value);
+    batch.Put(GeoCellKey(GeoCell(lat, lon), key), value);
+    return Commit(batch);
+}
+
+bool LevelDB::GetPoint(const std::string &key, double &lat, double &lon) {
+    std::string value;
+    return _db->Get(_readOptions, GeoPointKey(key), &value).ok() && DecodeGeoPoint(value, lat, lon);
+}
+
+bool LevelDB::RemovePoint(const std::string &key) {
+    std::string pointKey = GeoPointKey(key);
+    KeyLockGuard lock(*this, pointKey);
+    std::string value;
+    double lat = 0;
+    double lon = 0;
+    if (!_db->Get(_readOptions, pointKey, &value).ok()) {
+        return true;
+    }
+    leveldb::WriteBatch batch;
+    batch.Delete(pointKey);
+    if (DecodeGeoPoint(value, lat, lon)) {
+        batch.Delete(GeoCellKey(GeoCell(lat, lon), key));
+    }
+    return Commit(batch);
+}
+
+void LevelDB::ScanGeoCells(const std::vector<GeoBox> &boxes, const std::string &prefix,
+                           const std::function<bool(GeoMatch &)> &visit) {
+    leveldb::ReadOptions readOptions = _readOptions;
+    readOptions.fill_cache = false;
+    leveldb::Iterator* it = _db->NewIterator(readOptions);
+    GeoMatch match;
+    for (const auto& range : CoverGeoBoxes(boxes, kMaxGeoCoverRanges)) {
+        for (it->Seek(GeoCellKey(range.first, std::string())); it->Valid(); it->Next()) {
+            uint64_t cell = 0;
+            leveldb::Slice key;
+            if (!DecodeGeoCellKey(it->key(), cell, key) || cell > range.last) {
+                break;
+            }
+            if (!key.starts_with(prefix) || !DecodeGeoPoint(it->value(), match.lat, match.lon) ||
+                !GeoBoxesContain(boxes, match.lat, match.lon)) {
+                continue;
+            }
+            match.key = key.ToString();
+            match.distance = 0;
+            if (!visit(match)) {
+                delete it;
+                return;
+            }
+        }
+    }
+    delete it;
+}
+
+std::vector<GeoMatch> LevelDB::QueryRadius(double lat, double lon, double radiusMeters,
+                                           const GeoQueryOptions &options) {
+    std::vector<GeoMatch> matches;
+    if (!IsValidGeoPoint(lat, lon) || !(radiusMeters >= 0)) {
+        return matches;
+    }
+    // The bounding boxes only narrow the scan; the distance decides.
+    ScanGeoCells(GeoBoxesAround(lat, lon, radiusMeters), options.prefix, [&](GeoMatch &match) {
+        match.distance = GeoDistance(lat, lon, match.lat, match.lon);
+        if (match.distance <= radiusMeters) {
+            matches.push_back(match);
+        }
+        return true;
+    });
+    std::sort(matches.begin(), matches.end(), [](const GeoMatch &a, const GeoMatch &b) {
+        return a.distance < b.distance || (a.distance == b.distance && a.key < b.key);
+    });
+    if (options.limit > 0 && matches.size() > options.limit) {
+        matches.resize(options.limit);
+    }
+    return matches;
+}
+
+std::vector<GeoMatch> LevelDB::QueryBox(const GeoBox &box, const GeoQueryOptions &options) {
+    std::vector<GeoMatch> matches;
+    if (!IsValidGeoBox(box)) {
+        return matches;
+    }
+    ScanGeoCells(SplitGeoBox(box), options.prefix, [&](GeoMatch &match) {
+        matches.push_back(match);
+        return options.limit == 0 || matches.size() < options.limit;
+    });
+    return matches;
+}
+
+void LevelDB::SetMergeCollapseThreshold(uint32_t threshold) {
+    std::lock_guard<std::mutex> lock(_mergeMutex);
+    _mergeCollapseThreshold = std::max<uint32_t>(threshold, 1);
+}
+
+void LevelDB::LoadPendingMerges() {
+    std::lock_guard<std::mutex> lock(_mergeMutex);
+    _pendingMerges.clear();
+    uint64_t maxSequence = 0;
+    leveldb::Iterator* it = _db->NewIterator(_readOptions);
+    for (it->Seek(kMergePrefix); it->Valid() && it->key().starts_with(kMergePrefix); it->Next()) {
+        leveldb::Slice deltaKey = it->key();
+        if (deltaKey.size() < kMergePrefix.size() + 12) {
+            continue;
+        }
+        uint32_t keySize = DecodeFixed32BE(deltaKey.data() + kMergePrefix.size());
+        if (deltaKey.size() != kMergePrefix.size() + 12 + keySize) {
+            continue;
+        }
+        _pendingMerges[std::string(deltaKey.data() + kMergePrefix.size() + 4, keySize)]++;
+        maxSequence = std::max(maxSequence, DecodeFixed64BE(deltaKey.data() + deltaKey.size() - 8));
+    }
+    delete it;
+    _pendingMergeKeys = _pendingMerges.size();
+    // Sequences only order the deltas of one key; starting above both the
+    // clock and every stored sequence keeps them increasing across restarts.
+    _mergeSequence = std::max<uint64_t>(maxSequence, static_cast<uint64_t>(NowMs()) * 1000);
+    for (const auto& entry : _pendingMerges) {
+        if (entry.second >= _mergeCollapseThreshold) {
+            _mergeCollapseQueued.insert(entry.first);
+            _mergeCollapseQueue.push_back(entry.first);
+        }
+    }
+}
+
+bool LevelDB::HasPendingMerges(const std::string &key) {
+    if (_pendingMergeKeys == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(_mergeMutex);
+    return _pendingMerges.find(key) != _pendingMerges.end();
+}
+
+bool LevelDB::FoldMerges(const std::string &key, bool exists, std::string &payload,
+                         std::vector<std::string> *deltaKeys) {
+    std::string prefix = MergeDeltaPrefix(key);
+    leveldb::Iterator* it = _db->NewIterator(_readOptions);
+    for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+        if (it->key().size() != prefix.size() + 8 || it->value().empty()) {
+            continue;
+        }
+        leveldb::Slice operand(it->value().data() + 1, it->value().size() - 1);
+        ApplyMerge(static_cast<MergeOperator>(it->value()[0]), operand, exists, payload);
+        if (deltaKeys) {
+            deltaKeys->push_back(it->key().ToString());
+        }
+    }
+    delete it;
+    return exists;
+}
+
+void LevelDB::StageDropMerges(leveldb::WriteBatch &batch, const std::string &key) {
+    if (!HasPendingMerges(key)) {
+        return;
+    }
+    std::string prefix = MergeDeltaPrefix(key);
+    leveldb::Iterator* it = _db->NewIterator(_readOptions);
+    for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+        batch.Delete(it->key());
+    }
+    delete it;
+}
+
+void LevelDB::ForgetMerges(const std::string &key) {
+    if (_pendingMergeKeys == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_mergeMutex);
+    if (_pendingMerges.erase(key) > 0) {
+        _pendingMergeKeys--;
+    }
+}
+
+void LevelDB::CollapseMerges(const std::string &key) {
+    KeyLockGuard lock(*this, key);
+    {
+        std::lock_guard<std::mutex> mergeLock(_mergeMutex);
+        _mergeCollapseQueued.erase(key);
+    }
+    std::string raw;
+    std::string payload;
+    ValueHeader header;
+    bool exists = false;
+    if (_db->Get(_readOptions, key, &raw).ok()) {
+        size_t offset = DecodeValueHeader(raw, header);
+        if (offset != std::string::npos && !IsExpired(header, NowMs())) {
+            payload = raw.substr(offset);
+            exists = ResolvePayload(key, payload, header);
+        }
+    }
+    if (!exists) {
+        header = ValueHeader();
+    }
+    ObjectPayloadToText(payload, header);
+    std::vector<std::string> deltaKeys;
+    exists = FoldMerges(key, exists, payload, &deltaKeys);
+    if (deltaKeys.empty()) {
+        ForgetMerges(key);
+        return;
+    }
+    leveldb::WriteBatch batch;
+    std::unique_lock<std::recursive_mutex> dedupLock(_dedupMutex, std::defer_lock);
+    if (exists && !StageUserValue(batch, key, payload, header, dedupLock)) {
+        return;
+    }
+    for (const auto& deltaKey : deltaKeys) {
+        batch.Delete(deltaKey);
+    }
+    if (Commit(batch)) {
+        ForgetMerges(key);
+        RecordTombstones(deltaKeys);
     }
 }
 
 bool LevelDB::Remove(const std::string &key) {
-    leveldb::Status status = _db->Delete(_writeOptions, key);
-    return status.ok();
+    leveldb::WriteBatch batch;
+    batch.Delete(key);
+    KeyLockGuard lock(*this, key);
+    StageIndexChange(batch, key, nullptr);
+    StageDropMerges(batch, key);
+    if (!Commit(batch)) {
+        return false;
+    }
+    ForgetMerges(key);
+    RecordTombstones({key});
+    return true;
 }
 
 bool LevelDB::Remove(const std::vector<std::string> &arrKeys) {
@@ -30,16 +2558,947 @@ bool LevelDB::Remove(const std::vector<std::string> &arrKeys) {
     for (const auto& key : arrKeys) {
         batch.Delete(key);
     }
-    leveldb::Status status = _db->Write(_writeOptions, &batch);
-    return status.ok();
+    KeyLockGuard lock(*this, arrKeys);
+    for (const auto& key : arrKeys) {
+        StageIndexChange(batch, key, nullptr);
+        StageDropMerges(batch, key);
+    }
+    if (!Commit(batch)) {
+        return false;
+    }
+    for (const auto& key : arrKeys) {
+        ForgetMerges(key);
+    }
+    RecordTombstones(arrKeys);
+    return true;
 }
 
 std::vector<std::string> LevelDB::GetAllKeys() {
     std::vector<std::string> keys;
+    int64_t now = NowMs();
     leveldb::Iterator* it = _db->NewIterator(_readOptions);
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    for (it->SeekToFirst(); it->Valid() && !IsInternalKey(it->key()); it->Next()) {
+        ValueHeader header;
+        if (DecodeValueHeader(it->value(), header) == std::string::npos || IsExpired(header, now)) {
+            continue;
+        }
         keys.push_back(it->key().ToString());
     }
     delete it;
+
+    // Keys that so far only exist as merge deltas.
+    if (_pendingMergeKeys > 0) {
+        std::vector<std::string> mergeKeys;
+        {
+            std::lock_guard<std::mutex> lock(_mergeMutex);
+            for (const auto& entry : _pendingMerges) {
+                mergeKeys.push_back(entry.first);
+            }
+        }
+        auto less = [this](const std::string &a, const std::string &b) { return KeyLess(a, b); };
+        size_t scanned = keys.size();
+        for (const auto& key : mergeKeys) {
+            if (!std::binary_search(keys.begin(), keys.begin() + scanned, key, less)) {
+                keys.push_back(key);
+            }
+        }
+        if (keys.size() > scanned) {
+            std::sort(keys.begin(), keys.end(), less);
+        }
+    }
     return keys;
+}
+
+static bool InScanBounds(const leveldb::Comparator *comparator, const ScanOptions &options,
+                         const leveldb::Slice &key) {
+    if (options.hasLower) {
+        int c = comparator->Compare(key, options.lower);
+        if (c < 0 || (c == 0 && !options.lowerInclusive)) {
+            return false;
+        }
+    }
+    if (options.hasUpper) {
+        int c = comparator->Compare(key, options.upper);
+        if (c > 0 || (c == 0 && !options.upperInclusive)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<ScanEntry> LevelDB::Scan(const ScanOptions &options) {
+    std::vector<ScanEntry> entries;
+    ScanEach(options, _readOptions, [&entries, &options](const leveldb::Slice &key, const leveldb::Slice &payload,
+                                                         bool isObject) {
+        ScanEntry entry;
+        entry.key = key.ToString();
+        entry.value = payload.ToString();
+        entry.isObject = isObject;
+        entries.push_back(std::move(entry));
+        return options.limit == 0 || entries.size() < options.limit;
+    });
+    return entries;
+}
+
+AggregateResult LevelDB::Aggregate(const ScanOptions &range, const AggregateOptions &options) {
+    AggregateResult result;
+    const HistogramOptions &histogram = options.histogram;
+    bool bucketed = histogram.buckets > 0 && histogram.max > histogram.min;
+    if (bucketed) {
+        result.histogram.assign(histogram.buckets, 0);
+    }
+    double bucketWidth = bucketed ? (histogram.max - histogram.min) / histogram.buckets : 0;
+    // Neumaier summation keeps long sums of small fractions accurate.
+    double compensation = 0;
+    uint64_t visited = 0;
+
+    leveldb::ReadOptions readOptions = _readOptions;
+    readOptions.fill_cache = false;
+    ScanEach(range, readOptions, [&](const leveldb::Slice &, const leveldb::Slice &payload, bool isObject) {
+        double value = 0;
+        if (!ExtractNumber(payload, isObject, options.field, value)) {
+            result.skipped++;
+        } else {
+            if (result.count == 0) {
+                result.min = value;
+                result.max = value;
+            } else {
+                result.min = std::min(result.min, value);
+                result.max = std::max(result.max, value);
+            }
+            result.count++;
+            double sum = result.sum + value;
+            if (std::fabs(result.sum) >= std::fabs(value)) {
+                compensation += (result.sum - sum) + value;
+            } else {
+                compensation += (value - sum) + result.sum;
+            }
+            result.sum = sum;
+            if (bucketed) {
+                if (value < histogram.min) {
+                    result.below++;
+                } else if (value >= histogram.max) {
+                    result.above++;
+                } else {
+                    size_t bucket = static_cast<size_t>((value - histogram.min) / bucketWidth);
+                    result.histogram[std::min(bucket, histogram.buckets - 1)]++;
+                }
+            }
+        }
+        return range.limit == 0 || ++visited < range.limit;
+    });
+    result.sum += compensation;
+    return result;
+}
+
+void LevelDB::ScanEach(const ScanOptions &options, const leveldb::ReadOptions &readOptions,
+                       const ScanVisitor &visit) {
+    int64_t now = NowMs();
+
+    // Keys that so far only exist as merge deltas are not in the iterator;
+    // they are interleaved in scan order.
+    std::vector<std::string> mergeKeys;
+    if (_pendingMergeKeys > 0) {
+        std::lock_guard<std::mutex> lock(_mergeMutex);
+        for (const auto& entry : _pendingMerges) {
+            if (leveldb::Slice(entry.first).starts_with(options.prefix) &&
+                InScanBounds(_comparator, options, entry.first)) {
+                mergeKeys.push_back(entry.first);
+            }
+        }
+    }
+    std::sort(mergeKeys.begin(), mergeKeys.end(),
+              [this](const std::string &a, const std::string &b) { return KeyLess(a, b); });
+    if (options.reverse) {
+        std::reverse(mergeKeys.begin(), mergeKeys.end());
+    }
+
+    // Keys sharing a prefix are only contiguous in bytewise order; under other
+    // comparators the prefix merely filters.
+    bool prefixBounds = !options.prefix.empty() && _comparator == leveldb::BytewiseComparator();
+    leveldb::Iterator* it = _db->NewIterator(readOptions);
+    if (!options.reverse) {
+        if (prefixBounds && (!options.hasLower || KeyLess(options.lower, options.prefix))) {
+            it->Seek(options.prefix);
+        } else if (options.hasLower) {
+            it->Seek(options.lower);
+        } else {
+            it->SeekToFirst();
+        }
+    } else {
+        // Position on the last key at or below the tightest upper bound.
+        std::string upper = kInternalKeyPrefix;
+        bool inclusive = false;
+        std::string prefixLimit = prefixBounds ? PrefixSuccessor(options.prefix) : std::string();
+        if (!prefixLimit.empty() && KeyLess(prefixLimit, upper)) {
+            upper = prefixLimit;
+        }
+        if (options.hasUpper && !KeyLess(upper, options.upper)) {
+            inclusive = options.upperInclusive && KeyLess(options.upper, upper);
+            upper = options.upper;
+        }
+        it->Seek(upper);
+        if (!it->Valid()) {
+            it->SeekToLast();
+        }
+        while (it->Valid()) {
+            int c = _comparator->Compare(it->key(), upper);
+            if (c < 0 || (c == 0 && inclusive)) {
+                break;
+            }
+            it->Prev();
+        }
+    }
+
+    auto before = [this, &options](const std::string &a, const leveldb::Slice &b) {
+        int c = _comparator->Compare(a, b);
+        return options.reverse ? c > 0 : c < 0;
+    };
+    bool projecting = !options.project.empty();
+    auto emit = [&options, &visit, projecting](const leveldb::Slice &key, const leveldb::Slice &payload,
+                                               bool isObject) {
+        if (!projecting) {
+            return visit(key, payload, isObject);
+        }
+        JsonValue record;
+        std::string encoded;
+        ProjectFields(options.project, payload, isObject, record);
+        EncodeObject(record, encoded);
+        return visit(key, encoded, true);
+    };
+    size_t nextMergeKey = 0;
+    bool more = true;
+    while (more) {
+        bool fromIterator = it->Valid() && !IsInternalKey(it->key());
+        if (fromIterator && !InScanBounds(_comparator, options, it->key())) {
+            // Skips the exclusive lower bound; anything else is past the end.
+            if (!options.reverse && options.hasLower && it->key() == options.lower) {
+                it->Next();
+                continue;
+            }
+            fromIterator = false;
+        } else if (fromIterator && !it->key().starts_with(options.prefix)) {
+            if (prefixBounds) {
+                fromIterator = false;
+            } else {
+                if (options.reverse) {
+                    it->Prev();
+                } else {
+                    it->Next();
+                }
+                continue;
+            }
+        }
+        bool fromMerges = nextMergeKey < mergeKeys.size();
+        if (!fromIterator && !fromMerges) {
+            break;
+        }
+
+        if (fromMerges && (!fromIterator || before(mergeKeys[nextMergeKey], it->key()))) {
+            const std::string &key = mergeKeys[nextMergeKey++];
+            std::string payload;
+            ValueHeader header;
+            if (ReadValue(key, payload, header) && MatchesWhere(options.where, payload, false)) {
+                more = emit(key, payload, false);
+            }
+            continue;
+        }
+        leveldb::Slice key = it->key();
+        if (fromMerges && mergeKeys[nextMergeKey] == key) {
+            nextMergeKey++;
+        }
+        ValueHeader header;
+        size_t offset = DecodeValueHeader(it->value(), header);
+        bool exists = offset != std::string::npos && !IsExpired(header, now);
+        leveldb::Slice payload = it->value();
+        payload.remove_prefix(exists ? offset : payload.size());
+        bool merges = _pendingMergeKeys > 0 && HasPendingMerges(key.ToString());
+        std::string resolved;
+        if (exists && (header.flags & kStoredValueFlags)) {
+            resolved = payload.ToString();
+            exists = ResolvePayload(key.ToString(), resolved, header, projecting && !merges);
+            payload = exists ? leveldb::Slice(resolved) : leveldb::Slice();
+        }
+        if (merges) {
+            std::string folded = payload.ToString();
+            ObjectPayloadToText(folded, header);
+            if (FoldMerges(key.ToString(), exists, folded, nullptr) && MatchesWhere(options.where, folded, false)) {
+                more = emit(key, folded, false);
+            }
+        } else if (exists && (header.flags & kValueFlagPacked)) {
+            // Only left packed for a projection: predicates and the result
+            // read just the columns they name.
+            std::shared_ptr<const RecordSchema> schema = PackedSchema(payload);
+            JsonValue record;
+            auto lookup = [&schema, &payload](const std::string &path, JsonValue &value) {
+                return FindPackedField(*schema, payload, path, value);
+            };
+            if (schema && MatchesWhere(options.where, lookup) &&
+                ProjectPackedRecord(*schema, payload, options.project, record)) {
+                std::string encoded;
+                EncodeObject(record, encoded);
+                more = visit(key, encoded, true);
+            }
+        } else if (exists && MatchesWhere(options.where, payload, (header.flags & kValueFlagObject) != 0)) {
+            // Values are handed out as slices of the iterator; only what the
+            // visitor keeps gets copied.
+            more = emit(key, payload, (header.flags & kValueFlagObject) != 0);
+        }
+        if (options.reverse) {
+            it->Prev();
+        } else {
+            it->Next();
+        }
+    }
+    delete it;
+}
+
+bool LevelDB::GetProperty(const std::string &name, std::string &value) {
+    return _db->GetProperty(name, &value);
+}
+
+// Parses the per-level table printed by "leveldb.stats":
+//   Level  Files Size(MB) Time(sec) Read(MB) Write(MB)
+//   --------------------------------------------------
+//     0        2        0         0        0         0
+static std::vector<LevelStats> ParseLevelStats(const std::string &stats) {
+    std::vector<LevelStats> levels;
+    std::istringstream iss(stats);
+    std::string line;
+    bool inTable = false;
+    while (std::getline(iss, line)) {
+        if (!inTable) {
+            inTable = line.compare(0, 3, "---") == 0;
+            continue;
+        }
+        LevelStats level;
+        if (sscanf(line.c_str(), "%d %d %lf %lf %lf %lf", &level.level, &level.files, &level.sizeMB,
+                   &level.timeSec, &level.readMB, &level.writeMB) == 6) {
+            levels.push_back(level);
+        }
+    }
+    return levels;
+}
+
+DBStats LevelDB::GetStats() {
+    DBStats result;
+    std::string value;
+    for (int level = 0; level < kNumLevels; level++) {
+        int files = 0;
+        if (_db->GetProperty("leveldb.num-files-at-level" + std::to_string(level), &value)) {
+            files = atoi(value.c_str());
+        }
+        result.filesAtLevel.push_back(files);
+    }
+    if (_db->GetProperty("leveldb.approximate-memory-usage", &value)) {
+        result.approximateMemoryUsage = strtoull(value.c_str(), nullptr, 10);
+    }
+    _db->GetProperty("leveldb.stats", &result.stats);
+    _db->GetProperty("leveldb.sstables", &result.sstables);
+    result.levels = ParseLevelStats(result.stats);
+    return result;
+}
+
+std::vector<uint64_t> LevelDB::GetApproximateSizes(const std::vector<KeyRange> &ranges) {
+    std::vector<uint64_t> sizes(ranges.size(), 0);
+    if (ranges.empty()) {
+        return sizes;
+    }
+    std::vector<leveldb::Range> dbRanges;
+    dbRanges.reserve(ranges.size());
+    for (const auto& range : ranges) {
+        dbRanges.emplace_back(range.start, range.limit.empty() ? kMaxKey : range.limit);
+    }
+    _db->GetApproximateSizes(dbRanges.data(), static_cast<int>(dbRanges.size()), sizes.data());
+    return sizes;
+}
+
+static std::string UnescapeDebugKey(const std::string &escaped) {
+    std::string key;
+    key.reserve(escaped.size());
+    for (size_t i = 0; i < escaped.size(); i++) {
+        if (escaped[i] == '\\' && i + 3 < escaped.size() && escaped[i + 1] == 'x') {
+            key.push_back(static_cast<char>(strtoul(escaped.substr(i + 2, 2).c_str(), nullptr, 16)));
+            i += 3;
+        } else {
+            key.push_back(escaped[i]);
+        }
+    }
+    return key;
+}
+
+// Collects the largest user key of every table listed by "leveldb.sstables":
+//   --- level 1 ---
+//    12:2097152['a' @ 5 : 1 .. 'm' @ 9 : 1]
+static std::vector<std::string> ParseTableBoundaries(const std::string &sstables) {
+    std::vector<std::string> boundaries;
+    std::istringstream iss(sstables);
+    std::string line;
+    while (std::getline(iss, line)) {
+        size_t begin = line.find(" .. '");
+        if (begin == std::string::npos) {
+            continue;
+        }
+        begin += 5;
+        size_t end = line.rfind("' @ ");
+        if (end == std::string::npos || end < begin) {
+            continue;
+        }
+        boundaries.push_back(UnescapeDebugKey(line.substr(begin, end - begin)));
+    }
+    return boundaries;
+}
+
+std::vector<KeyRange> LevelDB::SplitRange(const KeyRange &range, int maxParts) {
+    std::string sstables;
+    _db->GetProperty("leveldb.sstables", &sstables);
+    std::vector<std::string> boundaries = ParseTableBoundaries(sstables);
+    std::sort(boundaries.begin(), boundaries.end(),
+              [this](const std::string &a, const std::string &b) { return KeyLess(a, b); });
+    boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+    boundaries.erase(std::remove_if(boundaries.begin(), boundaries.end(), [this, &range](const std::string &key) {
+        return (!range.start.empty() && !KeyLess(range.start, key)) ||
+               (!range.limit.empty() && !KeyLess(key, range.limit));
+    }), boundaries.end());
+
+    std::vector<std::string> splits;
+    size_t parts = std::min(boundaries.size() + 1, static_cast<size_t>(std::max(maxParts, 1)));
+    for (size_t i = 1; i < parts; i++) {
+        splits.push_back(boundaries[i * boundaries.size() / parts]);
+    }
+
+    std::vector<KeyRange> result;
+    std::string start = range.start;
+    for (const auto& split : splits) {
+        result.push_back({start, split});
+        start = split;
+    }
+    result.push_back({start, range.limit});
+    return result;
+}
+
+void LevelDB::CompactSubRange(const KeyRange &range) {
+    leveldb::Slice begin(range.start);
+    leveldb::Slice end(range.limit);
+    _db->CompactRange(range.start.empty() ? nullptr : &begin, range.limit.empty() ? nullptr : &end);
+}
+
+CompactionResult LevelDB::CompactRange(const KeyRange &range, uint64_t cancelEpoch,
+                                       const CompactionProgress &progress) {
+    CompactionResult result;
+    result.sizeBefore = GetApproximateSizes({range})[0];
+
+    std::vector<KeyRange> parts = SplitRange(range, kMaxCompactionRanges);
+    result.totalRanges = static_cast<int>(parts.size());
+    for (const auto& part : parts) {
+        if (_closing || _compactionEpoch != cancelEpoch) {
+            result.cancelled = true;
+            break;
+        }
+        CompactSubRange(part);
+        result.completedRanges++;
+        if (progress) {
+            progress(result.completedRanges, result.totalRanges);
+        }
+    }
+
+    result.sizeAfter = GetApproximateSizes({range})[0];
+    return result;
+}
+
+uint64_t LevelDB::CompactionEpoch() const {
+    return _compactionEpoch;
+}
+
+void LevelDB::CancelCompaction() {
+    std::lock_guard<std::mutex> lock(_maintenanceMutex);
+    _compactionEpoch++;
+    if (!_idleCompactionPlan.empty()) {
+        _idleCompactionPlan.clear();
+        _lastIdleCompaction = std::chrono::steady_clock::now();
+    }
+}
+
+bool LevelDB::RetainTask() {
+    std::lock_guard<std::mutex> lock(_maintenanceMutex);
+    if (_closing || !_db) {
+        return false;
+    }
+    _runningTasks++;
+    return true;
+}
+
+void LevelDB::ReleaseTask() {
+    std::lock_guard<std::mutex> lock(_maintenanceMutex);
+    _runningTasks--;
+    _maintenanceCond.notify_all();
+}
+
+void LevelDB::SetIdleCompaction(bool enabled, int64_t intervalMs, int maxRanges) {
+    {
+        std::lock_guard<std::mutex> lock(_maintenanceMutex);
+        if (enabled && !_idleCompactionEnabled) {
+            // The first pass is due as soon as the device becomes idle.
+            _lastIdleCompaction = std::chrono::steady_clock::now() - std::chrono::milliseconds(intervalMs);
+        }
+        if (!enabled) {
+            _idleCompactionPlan.clear();
+        }
+        _idleCompactionEnabled = enabled;
+        _idleCompactionIntervalMs = std::max<int64_t>(intervalMs, 0);
+        _idleCompactionMaxRanges = maxRanges > 0 ? maxRanges : kMaxCompactionRanges;
+        _maintenanceCond.notify_all();
+    }
+    if (enabled) {
+        EnsureMaintenanceThread();
+    }
+}
+
+void LevelDB::ReportDeviceState(bool idle, bool charging) {
+    std::lock_guard<std::mutex> lock(_maintenanceMutex);
+    _deviceIdle = idle;
+    _deviceCharging = charging;
+    _maintenanceCond.notify_all();
+}
+
+void LevelDB::EnsureMaintenanceThread() {
+    std::lock_guard<std::mutex> lock(_maintenanceMutex);
+    if (_maintenanceThread.joinable() || _closing || !_db) {
+        return;
+    }
+    _maintenanceStop = false;
+    _maintenanceThread = std::thread(&LevelDB::MaintenanceLoop, this);
+}
+
+void LevelDB::StopMaintenanceThread() {
+    {
+        std::lock_guard<std::mutex> lock(_maintenanceMutex);
+        _maintenanceStop = true;
+        _maintenanceCond.notify_all();
+    }
+    if (_maintenanceThread.joinable()) {
+        _maintenanceThread.join();
+    }
+}
+
+void LevelDB::ScheduleCompaction(const KeyRange &range) {
+    {
+        std::lock_guard<std::mutex> lock(_maintenanceMutex);
+        _pendingCompactions.push_back(range);
+        _maintenanceCond.notify_all();
+    }
+    EnsureMaintenanceThread();
+}
+
+void LevelDB::SetTombstoneCompaction(bool enabled, uint64_t threshold, const std::string &delimiters) {
+    std::lock_guard<std::mutex> lock(_tombstoneMutex);
+    _tombstoneTracking = enabled;
+    _tombstoneThreshold = std::max<uint64_t>(threshold, 1);
+    _tombstoneDelimiters = delimiters;
+    if (!enabled) {
+        _tombstones.clear();
+    }
+}
+
+std::vector<TombstoneRange> LevelDB::GetTombstoneStats() {
+    std::lock_guard<std::mutex> lock(_tombstoneMutex);
+    std::vector<TombstoneRange> result;
+    result.reserve(_tombstones.size());
+    for (const auto& entry : _tombstones) {
+        result.push_back(entry.second);
+    }
+    return result;
+}
+
+void LevelDB::RecordTombstones(const std::vector<std::string> &keys) {
+    std::vector<KeyRange> ready;
+    {
+        std::lock_guard<std::mutex> lock(_tombstoneMutex);
+        if (!_tombstoneTracking) {
+            return;
+        }
+        for (const auto& key : keys) {
+            size_t pos = key.find_first_of(_tombstoneDelimiters);
+            std::string prefix = pos == std::string::npos ? std::string() : key.substr(0, pos + 1);
+            if (_tombstones.size() >= kMaxTombstonePrefixes && _tombstones.find(prefix) == _tombstones.end()) {
+                prefix.clear();
+            }
+            TombstoneRange &range = _tombstones[prefix];
+            if (range.count == 0) {
+                range.prefix = prefix;
+                range.start = key;
+                range.limit = key;
+            } else if (KeyLess(key, range.start)) {
+                range.start = key;
+            } else if (KeyLess(range.limit, key)) {
+                range.limit = key;
+            }
+            if (++range.count >= _tombstoneThreshold) {
+                ready.push_back({range.start, range.limit});
+                _tombstones.erase(prefix);
+            }
+        }
+    }
+    for (const auto& range : ready) {
+        ScheduleCompaction(range);
+    }
+}
+
+void LevelDB::ActivateExpirySweep() {
+    if (_expirySweepActive) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_maintenanceMutex);
+        _expirySweepActive = true;
+        _nextExpirySweep = std::chrono::steady_clock::now() + std::chrono::milliseconds(_expirySweepIntervalMs);
+        _maintenanceCond.notify_all();
+    }
+    EnsureMaintenanceThread();
+}
+
+void LevelDB::SetExpirySweep(int64_t intervalMs, size_t batchSize) {
+    std::lock_guard<std::mutex> lock(_maintenanceMutex);
+    _expirySweepIntervalMs = std::max<int64_t>(intervalMs, 1);
+    _expirySweepBatchSize = std::max<size_t>(batchSize, 1);
+    _nextExpirySweep = std::chrono::steady_clock::now() + std::chrono::milliseconds(_expirySweepIntervalMs);
+    _maintenanceCond.notify_all();
+}
+
+size_t LevelDB::SweepExpired(size_t maxKeys) {
+    size_t batchSize;
+    {
+        std::lock_guard<std::mutex> lock(_maintenanceMutex);
+        batchSize = _expirySweepBatchSize;
+    }
+    size_t removed = 0;
+    leveldb::ReadOptions scanOptions;
+    scanOptions.fill_cache = false;
+    while (!_closing) {
+        size_t limit = maxKeys == 0 ? batchSize : std::min(batchSize, maxKeys - removed);
+        int64_t now = NowMs();
+        std::vector<std::string> indexKeys;
+        leveldb::Iterator* it = _db->NewIterator(scanOptions);
+        for (it->Seek(kExpiryIndexPrefix); it->Valid() && indexKeys.size() < limit; it->Next()) {
+            leveldb::Slice indexKey = it->key();
+            if (!indexKey.starts_with(kExpiryIndexPrefix) || indexKey.size() < kExpiryIndexPrefix.size() + 8) {
+                break;
+            }
+            int64_t expiresAt = static_cast<int64_t>(DecodeFixed64BE(indexKey.data() + kExpiryIndexPrefix.size()));
+            if (expiresAt > now) {
+                break;
+            }
+            indexKeys.push_back(indexKey.ToString());
+        }
+        delete it;
+        if (indexKeys.empty()) {
+            break;
+        }
+
+        // The index may be stale: the key could have been rewritten with a
+        // later expiry or without one, so the live value decides.
+        std::vector<std::string> keys;
+        for (const auto& indexKey : indexKeys) {
+            keys.push_back(indexKey.substr(kExpiryIndexPrefix.size() + 8));
+        }
+        KeyLockGuard lock(*this, keys);
+        leveldb::WriteBatch batch;
+        std::vector<std::string> deleted;
+        for (size_t i = 0; i < indexKeys.size(); i++) {
+            const std::string &key = keys[i];
+            batch.Delete(indexKeys[i]);
+            std::string raw;
+            ValueHeader header;
+            if (_db->Get(_readOptions, key, &raw).ok() && DecodeValueHeader(raw, header) != std::string::npos &&
+                IsExpired(header, now)) {
+                StageIndexChange(batch, key, nullptr);
+                batch.Delete(key);
+                // Pending merge operands would otherwise bring the key back.
+                StageDropMerges(batch, key);
+                deleted.push_back(key);
+            }
+        }
+        if (!Commit(batch)) {
+            break;
+        }
+        for (const auto& key : deleted) {
+            ForgetMerges(key);
+        }
+        removed += deleted.size();
+        deleted.insert(deleted.end(), indexKeys.begin(), indexKeys.end());
+        RecordTombstones(deleted);
+        if (indexKeys.size() < limit || (maxKeys != 0 && removed >= maxKeys)) {
+            break;
+        }
+    }
+    return removed;
+}
+
+void LevelDB::RecordWriteLatency(double latencyUs) {
+    auto now = std::chrono::steady_clock::now();
+    bool slow = false;
+    {
+        std::lock_guard<std::mutex> lock(_pressureMutex);
+        _writeLatencyEwmaUs = _writeLatencyEwmaUs == 0 ? latencyUs : _writeLatencyEwmaUs * 0.9 + latencyUs * 0.1;
+        if (latencyUs >= _recentMaxLatencyUs || now - _recentMaxLatencyAt > std::chrono::milliseconds(kLatencyWindowMs)) {
+            _recentMaxLatencyUs = latencyUs;
+            _recentMaxLatencyAt = now;
+        }
+        slow = latencyUs >= kHighLatencyUs && _pressureListener;
+    }
+    if (slow) {
+        // Re-evaluate right away instead of waiting for the next poll.
+        std::lock_guard<std::mutex> lock(_maintenanceMutex);
+        _nextPressurePoll = now;
+        _maintenanceCond.notify_all();
+    }
+}
+
+BlobGcResult LevelDB::CollectBlobGarbage(bool sealActive) {
+    std::lock_guard<std::mutex> gcLock(_blobGcMutex);
+    BlobGcResult result;
+    if (sealActive) {
+        _blobs.Seal();
+    }
+    leveldb::ReadOptions readOptions = _readOptions;
+    readOptions.fill_cache = false;
+    // The old file goes away right after the batch, so the moved pointers
+    // must not be lost in a crash.
+    leveldb::WriteOptions writeOptions = _writeOptions;
+    writeOptions.sync = true;
+    for (const auto& file : _blobs.SealedFiles()) {
+        if (_closing) {
+            break;
+        }
+        // A record is live while the LSM value of its key points at it.
+        std::vector<std::pair<BlobPointer, std::string>> live;
+        uint64_t liveBytes = 0;
+        _blobs.ForEachRecord(file.number, [&](const BlobPointer &pointer, const std::string &key) {
+            std::string raw;
+            if (_db->Get(readOptions, key, &raw).ok() && PointsAt(raw, pointer)) {
+                liveBytes += BlobRecordSize(pointer);
+                live.emplace_back(pointer, key);
+            }
+            return !_closing;
+        });
+        if (_closing || (file.size > 0 && liveBytes >= file.size * _blobGcRatio)) {
+            continue;
+        }
+
+        bool moved = true;
+        for (size_t begin = 0; begin < live.size() && moved; begin += kBlobGcBatchSize) {
+            size_t end = std::min(live.size(), begin + kBlobGcBatchSize);
+            std::vector<std::string> keys;
+            for (size_t i = begin; i < end; i++) {
+                keys.push_back(live[i].second);
+            }
+            KeyLockGuard lock(*this, keys);
+            // Shared values are removed without their key stripes being held.
+            std::unique_lock<std::recursive_mutex> dedupLock(_dedupMutex, std::defer_lock);
+            if (_dedupActive) {
+                dedupLock.lock();
+            }
+            leveldb::WriteBatch batch;
+            for (size_t i = begin; i < end && moved; i++) {
+                const BlobPointer &pointer = live[i].first;
+                const std::string &key = live[i].second;
+                std::string raw;
+                std::string value;
+                if (!_db->Get(_readOptions, key, &raw).ok() || !PointsAt(raw, pointer)) {
+                    // Overwritten or removed since the file was scanned.
+                    continue;
+                }
+                if (!_blobs.Read(pointer, key, value)) {
+                    moved = false;
+                    break;
+                }
+                ValueHeader header;
+                DecodeValueHeader(raw, header);
+                BlobPointer target;
+                if (_blobThreshold > 0 && value.size() >= _blobThreshold) {
+                    moved = _blobs.Append(key, value, target);
+                    StageValue(batch, key, EncodeBlobPointer(target), header);
+                } else {
+                    header.flags &= ~kValueFlagBlob;
+                    StageValue(batch, key, value, header);
+                }
+                result.bytesMoved += value.size();
+            }
+            // The value itself is unchanged, so versions and the access order
+            // are left alone.
+            moved = moved && _blobs.Sync() && _db->Write(writeOptions, &batch).ok();
+        }
+        if (moved) {
+            _blobs.RemoveFile(file.number);
+            result.filesRewritten++;
+            result.bytesReclaimed += file.size - liveBytes;
+        }
+    }
+    return result;
+}
+
+uint64_t LevelDB::MemtableBytes() {
+    std::string value;
+    if (!_db->GetProperty("leveldb.approximate-memory-usage", &value)) {
+        return 0;
+    }
+    // The property also counts the block cache.
+    uint64_t usage = strtoull(value.c_str(), nullptr, 10);
+    uint64_t cacheUsage = _blockCache ? _blockCache->TotalCharge() : 0;
+    return usage > cacheUsage ? usage - cacheUsage : 0;
+}
+
+WritePressure LevelDB::GetWritePressure() {
+    WritePressure pressure;
+    std::string value;
+    if (_db->GetProperty("leveldb.num-files-at-level0", &value)) {
+        pressure.l0Files = atoi(value.c_str());
+    }
+    pressure.memtableBytes = MemtableBytes();
+    pressure.writeBufferSize = _writeBufferSize;
+    {
+        std::lock_guard<std::mutex> lock(_pressureMutex);
+        pressure.avgWriteLatencyUs = _writeLatencyEwmaUs;
+        bool recent = std::chrono::steady_clock::now() - _recentMaxLatencyAt <=
+                      std::chrono::milliseconds(kLatencyWindowMs);
+        pressure.maxWriteLatencyUs = recent ? _recentMaxLatencyUs : 0;
+    }
+
+    // Both the active and the immutable memtable are full: the next write
+    // waits for the flush.
+    bool memtableFull = pressure.writeBufferSize > 0 && pressure.memtableBytes >= 2 * pressure.writeBufferSize;
+    if (pressure.l0Files >= kL0CriticalFiles || pressure.maxWriteLatencyUs >= kCriticalLatencyUs) {
+        pressure.level = 3;
+    } else if (pressure.l0Files >= kL0SlowdownTrigger || memtableFull ||
+               pressure.avgWriteLatencyUs >= kHighLatencyUs) {
+        pressure.level = 2;
+    } else if (pressure.l0Files >= kL0CompactionTrigger || pressure.avgWriteLatencyUs >= kElevatedLatencyUs) {
+        pressure.level = 1;
+    }
+    return pressure;
+}
+
+void LevelDB::SetWritePressureListener(const WritePressureListener &listener) {
+    {
+        std::lock_guard<std::mutex> lock(_pressureMutex);
+        _pressureListener = listener;
+        _lastPressureLevel = 0;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_maintenanceMutex);
+        _pressurePolling = listener != nullptr;
+        _nextPressurePoll = std::chrono::steady_clock::now();
+        _maintenanceCond.notify_all();
+    }
+    if (listener) {
+        EnsureMaintenanceThread();
+    }
+}
+
+void LevelDB::EvaluateWritePressure() {
+    WritePressure pressure = GetWritePressure();
+    WritePressureListener listener;
+    {
+        std::lock_guard<std::mutex> lock(_pressureMutex);
+        if (!_pressureListener || pressure.level == _lastPressureLevel) {
+            return;
+        }
+        _lastPressureLevel = pressure.level;
+        listener = _pressureListener;
+    }
+    listener(pressure);
+}
+
+void LevelDB::MaintenanceLoop() {
+    std::unique_lock<std::mutex> lock(_maintenanceMutex);
+    while (!_maintenanceStop) {
+        auto now = std::chrono::steady_clock::now();
+        if (_pressurePolling && now >= _nextPressurePoll) {
+            _nextPressurePoll = now + std::chrono::milliseconds(kPressurePollMs);
+            lock.unlock();
+            EvaluateWritePressure();
+            lock.lock();
+            continue;
+        }
+        if (!_mergeCollapseQueue.empty()) {
+            std::string key = _mergeCollapseQueue.front();
+            _mergeCollapseQueue.pop_front();
+            lock.unlock();
+            CollapseMerges(key);
+            lock.lock();
+            continue;
+        }
+        if (_expirySweepActive && now >= _nextExpirySweep) {
+            _nextExpirySweep = now + std::chrono::milliseconds(_expirySweepIntervalMs);
+            lock.unlock();
+            SweepExpired();
+            lock.lock();
+            continue;
+        }
+        if (_cacheMaxBytes > 0 && now >= _nextCacheCheck) {
+            _nextCacheCheck = now + std::chrono::milliseconds(kCacheCheckIntervalMs);
+            lock.unlock();
+            EnforceCacheLimit();
+            lock.lock();
+            continue;
+        }
+        if (_blobGcActive && now >= _nextBlobGc) {
+            _nextBlobGc = now + std::chrono::milliseconds(kBlobGcIntervalMs);
+            lock.unlock();
+            CollectBlobGarbage();
+            lock.lock();
+            continue;
+        }
+        if (!_pendingCompactions.empty()) {
+            KeyRange range = _pendingCompactions.front();
+            _pendingCompactions.pop_front();
+            lock.unlock();
+            CompactSubRange(range);
+            lock.lock();
+            continue;
+        }
+        bool deviceReady = _deviceIdle || _deviceCharging;
+        auto interval = std::chrono::milliseconds(_idleCompactionIntervalMs);
+        auto nextPass = _lastIdleCompaction + interval;
+        auto wakeAt = std::chrono::steady_clock::time_point::max();
+        if (_idleCompactionEnabled && deviceReady) {
+            if (_idleCompactionPlan.empty() && std::chrono::steady_clock::now() >= nextPass) {
+                int maxRanges = _idleCompactionMaxRanges;
+                lock.unlock();
+                std::vector<KeyRange> plan = SplitRange(KeyRange(), maxRanges);
+                lock.lock();
+                _idleCompactionPlan.assign(plan.begin(), plan.end());
+            }
+            if (!_idleCompactionPlan.empty()) {
+                // One sub-range at a time so a busy device preempts the pass.
+                KeyRange range = _idleCompactionPlan.front();
+                _idleCompactionPlan.pop_front();
+                lock.unlock();
+                CompactSubRange(range);
+                lock.lock();
+                if (_idleCompactionPlan.empty()) {
+                    _lastIdleCompaction = std::chrono::steady_clock::now();
+                }
+                continue;
+            }
+            wakeAt = nextPass;
+        }
+        if (_pressurePolling) {
+            wakeAt = std::min(wakeAt, _nextPressurePoll);
+        }
+        if (_expirySweepActive) {
+            wakeAt = std::min(wakeAt, _nextExpirySweep);
+        }
+        if (_cacheMaxBytes > 0) {
+            wakeAt = std::min(wakeAt, _nextCacheCheck);
+        }
+        if (_blobGcActive) {
+            wakeAt = std::min(wakeAt, _nextBlobGc);
+        }
+        if (wakeAt == std::chrono::steady_clock::time_point::max()) {
+            _maintenanceCond.wait(lock);
+        } else {
+            _maintenanceCond.wait_until(lock, wakeAt);
+        }
+    }
 }
\ No newline at end of file
@@ -4,35 +4,604 @@
 // Node APIs are not fully supported. To solve the compilation error of the interface cannot be found,
 // please include "napi/native_api.h".
 
+#ifndef LEVELDB_LEVELDB_H
+#define LEVELDB_LEVELDB_H
+
 #include <string>
 #include <vector>
+#include <leveldb/cache.h>
 #include <leveldb/db.h>
 #include <leveldb/write_batch.h>
+#include "AccessOrder.h"
+#include "BlobStore.h"
+#include "Completion.h"
+#include "Compression.h"
+#include "Coding.h"
+#include "Dedup.h"
+#include "Geo.h"
+#include "Json.h"
+#include "ScanFilter.h"
+#include "SecondaryIndex.h"
+#include "Queue.h"
+#include "Schema.h"
+#include "SortedSet.h"
+#include "TagIndex.h"
+#include "Vector.h"
 #include <sstream>
 #include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+struct KeyRange {
+    std::string start;
+    std::string limit;
+};
+
+struct LevelStats {
+    int level = 0;
+    int files = 0;
+    double sizeMB = 0;
+    double timeSec = 0;
+    double readMB = 0;
+    double writeMB = 0;
+};
+
+struct DBStats {
+    std::vector<int> filesAtLevel;
+    std::vector<LevelStats> levels;
+    uint64_t approximateMemoryUsage = 0;
+    std::string stats;
+    std::string sstables;
+};
+
+struct CompactionResult {
+    uint64_t sizeBefore = 0;
+    uint64_t sizeAfter = 0;
+    int totalRanges = 0;
+    int completedRanges = 0;
+    bool cancelled = false;
+};
+
+struct TombstoneRange {
+    std::string prefix;
+    uint64_t count = 0;
+    std::string start;
+    std::string limit;
+};
+
+enum MergeOperator : uint8_t {
+    kMergeAdd = 1,
+    kMergeMax = 2,
+    kMergeAppend = 3,
+};
+
+// 0: normal, 1: elevated (compaction is behind), 2: high (leveldb is
+// slowing writers down), 3: critical (writers are about to block).
+struct WritePressure {
+    int level = 0;
+    int l0Files = 0;
+    uint64_t memtableBytes = 0;
+    uint64_t writeBufferSize = 0;
+    double avgWriteLatencyUs = 0;
+    double maxWriteLatencyUs = 0;
+};
+
+struct OpenOptions {
+    // Built-in comparator id (see Comparators.h); empty means bytewise. leveldb
+    // records the comparator name and refuses to reopen with another one.
+    std::string comparator;
+    // Cache mode when > 0: once the approximate on-disk size exceeds maxBytes,
+    // the least recently used (or oldest written) keys are evicted in the
+    // background. The access order is only kept while open in cache mode.
+    uint64_t maxBytes = 0;
+    CacheEviction eviction = kCacheEvictLru;
+    // Values of at least blobThreshold bytes (0 disables) are written to
+    // append-only blob files next to the database and the LSM only keeps a
+    // pointer, so compaction no longer rewrites them. A sealed blob file is
+    // rewritten once less than blobGcRatio of it is still referenced. The
+    // cache-mode size limit counts blob files too.
+    uint64_t blobThreshold = 0;
+    double blobGcRatio = 0.5;
+    // Compresses values of at least compressionMinBytes that actually shrink.
+    // Compressed values stay readable when the database is reopened without.
+    ValueCompression compression = kCompressionNone;
+    size_t compressionMinBytes = 32;
+    // Values of at least dedupThreshold bytes (0 disables) are stored once per
+    // distinct content with a reference count; keys with equal values share
+    // it. Reference counting stays on for as long as shared values exist.
+    uint64_t dedupThreshold = 0;
+};
+
+// Samples the first sampleCount values of the prefix.
+struct DictionaryOptions {
+    std::string prefix;
+    size_t sampleCount = 1000;
+    size_t maxSize = 8 << 10;
+};
+
+// Bounds are optional and combine with prefix; limit 0 means unlimited and
+// otherwise counts entries that pass "where".
+struct ScanOptions {
+    bool hasLower = false;
+    bool lowerInclusive = true;
+    std::string lower;
+    bool hasUpper = false;
+    bool upperInclusive = false;
+    std::string upper;
+    std::string prefix;
+    size_t limit = 0;
+    bool reverse = false;
+    // All predicates must hold; they are checked before a value is copied out.
+    std::vector<WherePredicate> where;
+    // When set, values come back as objects of just these fields (dotted
+    // paths); packed records only decode the columns named here.
+    std::vector<std::string> project;
+};
+
+// Equal-width buckets over [min, max); values outside land in below/above.
+struct HistogramOptions {
+    double min = 0;
+    double max = 0;
+    size_t buckets = 0;
+};
+
+struct AggregateOptions {
+    // Dotted path of a JSON field; empty aggregates the values themselves.
+    std::string field;
+    HistogramOptions histogram;
+};
+
+struct AggregateResult {
+    // Values that are numbers; "skipped" counts the ones that are not.
+    uint64_t count = 0;
+    uint64_t skipped = 0;
+    double sum = 0;
+    double min = 0;
+    double max = 0;
+    std::vector<uint64_t> histogram;
+    uint64_t below = 0;
+    uint64_t above = 0;
+};
+
+struct ScanEntry {
+    std::string key;
+    // Objects stored with PutObject() are returned in their encoded form
+    // (see ObjectCodec.h) with isObject set; everything else is plain text.
+    std::string value;
+    bool isObject = false;
+};
+
+struct BlobGcResult {
+    int filesRewritten = 0;
+    // Live bytes copied to the current blob file (or back into the LSM).
+    uint64_t bytesMoved = 0;
+    uint64_t bytesReclaimed = 0;
+};
+
+typedef std::function<void(const WritePressure &)> WritePressureListener;
+
+// Invoked after each sub-range with (completedRanges, totalRanges).
+typedef std::function<void(int, int)> CompactionProgress;
+
+class Transaction;
+class StreamWriter;
+class StreamReader;
 
 class LevelDB {
 public:
     LevelDB();
     ~LevelDB();
     
-    bool Open(const std::string &path);
+    // On failure "error" (if given) receives the reason.
+    bool Open(const std::string &path, const OpenOptions &options = OpenOptions(), std::string *error = nullptr);
     void Close();
     
     bool Remove(const std::string &key);
     bool Remove(const std::vector<std::string> &arrKeys);
     
+    // ttlMs > 0 stores an expiry time in the value envelope; expired values
+    // read as missing and are deleted by the background sweeper.
     template<typename T>
-    bool Put(const std::string& key, const T& value);
+    bool Put(const std::string& key, const T& value, int64_t ttlMs = 0);
 
     template<typename T>
     bool Get(const std::string& key, T& value);
+
+    // Documents are stored in a compact binary form rather than as JSON text;
+    // the string getters still see them as JSON. GetObject() also parses
+    // values that were stored as JSON text.
+    bool PutObject(const std::string &key, const JsonValue &value, int64_t ttlMs = 0);
+    bool GetObject(const std::string &key, JsonValue &value);
+    // Records of a schema are stored packed (see Schema.h) and read back as
+    // objects. Defining a name again with other fields adds a version; rows
+    // keep the layout they were written with.
+    bool DefineSchema(const std::string &name, const std::vector<SchemaField> &fields, std::string *error = nullptr);
+    bool PutRecord(const std::string &key, const std::string &schemaName, const JsonValue &record, int64_t ttlMs = 0,
+                   std::string *error = nullptr);
+    // An object with those of the fields the value has; packed records only
+    // decode the requested columns. False if the key does not exist.
+    bool GetFields(const std::string &key, const std::vector<std::string> &fields, JsonValue &record);
     
     std::vector<std::string> GetAllKeys();
+    // Live (key, value) pairs in key order, or reverse key order.
+    std::vector<ScanEntry> Scan(const ScanOptions &options);
+    // count/sum/min/max (and a histogram) of the numbers in a scan range,
+    // computed without copying values out. Reads bypass the block cache so a
+    // large range does not evict the working set.
+    AggregateResult Aggregate(const ScanOptions &range, const AggregateOptions &options);
+
+    // Read-modify-write helpers. Every single-key write holds the key's lock
+    // stripe, so these are atomic with respect to all other writers of the
+    // same key while unrelated keys rarely contend.
+    // Fails without writing if the current value is not an int64 or the sum
+    // overflows.
+    bool Increment(const std::string &key, int64_t delta, int64_t &result);
+    // expected == nullptr requires the key to be absent.
+    bool CompareAndSwap(const std::string &key, const std::string *expected, const std::string &value);
+    // Returns whether a previous value existed.
+    bool GetAndSet(const std::string &key, const std::string &value, std::string &previous);
+
+    // Writes a delta record without reading the current value. Reads fold
+    // the base value with its pending deltas: int64 add, int64 max, or
+    // append to a JSON array of strings. Once a key collects enough deltas
+    // the maintenance thread rewrites the base value and drops them.
+    // add and max take int64 text and fail otherwise; a base value that is
+    // not an int64, or a sum that would overflow, is left unchanged.
+    bool Merge(const std::string &key, MergeOperator op, const std::string &operand);
+    static bool IsValidMergeOperand(MergeOperator op, const std::string &operand);
+    void SetMergeCollapseThreshold(uint32_t threshold);
+
+    // Secondary indexes: entries are written in the same batch as every
+    // change to an indexed key. A new index is backfilled before DefineIndex()
+    // returns; redefining an existing name with the same spec is a no-op.
+    bool DefineIndex(const IndexSpec &spec, std::string *error = nullptr);
+    bool DropIndex(const std::string &name);
+    std::vector<IndexSpec> GetIndexes();
+    // (key, value) pairs whose field lies in the query range, in field order.
+    // Returns false for an unknown index or a bound of the wrong type.
+    bool QueryIndex(const std::string &name, const IndexQuery &query, std::vector<ScanEntry> &entries);
+    // Tag indexes: keys whose tags match an expression such as
+    // "unread AND starred AND NOT archived" (see TagIndex.h), in the order they
+    // were first indexed; limit 0 returns all of them. Returns false with
+    // error set for an unknown tag index or a malformed expression.
+    bool QueryTags(const std::string &name, const std::string &expression, size_t limit,
+                   std::vector<std::string> &keys, std::string *error = nullptr);
+    bool CountTags(const std::string &name, const std::string &expression, uint64_t &count,
+                   std::string *error = nullptr);
+    // Completion indexes: up to k keys with a term starting with input
+    // (normalized like the indexed text), highest score first and each key
+    // once. Returns false for an unknown completion index.
+    bool Complete(const std::string &name, const std::string &input, size_t k, std::vector<CompletionMatch> &matches);
+
+    // Sorted sets: writes to one set are serialized on its lock stripe and
+    // cost O(members written * log n). Scores must not be NaN.
+    // Returns how many members were new; a member given twice keeps its last score.
+    bool ZAdd(const std::string &name, const std::vector<SortedSetMember> &members, uint64_t &added);
+    bool ZRem(const std::string &name, const std::vector<std::string> &members, uint64_t &removed);
+    bool ZScore(const std::string &name, const std::string &member, double &score);
+    uint64_t ZCard(const std::string &name);
+    // Walks the score index up to the member, so it costs O(rank).
+    bool ZRank(const std::string &name, const std::string &member, bool reverse, uint64_t &rank);
+    std::vector<SortedSetMember> ZRangeByScore(const std::string &name, const ScoreRange &range);
+
+    // Durable FIFO queues. Items get consecutive sequence numbers; firstSeq is
+    // the sequence of the first enqueued item.
+    bool Enqueue(const std::string &name, const std::vector<std::string> &items, uint64_t &firstSeq);
+    // Up to maxItems of the oldest unacknowledged items, without removing them.
+    std::vector<QueueItem> Peek(const std::string &name, size_t maxItems);
+    // Deletes every item up to and including upToSeq. Large acknowledged
+    // ranges are handed to the maintenance thread for compaction.
+    bool Ack(const std::string &name, uint64_t upToSeq, uint64_t &acked);
+    uint64_t QueueLength(const std::string &name);
+
+    // Chunked values are written with StreamWriter and read with StreamReader
+    // (see Stream.h); they are separate from the regular value of the key.
+    bool GetStreamLength(const std::string &key, uint64_t &length);
+    bool RemoveStream(const std::string &key);
+
+    // Embeddings are also kept apart from the regular value (see Vector.h).
+    // quantize adds the int8 copy that quantized searches scan.
+    bool PutVector(const std::string &key, const float *values, size_t dimension, bool quantize = false);
+    bool GetVector(const std::string &key, std::vector<float> &values);
+    bool RemoveVector(const std::string &key);
+    // Brute-force top-k over a consistent snapshot, best match first;
+    // vectors of another dimension are skipped.
+    std::vector<VectorMatch> SearchVectors(const std::vector<float> &query, const VectorSearchOptions &options);
+
+    // Points are indexed by cell for region queries (see Geo.h); they are
+    // separate from the regular value of the key.
+    bool PutPoint(const std::string &key, double lat, double lon);
+    bool GetPoint(const std::string &key, double &lat, double &lon);
+    bool RemovePoint(const std::string &key);
+    // Points within radiusMeters of (lat, lon), nearest first.
+    std::vector<GeoMatch> QueryRadius(double lat, double lon, double radiusMeters, const GeoQueryOptions &options);
+    // Points inside the box, in cell order.
+    std::vector<GeoMatch> QueryBox(const GeoBox &box, const GeoQueryOptions &options);
+
+    bool GetProperty(const std::string &name, std::string &value);
+    DBStats GetStats();
+    std::vector<uint64_t> GetApproximateSizes(const std::vector<KeyRange> &ranges);
+
+    // Splits [range.start, range.limit] along sstable boundaries so compaction
+    // can be paused or cancelled between sub-ranges. Empty bounds are open.
+    std::vector<KeyRange> SplitRange(const KeyRange &range, int maxParts);
+    CompactionResult CompactRange(const KeyRange &range, uint64_t cancelEpoch,
+                                  const CompactionProgress &progress = nullptr);
+    uint64_t CompactionEpoch() const;
+    void CancelCompaction();
+
+    // Background tasks (async compaction) must hold a task reference so that
+    // Close() waits for them before the DB goes away.
+    bool RetainTask();
+    void ReleaseTask();
+
+    void SetIdleCompaction(bool enabled, int64_t intervalMs, int maxRanges);
+    void ReportDeviceState(bool idle, bool charging);
+    // Queues [range.start, range.limit] for compaction on the maintenance
+    // thread, independent of the idle scheduler.
+    void ScheduleCompaction(const KeyRange &range);
+
+    // Deleted keys are counted per prefix (up to and including the first
+    // delimiter); a prefix whose count reaches the threshold gets its deleted
+    // key range compacted in the background.
+    void SetTombstoneCompaction(bool enabled, uint64_t threshold, const std::string &delimiters);
+    std::vector<TombstoneRange> GetTombstoneStats();
+
+    // Deletes up to maxKeys expired entries (all if 0) and returns how many
+    // user keys were removed.
+    size_t SweepExpired(size_t maxKeys = 0);
+    void SetExpirySweep(int64_t intervalMs, size_t batchSize);
+
+    // Rewrites the sealed blob files whose live ratio is below blobGcRatio;
+    // the maintenance thread also does this periodically. sealActive first
+    // closes the file currently being appended to so that it qualifies too.
+    BlobGcResult CollectBlobGarbage(bool sealActive = false);
+
+    // Trains a compression dictionary from existing values and uses it for
+    // every value compressed from now on; values already written keep the
+    // dictionary they were compressed with. Returns the new dictionary id.
+    bool TrainCompressionDictionary(const DictionaryOptions &options, uint32_t &id, std::string *error = nullptr);
+
+    WritePressure GetWritePressure();
+    // The listener is called from the maintenance thread whenever the
+    // pressure level changes; pass nullptr to stop polling.
+    void SetWritePressureListener(const WritePressureListener &listener);
 private:
+    friend class Transaction;
+    friend class StreamWriter;
+    friend class StreamReader;
+
+    static const size_t kKeyLockStripes = 64;
+    // Version stamps for optimistic transactions, one per hash slot. Keys
+    // sharing a slot can only cause spurious conflicts, never missed ones.
+    static const size_t kKeyVersionSlots = 4096;
+
+    class KeyLockGuard {
+    public:
+        KeyLockGuard(LevelDB &db, const std::string &key);
+        KeyLockGuard(LevelDB &db, const std::vector<std::string> &keys);
+        ~KeyLockGuard();
+    private:
+        LevelDB &_db;
+        std::vector<size_t> _stripes;
+    };
+
     leveldb::DB *_db;
+    leveldb::Cache *_blockCache;
+    const leveldb::Comparator *_comparator;
     leveldb::ReadOptions _readOptions;
     leveldb::WriteOptions _writeOptions;
+    size_t _writeBufferSize;
+
+    std::atomic<uint64_t> _compactionEpoch;
+    int _runningTasks;
+    std::atomic<bool> _closing;
+
+    std::thread _maintenanceThread;
+    std::mutex _maintenanceMutex;
+    std::condition_variable _maintenanceCond;
+    bool _maintenanceStop;
+    bool _idleCompactionEnabled;
+    int64_t _idleCompactionIntervalMs;
+    int _idleCompactionMaxRanges;
+    bool _deviceIdle;
+    bool _deviceCharging;
+    std::deque<KeyRange> _idleCompactionPlan;
+    std::chrono::steady_clock::time_point _lastIdleCompaction;
+    std::deque<KeyRange> _pendingCompactions;
+
+    std::mutex _tombstoneMutex;
+    bool _tombstoneTracking;
+    uint64_t _tombstoneThreshold;
+    std::string _tombstoneDelimiters;
+    std::map<std::string, TombstoneRange> _tombstones;
+
+    void RecordTombstones(const std::vector<std::string> &keys);
+
+    std::mutex _pressureMutex;
+    double _writeLatencyEwmaUs;
+    double _recentMaxLatencyUs;
+    std::chrono::steady_clock::time_point _recentMaxLatencyAt;
+    WritePressureListener _pressureListener;
+    int _lastPressureLevel;
+    bool _pressurePolling;
+    std::chrono::steady_clock::time_point _nextPressurePoll;
+
+    std::atomic<bool> _expirySweepActive;
+    int64_t _expirySweepIntervalMs;
+    size_t _expirySweepBatchSize;
+    std::chrono::steady_clock::time_point _nextExpirySweep;
+
+    std::mutex _keyLocks[kKeyLockStripes];
+    std::atomic<uint64_t> _keyVersions[kKeyVersionSlots];
+
+    std::mutex _indexMutex;
+    std::vector<IndexSpec> _indexes;
+    std::atomic<size_t> _indexCount;
+    // Tag indexes among _indexes; while nonzero, Commit() folds tag deltas.
+    std::atomic<size_t> _tagIndexCount;
+    // Held from reading tag containers until the batch rewriting them is
+    // written; also guards the next free id of each tag index.
+    std::mutex _tagMutex;
+    std::map<std::string, uint32_t> _tagNextIds;
+
+    std::mutex _queueMutex;
+    std::unordered_map<std::string, QueueState> _queues;
+
+    // Generations of chunked values; seeded from the clock so a reopened
+    // database does not hand out generations that are already in use.
+    std::atomic<uint64_t> _streamGeneration;
+
+    std::mutex _mergeMutex;
+    std::atomic<uint64_t> _mergeSequence;
+    std::atomic<size_t> _pendingMergeKeys;
+    std::unordered_map<std::string, uint32_t> _pendingMerges;
+    uint32_t _mergeCollapseThreshold;
+    std::deque<std::string> _mergeCollapseQueue;
+    std::unordered_set<std::string> _mergeCollapseQueued;
+
+    uint64_t _cacheMaxBytes;
+    CacheEviction _cacheEviction;
+    std::atomic<uint64_t> _accessClock;
+    std::mutex _cacheMutex;
+    // LRU reads waiting to be written to the access-order index.
+    std::unordered_set<std::string> _pendingAccesses;
+    std::chrono::steady_clock::time_point _nextCacheCheck;
+
+    BlobStore _blobs;
+    uint64_t _blobThreshold;
+    double _blobGcRatio;
+    bool _blobGcActive;
+    std::chrono::steady_clock::time_point _nextBlobGc;
+    // Serializes garbage collection passes.
+    std::mutex _blobGcMutex;
+
+    ValueCompression _compression;
+    size_t _compressionMinBytes;
+    std::mutex _dictionaryMutex;
+    // Trained dictionaries by id; the newest one is used for new values.
+    std::map<uint32_t, std::shared_ptr<const std::string>> _dictionaries;
+
+    std::mutex _schemaMutex;
+    // Every version by id, and the latest id of each name.
+    std::map<uint32_t, std::shared_ptr<const RecordSchema>> _schemas;
+    std::map<std::string, uint32_t> _schemaVersions;
+
+    uint64_t _dedupThreshold;
+    bool _dedupActive;
+    // Held from reading a reference count until the batch changing it is
+    // written; recursive because PutValue stages the content and then commits.
+    std::recursive_mutex _dedupMutex;
+
+    // Return false to stop the scan. The slices are only valid during the call.
+    typedef std::function<bool(const leveldb::Slice &key, const leveldb::Slice &payload, bool isObject)> ScanVisitor;
+
+    bool KeyLess(const std::string &a, const std::string &b) const;
+    size_t KeyStripe(const std::string &key) const;
+    uint64_t KeyVersion(const std::string &key) const;
+    void BumpKeyVersion(const std::string &key);
+    bool Commit(leveldb::WriteBatch &batch);
+    bool PutValue(const std::string &key, const std::string &value, int64_t ttlMs, uint8_t flags = 0);
+    bool GetValue(const std::string &key, std::string &value);
+    // includeExpired returns expired values as well, which is what the index
+    // entries were built from. Object payloads are turned into JSON text
+    // unless keepObject is set and no merge deltas have to be folded in;
+    // likewise packed records stay packed with keepPacked.
+    bool ReadValue(const std::string &key, std::string &payload, ValueHeader &header, bool includeExpired = false,
+                   bool keepObject = false, bool keepPacked = false);
+    void StageValue(leveldb::WriteBatch &batch, const std::string &key, const std::string &payload,
+                    const ValueHeader &header);
+    // Compresses and separates the value as configured, then stages it.
+    bool StagePayload(leveldb::WriteBatch &batch, const std::string &key, const std::string &value,
+                      ValueHeader header);
+    // Stages a user value the way every write path stores it: as a content
+    // hash when it is large enough to share, otherwise through StagePayload.
+    // Requires the key stripe; dedupLock is taken when the shared content is
+    // staged too and must stay held until the batch is committed.
+    bool StageUserValue(leveldb::WriteBatch &batch, const std::string &key, const std::string &value,
+                        ValueHeader header, std::unique_lock<std::recursive_mutex> &dedupLock);
+    // Replaces a blob pointer payload by the value it points at.
+    bool LoadBlob(const std::string &key, std::string &payload, ValueHeader &header);
+    // Replaces a content hash payload by the shared value it names.
+    bool LoadShared(const std::string &key, std::string &payload, ValueHeader &header);
+    // Undoes deduplication, blob separation and compression, clearing their
+    // flags, and turns packed records into objects unless keepPacked is set.
+    bool ResolvePayload(const std::string &key, std::string &payload, ValueHeader &header, bool keepPacked = false);
+    // The schema version a packed record was written with; null if unknown.
+    std::shared_ptr<const RecordSchema> PackedSchema(const leveldb::Slice &packed);
+    bool UnpackPayload(std::string &payload, ValueHeader &header);
+    void LoadSchemas();
+    // False when the value is left uncompressed.
+    bool CompressValue(const std::string &value, std::string &compressed);
+    bool DecompressValue(std::string &payload, ValueHeader &header);
+    void LoadDictionaries();
+    // Visits the live entries of a scan that pass options.where; options.limit
+    // is left to the visitor.
+    void ScanEach(const ScanOptions &options, const leveldb::ReadOptions &readOptions, const ScanVisitor &visit);
+    // Appends the reference count changes (and the removal of content that
+    // lost its last reference) for the shared values batch adds or drops;
+    // requires _dedupMutex.
+    void StageSharedRefs(leveldb::WriteBatch &batch);
+    // Appends access-order updates for the user keys written by batch.
+    void StageAccessOrder(leveldb::WriteBatch &batch);
+    void RecordAccess(const std::string &key);
+    void FlushAccesses();
+    void LoadAccessOrder();
+    void EnforceCacheLimit();
+    // Cached head and tail of a queue, loaded on first use; requires _queueMutex.
+    QueueState &QueueStateLocked(const std::string &name);
+    void LoadPendingMerges();
+    bool HasPendingMerges(const std::string &key);
+    bool FoldMerges(const std::string &key, bool exists, std::string &payload, std::vector<std::string> *deltaKeys);
+    // Stages deletes for the pending deltas of keys that are about to be
+    // replaced or removed; ForgetMerges() must follow a successful commit.
+    void StageDropMerges(leveldb::WriteBatch &batch, const std::string &key);
+    std::vector<IndexSpec> IndexesFor(const std::string &key);
+    // Stages the index entry changes for key taking newValue (nullptr when
+    // removed). The caller holds the key's stripe.
+    void StageIndexChange(leveldb::WriteBatch &batch, const std::string &key, const std::string *newValue,
+                          bool newIsObject = false);
+    // Returns once no writer can still act on an index list read earlier.
+    void WaitForIndexWriters();
+    // Stages the id, universe and tag deltas for key changing from oldValue
+    // to newValue (either may be nullptr); a key without an id is new to the
+    // index whatever oldValue says.
+    void StageTagChange(leveldb::WriteBatch &batch, const IndexSpec &spec, const std::string &key,
+                        const std::string *oldValue, const std::string *newValue);
+    // Replaces the tag deltas in batch by the containers they change;
+    // requires _tagMutex.
+    void StageTagContainers(leveldb::WriteBatch &batch);
+    // Requires _tagMutex.
+    uint32_t NextTagIdLocked(const std::string &name);
+    bool MatchTags(const std::string &name, const std::string &expression, const leveldb::ReadOptions &options,
+                   RoaringBitmap &result, std::string *error);
+    // Calls visit for the points inside boxes whose key starts with prefix,
+    // until it returns false.
+    void ScanGeoCells(const std::vector<GeoBox> &boxes, const std::string &prefix,
+                      const std::function<bool(GeoMatch &)> &visit);
+    void LoadIndexes();
+    bool BackfillIndex(const IndexSpec &spec);
+    void ForgetMerges(const std::string &key);
+    void CollapseMerges(const std::string &key);
+    void ActivateExpirySweep();
+    void RecordWriteLatency(double latencyUs);
+    void EvaluateWritePressure();
+    // Memtable usage, without the block cache.
+    uint64_t MemtableBytes();
+
+    void CompactSubRange(const KeyRange &range);
+    void EnsureMaintenanceThread();
+    void StopMaintenanceThread();
+    void MaintenanceLoop();
     
     template<typename T>
     std::string Serialize(const T& value);
@@ -42,17 +611,14 @@ private:
 };
 
 template<typename T>
-bool LevelDB::Put(const std::string& key, const T& value) {
-    std::string serialized_value = Serialize(value);
-    leveldb::Status status = _db->Put(_writeOptions, key, serialized_value);
-    return status.ok();
+bool LevelDB::Put(const std::string& key, const T& value, int64_t ttlMs) {
+    return PutValue(key, Serialize(value), ttlMs);
 }
 
 template<typename T>
 bool LevelDB::Get(const std::string& key, T& value) {
     std::string serialized_value;
-    leveldb::Status status = _db->Get(_readOptions, key, &serialized_value);
-    if (!status.ok()) {
+    if (!GetValue(key, serialized_value)) {
         return false;
     }
     value = Deserialize<T>(serialized_value);
@@ -72,4 +638,11 @@ T LevelDB::Deserialize(const std::string& serialized_value) {
     T value;
     iss >> value;
     return value;
-}
\ No newline at end of file
+}
+
+template<>
+inline std::string LevelDB::Deserialize<std::string>(const std::string& serialized_value) {
+    return serialized_value;
+}
+
+#endif // LEVELDB_LEVELDB_H
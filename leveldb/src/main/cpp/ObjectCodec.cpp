@@ -0,0 +1,237 @@
+#include "ObjectCodec.h"
+#include "Coding.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+enum ObjectTag : uint8_t {
+    kObjectNull = 0,
+    kObjectFalse = 1,
+    kObjectTrue = 2,
+    kObjectInt = 3,
+    kObjectDouble = 4,
+    kObjectString = 5,
+    kObjectArray = 6,
+    kObjectMap = 7,
+};
+
+// Same limit as the JSON parser, so every parsed document can be stored.
+static const int kMaxObjectDepth = 64;
+static const double kMaxSafeInteger = 9007199254740991.0;
+
+static bool IntegerLiteral(const JsonValue &value, int64_t &result) {
+    if (value.text.empty()) {
+        if (value.number != std::floor(value.number) || std::fabs(value.number) > kMaxSafeInteger) {
+            return false;
+        }
+        result = static_cast<int64_t>(value.number);
+        return true;
+    }
+    if (value.text.find_first_of(".eE") != std::string::npos) {
+        return false;
+    }
+    char *end = nullptr;
+    errno = 0;
+    result = strtoll(value.text.c_str(), &end, 10);
+    return *end == '\0' && errno == 0;
+}
+
+void EncodeObject(const JsonValue &value, std::string &dst) {
+    switch (value.type) {
+        case JsonValue::kNull:
+            dst.push_back(static_cast<char>(kObjectNull));
+            break;
+        case JsonValue::kBool:
+            dst.push_back(static_cast<char>(value.boolean ? kObjectTrue : kObjectFalse));
+            break;
+        case JsonValue::kNumber: {
+            int64_t integer = 0;
+            if (IntegerLiteral(value, integer)) {
+                dst.push_back(static_cast<char>(kObjectInt));
+                PutVarint64(dst, (static_cast<uint64_t>(integer) << 1) ^ static_cast<uint64_t>(integer >> 63));
+            } else {
+                uint64_t bits = 0;
+                memcpy(&bits, &value.number, sizeof(bits));
+                dst.push_back(static_cast<char>(kObjectDouble));
+                PutFixed64BE(dst, bits);
+            }
+            break;
+        }
+        case JsonValue::kString:
+            dst.push_back(static_cast<char>(kObjectString));
+            PutVarint64(dst, value.text.size());
+            dst.append(value.text);
+            break;
+        case JsonValue::kArray:
+            dst.push_back(static_cast<char>(kObjectArray));
+            PutVarint64(dst, value.items.size());
+            for (const auto& item : value.items) {
+                EncodeObject(item, dst);
+            }
+            break;
+        case JsonValue::kObject:
+            dst.push_back(static_cast<char>(kObjectMap));
+            PutVarint64(dst, value.members.size());
+            for (const auto& member : value.members) {
+                PutVarint64(dst, member.first.size());
+                dst.append(member.first);
+                EncodeObject(member.second, dst);
+            }
+            break;
+    }
+}
+
+static bool GetLengthPrefixed(leveldb::Slice &input, leveldb::Slice &result) {
+    uint64_t size = 0;
+    if (!GetVarint64(input, size) || size > input.size()) {
+        return false;
+    }
+    result = leveldb::Slice(input.data(), size);
+    input.remove_prefix(size);
+    return true;
+}
+
+// Reads one value, or only steps over it when "value" is null.
+static bool ReadObjectValue(leveldb::Slice &input, JsonValue *value, int depth) {
+    if (input.empty() || depth > kMaxObjectDepth) {
+        return false;
+    }
+    uint8_t tag = static_cast<uint8_t>(input[0]);
+    input.remove_prefix(1);
+    uint64_t count = 0;
+    leveldb::Slice bytes;
+    switch (tag) {
+        case kObjectNull:
+        case kObjectFalse:
+        case kObjectTrue:
+            if (value) {
+                value->type = tag == kObjectNull ? JsonValue::kNull : JsonValue::kBool;
+                value->boolean = tag == kObjectTrue;
+            }
+            return true;
+        case kObjectInt: {
+            if (!GetVarint64(input, count)) {
+                return false;
+            }
+            if (value) {
+                int64_t integer = static_cast<int64_t>((count >> 1) ^ (~(count & 1) + 1));
+                value->type = JsonValue::kNumber;
+                value->number = static_cast<double>(integer);
+                value->text = std::to_string(integer);
+            }
+            return true;
+        }
+        case kObjectDouble:
+            if (input.size() < 8) {
+                return false;
+            }
+            if (value) {
+                uint64_t bits = DecodeFixed64BE(input.data());
+                value->type = JsonValue::kNumber;
+                memcpy(&value->number, &bits, sizeof(bits));
+                value->text.clear();
+            }
+            input.remove_prefix(8);
+            return true;
+        case kObjectString:
+            if (!GetLengthPrefixed(input, bytes)) {
+                return false;
+            }
+            if (value) {
+                value->type = JsonValue::kString;
+                value->text = bytes.ToString();
+            }
+            return true;
+        case kObjectArray:
+            // Every element takes at least one byte.
+            if (!GetVarint64(input, count) || count > input.size()) {
+                return false;
+            }
+            if (value) {
+                value->type = JsonValue::kArray;
+                value->items.resize(count);
+            }
+            for (uint64_t i = 0; i < count; i++) {
+                if (!ReadObjectValue(input, value ? &value->items[i] : nullptr, depth + 1)) {
+                    return false;
+                }
+            }
+            return true;
+        case kObjectMap:
+            if (!GetVarint64(input, count) || count > input.size() / 2) {
+                return false;
+            }
+            if (value) {
+                value->type = JsonValue::kObject;
+                value->members.resize(count);
+            }
+            for (uint64_t i = 0; i < count; i++) {
+                if (!GetLengthPrefixed(input, bytes)) {
+                    return false;
+                }
+                if (value) {
+                    value->members[i].first = bytes.ToString();
+                }
+                if (!ReadObjectValue(input, value ? &value->members[i].second : nullptr, depth + 1)) {
+                    return false;
+                }
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool DecodeObject(const leveldb::Slice &encoded, JsonValue &value) {
+    leveldb::Slice input = encoded;
+    value = JsonValue();
+    return ReadObjectValue(input, &value, 0) && input.empty();
+}
+
+bool FindObjectField(const leveldb::Slice &encoded, const std::string &path, JsonValue &value) {
+    leveldb::Slice input = encoded;
+    size_t start = 0;
+    while (start <= path.size() && !path.empty()) {
+        size_t dot = path.find('.', start);
+        leveldb::Slice name(path.data() + start, (dot == std::string::npos ? path.size() : dot) - start);
+        uint64_t count = 0;
+        if (input.empty() || static_cast<uint8_t>(input[0]) != kObjectMap) {
+            return false;
+        }
+        input.remove_prefix(1);
+        if (!GetVarint64(input, count)) {
+            return false;
+        }
+        bool found = false;
+        for (uint64_t i = 0; i < count && !found; i++) {
+            leveldb::Slice member;
+            if (!GetLengthPrefixed(input, member)) {
+                return false;
+            }
+            found = member == name;
+            if (!found && !ReadObjectValue(input, nullptr, 0)) {
+                return false;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+        if (dot == std::string::npos) {
+            break;
+        }
+        start = dot + 1;
+    }
+    value = JsonValue();
+    return ReadObjectValue(input, &value, 0);
+}
+
+bool ObjectToJson(const leveldb::Slice &encoded, std::string &json) {
+    JsonValue value;
+    if (!DecodeObject(encoded, value)) {
+        return false;
+    }
+    json.clear();
+    AppendJson(json, value);
+    return true;
+}
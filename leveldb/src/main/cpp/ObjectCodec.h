@@ -0,0 +1,31 @@
+//
+// Created on 2026/10/19.
+//
+// Compact binary form of JSON documents stored with setObject(). Every value
+// starts with a one-byte tag:
+//   null | false | true
+//   int     zigzag varint
+//   double  8-byte big-endian IEEE bits
+//   string  varint length, bytes
+//   array   varint count, values
+//   object  varint count, (varint key length, key, value) per member
+// Members keep their insertion order. A field lookup skips over siblings
+// without materializing them, which is what scan predicates rely on.
+
+#ifndef LEVELDB_OBJECTCODEC_H
+#define LEVELDB_OBJECTCODEC_H
+
+#include <string>
+#include <leveldb/slice.h>
+#include "Json.h"
+
+void EncodeObject(const JsonValue &value, std::string &dst);
+// Returns false on malformed input. Integers come back with their literal in
+// "text", so values beyond 2^53 stay exact.
+bool DecodeObject(const leveldb::Slice &encoded, JsonValue &value);
+// Decodes only the value at a dotted path; false if the path does not exist.
+bool FindObjectField(const leveldb::Slice &encoded, const std::string &path, JsonValue &value);
+// JSON text of an encoded document; false on malformed input.
+bool ObjectToJson(const leveldb::Slice &encoded, std::string &json);
+
+#endif // LEVELDB_OBJECTCODEC_H
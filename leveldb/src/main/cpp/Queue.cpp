@@ -0,0 +1,54 @@
+#include "Queue.h"
+#include "Coding.h"
+#include "KeyCodec.h"
+
+static const std::string kQueueItemPrefix = InternalKey("q:");
+static const std::string kQueueMetaPrefix = InternalKey("qm:");
+
+static std::string NamePart(const std::string &name) {
+    KeyPart part;
+    part.type = kKeyPartString;
+    part.bytes = name;
+    std::string encoded;
+    EncodeKeyPart(encoded, part);
+    return encoded;
+}
+
+std::string QueueItemPrefix(const std::string &name) {
+    return kQueueItemPrefix + NamePart(name);
+}
+
+std::string QueueItemKey(const std::string &name, uint64_t seq) {
+    std::string key = QueueItemPrefix(name);
+    PutFixed64BE(key, seq);
+    return key;
+}
+
+bool DecodeQueueItemKey(const leveldb::Slice &prefix, const leveldb::Slice &key, uint64_t &seq) {
+    if (key.size() != prefix.size() + 8 || !key.starts_with(prefix)) {
+        return false;
+    }
+    seq = DecodeFixed64BE(key.data() + prefix.size());
+    return true;
+}
+
+std::string QueueMetaKey(const std::string &name) {
+    return kQueueMetaPrefix + NamePart(name);
+}
+
+std::string EncodeQueueMeta(const QueueState &state) {
+    std::string value;
+    PutFixed64BE(value, state.head);
+    PutFixed64BE(value, state.tail);
+    return value;
+}
+
+bool DecodeQueueMeta(const leveldb::Slice &value, QueueState &state) {
+    if (value.size() != 16) {
+        return false;
+    }
+    state.head = DecodeFixed64BE(value.data());
+    state.tail = DecodeFixed64BE(value.data() + 8);
+    state.compactFrom = state.head;
+    return state.head <= state.tail;
+}
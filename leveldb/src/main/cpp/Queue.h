@@ -0,0 +1,37 @@
+//
+// Created on 2026/10/19.
+//
+// Layout of durable FIFO queues:
+//   q:  | tuple(name) | fixed64 sequence -> item
+//   qm: | tuple(name)                    -> fixed64 head | fixed64 tail
+// Sequences are assigned from tail and increase forever, so items of a
+// queue are contiguous and in order; head is the oldest unacknowledged one.
+
+#ifndef LEVELDB_QUEUE_H
+#define LEVELDB_QUEUE_H
+
+#include <string>
+#include <stdint.h>
+#include <leveldb/slice.h>
+
+struct QueueItem {
+    uint64_t seq = 0;
+    std::string value;
+};
+
+struct QueueState {
+    uint64_t head = 0;
+    uint64_t tail = 0;
+    // Acknowledged items not yet handed to compaction.
+    uint64_t compactFrom = 0;
+};
+
+std::string QueueItemPrefix(const std::string &name);
+std::string QueueItemKey(const std::string &name, uint64_t seq);
+// The sequence of an item key under "prefix"; false for anything else.
+bool DecodeQueueItemKey(const leveldb::Slice &prefix, const leveldb::Slice &key, uint64_t &seq);
+std::string QueueMetaKey(const std::string &name);
+std::string EncodeQueueMeta(const QueueState &state);
+bool DecodeQueueMeta(const leveldb::Slice &value, QueueState &state);
+
+#endif // LEVELDB_QUEUE_H
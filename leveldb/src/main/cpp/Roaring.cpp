@@ -0,0 +1,335 @@
+#include "Roaring.h"
+#include "Coding.h"
+#include <algorithm>
+#include <iterator>
+
+// The word loops below have no dependencies between iterations, so the
+// compiler turns them into vector instructions.
+static uint32_t CountBits(const uint64_t *words) {
+    uint32_t count = 0;
+    for (size_t i = 0; i < kRoaringBitmapWords; i++) {
+        count += static_cast<uint32_t>(__builtin_popcountll(words[i]));
+    }
+    return count;
+}
+
+static void ArrayToBitmap(RoaringContainer &container) {
+    container.bits.assign(kRoaringBitmapWords, 0);
+    for (uint16_t value : container.array) {
+        container.bits[value >> 6] |= uint64_t(1) << (value & 63);
+    }
+    container.array.clear();
+    container.array.shrink_to_fit();
+}
+
+static void BitmapToArray(RoaringContainer &container) {
+    container.array.clear();
+    container.array.reserve(container.cardinality);
+    for (size_t i = 0; i < kRoaringBitmapWords; i++) {
+        uint64_t word = container.bits[i];
+        while (word != 0) {
+            container.array.push_back(static_cast<uint16_t>(i * 64 + __builtin_ctzll(word)));
+            word &= word - 1;
+        }
+    }
+    container.bits.clear();
+    container.bits.shrink_to_fit();
+}
+
+// Picks the smaller representation after a bulk operation.
+static void Normalize(RoaringContainer &container) {
+    if (container.IsBitmap()) {
+        container.cardinality = CountBits(container.bits.data());
+        if (container.cardinality <= kRoaringArrayMax) {
+            BitmapToArray(container);
+        }
+    } else {
+        container.cardinality = static_cast<uint32_t>(container.array.size());
+        if (container.cardinality > kRoaringArrayMax) {
+            ArrayToBitmap(container);
+        }
+    }
+}
+
+bool RoaringContainer::Contains(uint16_t value) const {
+    if (IsBitmap()) {
+        return (bits[value >> 6] >> (value & 63)) & 1;
+    }
+    return std::binary_search(array.begin(), array.end(), value);
+}
+
+bool RoaringContainer::Add(uint16_t value) {
+    if (IsBitmap()) {
+        uint64_t mask = uint64_t(1) << (value & 63);
+        if (bits[value >> 6] & mask) {
+            return false;
+        }
+        bits[value >> 6] |= mask;
+        cardinality++;
+        return true;
+    }
+    auto it = std::lower_bound(array.begin(), array.end(), value);
+    if (it != array.end() && *it == value) {
+        return false;
+    }
+    array.insert(it, value);
+    cardinality++;
+    if (cardinality > kRoaringArrayMax) {
+        ArrayToBitmap(*this);
+    }
+    return true;
+}
+
+bool RoaringContainer::Remove(uint16_t value) {
+    if (IsBitmap()) {
+        uint64_t mask = uint64_t(1) << (value & 63);
+        if ((bits[value >> 6] & mask) == 0) {
+            return false;
+        }
+        bits[value >> 6] &= ~mask;
+        cardinality--;
+        if (cardinality <= kRoaringArrayMax) {
+            BitmapToArray(*this);
+        }
+        return true;
+    }
+    auto it = std::lower_bound(array.begin(), array.end(), value);
+    if (it == array.end() || *it != value) {
+        return false;
+    }
+    array.erase(it);
+    cardinality--;
+    return true;
+}
+
+static RoaringContainer AndContainers(const RoaringContainer &a, const RoaringContainer &b) {
+    RoaringContainer result;
+    if (a.IsBitmap() && b.IsBitmap()) {
+        result.bits.resize(kRoaringBitmapWords);
+        for (size_t i = 0; i < kRoaringBitmapWords; i++) {
+            result.bits[i] = a.bits[i] & b.bits[i];
+        }
+    } else if (a.IsBitmap() || b.IsBitmap()) {
+        const RoaringContainer &bitmap = a.IsBitmap() ? a : b;
+        const RoaringContainer &array = a.IsBitmap() ? b : a;
+        for (uint16_t value : array.array) {
+            if (bitmap.Contains(value)) {
+                result.array.push_back(value);
+            }
+        }
+    } else {
+        std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                              std::back_inserter(result.array));
+    }
+    Normalize(result);
+    return result;
+}
+
+static RoaringContainer OrContainers(const RoaringContainer &a, const RoaringContainer &b) {
+    RoaringContainer result;
+    if (a.IsBitmap() && b.IsBitmap()) {
+        result.bits.resize(kRoaringBitmapWords);
+        for (size_t i = 0; i < kRoaringBitmapWords; i++) {
+            result.bits[i] = a.bits[i] | b.bits[i];
+        }
+    } else if (a.IsBitmap() || b.IsBitmap()) {
+        const RoaringContainer &bitmap = a.IsBitmap() ? a : b;
+        const RoaringContainer &array = a.IsBitmap() ? b : a;
+        result.bits = bitmap.bits;
+        for (uint16_t value : array.array) {
+            result.bits[value >> 6] |= uint64_t(1) << (value & 63);
+        }
+    } else {
+        std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                       std::back_inserter(result.array));
+    }
+    Normalize(result);
+    return result;
+}
+
+static RoaringContainer AndNotContainers(const RoaringContainer &a, const RoaringContainer &b) {
+    RoaringContainer result;
+    if (a.IsBitmap() && b.IsBitmap()) {
+        result.bits.resize(kRoaringBitmapWords);
+        for (size_t i = 0; i < kRoaringBitmapWords; i++) {
+            result.bits[i] = a.bits[i] & ~b.bits[i];
+        }
+    } else if (a.IsBitmap()) {
+        result.bits = a.bits;
+        for (uint16_t value : b.array) {
+            result.bits[value >> 6] &= ~(uint64_t(1) << (value & 63));
+        }
+    } else if (b.IsBitmap()) {
+        for (uint16_t value : a.array) {
+            if (!b.Contains(value)) {
+                result.array.push_back(value);
+            }
+        }
+    } else {
+        std::set_difference(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                            std::back_inserter(result.array));
+    }
+    Normalize(result);
+    return result;
+}
+
+bool RoaringBitmap::Contains(uint32_t id) const {
+    auto it = _containers.find(static_cast<uint16_t>(id >> 16));
+    return it != _containers.end() && it->second.Contains(static_cast<uint16_t>(id));
+}
+
+void RoaringBitmap::Add(uint32_t id) {
+    _containers[static_cast<uint16_t>(id >> 16)].Add(static_cast<uint16_t>(id));
+}
+
+void RoaringBitmap::Remove(uint32_t id) {
+    auto it = _containers.find(static_cast<uint16_t>(id >> 16));
+    if (it != _containers.end() && it->second.Remove(static_cast<uint16_t>(id)) && it->second.cardinality == 0) {
+        _containers.erase(it);
+    }
+}
+
+uint64_t RoaringBitmap::Cardinality() const {
+    uint64_t count = 0;
+    for (const auto& entry : _containers) {
+        count += entry.second.cardinality;
+    }
+    return count;
+}
+
+RoaringBitmap RoaringBitmap::And(const RoaringBitmap &other) const {
+    RoaringBitmap result;
+    auto a = _containers.begin();
+    auto b = other._containers.begin();
+    while (a != _containers.end() && b != other._containers.end()) {
+        if (a->first < b->first) {
+            ++a;
+        } else if (b->first < a->first) {
+            ++b;
+        } else {
+            RoaringContainer container = AndContainers(a->second, b->second);
+            if (container.cardinality > 0) {
+                result._containers.emplace_hint(result._containers.end(), a->first, std::move(container));
+            }
+            ++a;
+            ++b;
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::Or(const RoaringBitmap &other) const {
+    RoaringBitmap result;
+    auto a = _containers.begin();
+    auto b = other._containers.begin();
+    while (a != _containers.end() || b != other._containers.end()) {
+        if (b == other._containers.end() || (a != _containers.end() && a->first < b->first)) {
+            result._containers.emplace_hint(result._containers.end(), a->first, a->second);
+            ++a;
+        } else if (a == _containers.end() || b->first < a->first) {
+            result._containers.emplace_hint(result._containers.end(), b->first, b->second);
+            ++b;
+        } else {
+            result._containers.emplace_hint(result._containers.end(), a->first, OrContainers(a->second, b->second));
+            ++a;
+            ++b;
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::AndNot(const RoaringBitmap &other) const {
+    RoaringBitmap result;
+    auto b = other._containers.begin();
+    for (const auto& entry : _containers) {
+        while (b != other._containers.end() && b->first < entry.first) {
+            ++b;
+        }
+        if (b == other._containers.end() || b->first != entry.first) {
+            result._containers.emplace_hint(result._containers.end(), entry.first, entry.second);
+            continue;
+        }
+        RoaringContainer container = AndNotContainers(entry.second, b->second);
+        if (container.cardinality > 0) {
+            result._containers.emplace_hint(result._containers.end(), entry.first, std::move(container));
+        }
+    }
+    return result;
+}
+
+void RoaringBitmap::ToIds(std::vector<uint32_t> &ids, size_t limit) const {
+    for (const auto& entry : _containers) {
+        uint32_t high = static_cast<uint32_t>(entry.first) << 16;
+        const RoaringContainer &container = entry.second;
+        if (!container.IsBitmap()) {
+            for (uint16_t value : container.array) {
+                if (limit > 0 && ids.size() >= limit) {
+                    return;
+                }
+                ids.push_back(high | value);
+            }
+            continue;
+        }
+        for (size_t i = 0; i < kRoaringBitmapWords; i++) {
+            uint64_t word = container.bits[i];
+            while (word != 0) {
+                if (limit > 0 && ids.size() >= limit) {
+                    return;
+                }
+                ids.push_back(high | static_cast<uint32_t>(i * 64 + __builtin_ctzll(word)));
+                word &= word - 1;
+            }
+        }
+    }
+}
+
+std::string EncodeRoaringContainer(const RoaringContainer &container) {
+    std::string value;
+    if (container.IsBitmap()) {
+        value.reserve(1 + kRoaringBitmapWords * 8);
+        value.push_back(1);
+        for (uint64_t word : container.bits) {
+            PutFixed64BE(value, word);
+        }
+    } else {
+        value.reserve(1 + container.array.size() * 2);
+        value.push_back(0);
+        for (uint16_t item : container.array) {
+            value.push_back(static_cast<char>(item >> 8));
+            value.push_back(static_cast<char>(item & 0xff));
+        }
+    }
+    return value;
+}
+
+bool DecodeRoaringContainer(const leveldb::Slice &value, RoaringContainer &container) {
+    container = RoaringContainer();
+    if (value.empty()) {
+        return false;
+    }
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(value.data()) + 1;
+    size_t size = value.size() - 1;
+    if (value[0] == 1) {
+        if (size != kRoaringBitmapWords * 8) {
+            return false;
+        }
+        container.bits.resize(kRoaringBitmapWords);
+        for (size_t i = 0; i < kRoaringBitmapWords; i++) {
+            container.bits[i] = DecodeFixed64BE(reinterpret_cast<const char *>(data) + i * 8);
+        }
+        container.cardinality = CountBits(container.bits.data());
+        return container.cardinality > kRoaringArrayMax;
+    }
+    if (value[0] != 0 || size % 2 != 0 || size / 2 > kRoaringArrayMax) {
+        return false;
+    }
+    container.array.resize(size / 2);
+    for (size_t i = 0; i < container.array.size(); i++) {
+        container.array[i] = static_cast<uint16_t>((data[i * 2] << 8) | data[i * 2 + 1]);
+        if (i > 0 && container.array[i] <= container.array[i - 1]) {
+            return false;
+        }
+    }
+    container.cardinality = static_cast<uint32_t>(container.array.size());
+    return true;
+}
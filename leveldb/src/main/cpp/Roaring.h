@@ -0,0 +1,64 @@
+//
+// Created on 2026/10/19.
+//
+// Roaring bitmaps of 32-bit ids. Ids are grouped by their high 16 bits into
+// containers that hold the low 16 bits either as a sorted array (up to 4096
+// values) or as a 65536-bit bitmap, so sparse and dense sets both stay small
+// and set operations work a container at a time.
+
+#ifndef LEVELDB_ROARING_H
+#define LEVELDB_ROARING_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <leveldb/slice.h>
+
+const uint32_t kRoaringArrayMax = 4096;
+const size_t kRoaringBitmapWords = 1024;
+
+struct RoaringContainer {
+    // Sorted values; unused once the container is a bitmap.
+    std::vector<uint16_t> array;
+    // kRoaringBitmapWords words when the container holds more than
+    // kRoaringArrayMax values, empty otherwise.
+    std::vector<uint64_t> bits;
+    uint32_t cardinality = 0;
+
+    bool IsBitmap() const { return !bits.empty(); }
+    bool Contains(uint16_t value) const;
+    // Return whether the container changed.
+    bool Add(uint16_t value);
+    bool Remove(uint16_t value);
+};
+
+class RoaringBitmap {
+public:
+    bool Contains(uint32_t id) const;
+    void Add(uint32_t id);
+    void Remove(uint32_t id);
+    bool Empty() const { return _containers.empty(); }
+    uint64_t Cardinality() const;
+
+    RoaringBitmap And(const RoaringBitmap &other) const;
+    RoaringBitmap Or(const RoaringBitmap &other) const;
+    RoaringBitmap AndNot(const RoaringBitmap &other) const;
+
+    // Ascending ids, at most limit of them (0 for all).
+    void ToIds(std::vector<uint32_t> &ids, size_t limit = 0) const;
+
+    // Containers are persisted one per key; an empty container is never stored.
+    std::map<uint16_t, RoaringContainer> &Containers() { return _containers; }
+    const std::map<uint16_t, RoaringContainer> &Containers() const { return _containers; }
+
+private:
+    std::map<uint16_t, RoaringContainer> _containers;
+};
+
+//   0 | fixed16BE values        (array)
+//   1 | 1024 fixed64BE words    (bitmap)
+std::string EncodeRoaringContainer(const RoaringContainer &container);
+bool DecodeRoaringContainer(const leveldb::Slice &value, RoaringContainer &container);
+
+#endif // LEVELDB_ROARING_H
@@ -0,0 +1,164 @@
+#include "ScanFilter.h"
+#include "ObjectCodec.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+static bool IntegerText(const std::string &text, int64_t &value) {
+    if (text.empty() || text.find_first_of(".eE") != std::string::npos) {
+        return false;
+    }
+    char *end = nullptr;
+    errno = 0;
+    value = strtoll(text.c_str(), &end, 10);
+    return *end == '\0' && errno == 0;
+}
+
+// Three-way comparison of two scalars; false if they are not comparable.
+static bool CompareScalars(const JsonValue &a, const JsonValue &b, int &result) {
+    if (a.type != b.type) {
+        return false;
+    }
+    switch (a.type) {
+        case JsonValue::kNull:
+            result = 0;
+            return true;
+        case JsonValue::kBool:
+            result = static_cast<int>(a.boolean) - static_cast<int>(b.boolean);
+            return true;
+        case JsonValue::kNumber: {
+            int64_t x = 0;
+            int64_t y = 0;
+            if (IntegerText(a.text, x) && IntegerText(b.text, y)) {
+                result = x < y ? -1 : (x > y ? 1 : 0);
+            } else {
+                result = a.number < b.number ? -1 : (a.number > b.number ? 1 : 0);
+            }
+            return true;
+        }
+        case JsonValue::kString:
+            result = a.text.compare(b.text);
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool Matches(const WherePredicate &predicate, const JsonValue *value) {
+    if (predicate.op == kWhereExists) {
+        bool exists = value != nullptr && value->type != JsonValue::kNull;
+        return exists == predicate.operand.boolean;
+    }
+    int c = 0;
+    if (value == nullptr || !CompareScalars(*value, predicate.operand, c)) {
+        return false;
+    }
+    switch (predicate.op) {
+        case kWhereEq:
+            return c == 0;
+        case kWhereGt:
+            return c > 0;
+        case kWhereGte:
+            return c >= 0;
+        case kWhereLt:
+            return c < 0;
+        case kWhereLte:
+            return c <= 0;
+        default:
+            return false;
+    }
+}
+
+bool MatchesWhere(const std::vector<WherePredicate> &where, const leveldb::Slice &payload, bool isObject) {
+    if (where.empty()) {
+        return true;
+    }
+    if (isObject) {
+        return MatchesWhere(where, [&payload](const std::string &path, JsonValue &value) {
+            return FindObjectField(payload, path, value);
+        });
+    }
+    // Text is parsed once for all predicates.
+    JsonValue root;
+    bool isJson = ParseJson(payload, root);
+    if (!isJson) {
+        root.type = JsonValue::kString;
+        root.text = payload.ToString();
+    }
+    for (const auto& predicate : where) {
+        const JsonValue *field = isJson || predicate.field.empty() ? root.FindPath(predicate.field) : nullptr;
+        if (!Matches(predicate, field)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MatchesWhere(const std::vector<WherePredicate> &where, const FieldLookup &lookup) {
+    for (const auto& predicate : where) {
+        JsonValue field;
+        if (!Matches(predicate, lookup(predicate.field, field) ? &field : nullptr)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ProjectFields(const std::vector<std::string> &paths, const leveldb::Slice &payload, bool isObject,
+                   JsonValue &record) {
+    record = JsonValue();
+    record.type = JsonValue::kObject;
+    JsonValue root;
+    bool isJson = !isObject && ParseJson(payload, root);
+    if (!isObject && !isJson) {
+        root.type = JsonValue::kString;
+        root.text = payload.ToString();
+    }
+    for (const auto& path : paths) {
+        JsonValue field;
+        if (isObject) {
+            if (FindObjectField(payload, path, field)) {
+                record.members.emplace_back(path, std::move(field));
+            }
+        } else if (isJson || path.empty()) {
+            const JsonValue *found = root.FindPath(path);
+            if (found != nullptr) {
+                record.members.emplace_back(path, *found);
+            }
+        }
+    }
+}
+
+bool ExtractNumber(const leveldb::Slice &payload, bool isObject, const std::string &path, double &value) {
+    if (isObject) {
+        JsonValue field;
+        if (!FindObjectField(payload, path, field) || field.type != JsonValue::kNumber) {
+            return false;
+        }
+        value = field.number;
+        return true;
+    }
+    if (path.empty()) {
+        // Plain numbers are by far the common case and need no JSON parse.
+        char buffer[64];
+        if (payload.empty() || payload.size() >= sizeof(buffer)) {
+            return false;
+        }
+        memcpy(buffer, payload.data(), payload.size());
+        buffer[payload.size()] = '\0';
+        char *end = nullptr;
+        value = strtod(buffer, &end);
+        return *end == '\0' && std::isfinite(value);
+    }
+    JsonValue root;
+    if (!ParseJson(payload, root)) {
+        return false;
+    }
+    const JsonValue *field = root.FindPath(path);
+    if (field == nullptr || field->type != JsonValue::kNumber) {
+        return false;
+    }
+    value = field->number;
+    return true;
+}
@@ -0,0 +1,50 @@
+//
+// Created on 2026/10/19.
+//
+// Predicates and field access evaluated against stored values while
+// scanning, so values that do not match never cross into JS. A value is looked into as a document:
+// objects stored with setObject() are read field by field, text values are
+// parsed as JSON, and any other value counts as a string at the empty path.
+
+#ifndef LEVELDB_SCANFILTER_H
+#define LEVELDB_SCANFILTER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <leveldb/slice.h>
+#include "Json.h"
+
+enum WhereOp : uint8_t {
+    kWhereEq = 0,
+    kWhereGt = 1,
+    kWhereGte = 2,
+    kWhereLt = 3,
+    kWhereLte = 4,
+    // operand.boolean: whether the field must be present and not null.
+    kWhereExists = 5,
+};
+
+struct WherePredicate {
+    // Dotted path into the value; empty is the whole value.
+    std::string field;
+    WhereOp op = kWhereEq;
+    JsonValue operand;
+};
+
+// True when every predicate holds. Numbers compare numerically (exactly for
+// integers), strings bytewise and booleans false < true; a comparison between
+// different types is never true.
+bool MatchesWhere(const std::vector<WherePredicate> &where, const leveldb::Slice &payload, bool isObject);
+// Same, for values whose fields are looked up by the caller (packed records).
+typedef std::function<bool(const std::string &path, JsonValue &value)> FieldLookup;
+bool MatchesWhere(const std::vector<WherePredicate> &where, const FieldLookup &lookup);
+// An object holding the value at each of "paths" (keyed by the path) that
+// exists; the whole value for an empty path.
+void ProjectFields(const std::vector<std::string> &paths, const leveldb::Slice &payload, bool isObject,
+                   JsonValue &record);
+// The number at "path": a JSON number, or with an empty path a value stored
+// by the typed setters ("42", "-1.5"). False for anything else.
+bool ExtractNumber(const leveldb::Slice &payload, bool isObject, const std::string &path, double &value);
+
+#endif // LEVELDB_SCANFILTER_H
@@ -0,0 +1,344 @@
+#include "Schema.h"
+#include "Coding.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+static const std::string kSchemaPrefix = InternalKey("meta:schema:");
+static const char *const kSchemaTypeNames[] = { "bool", "int32", "int64", "double", "string" };
+
+static void PutLengthPrefixed(std::string &dst, const std::string &value) {
+    PutVarint64(dst, value.size());
+    dst.append(value);
+}
+
+static bool GetLengthPrefixed(leveldb::Slice &input, std::string &value) {
+    uint64_t length = 0;
+    if (!GetVarint64(input, length) || length > input.size()) {
+        return false;
+    }
+    value.assign(input.data(), length);
+    input.remove_prefix(length);
+    return true;
+}
+
+bool IsValidSchemaFieldType(int type) {
+    return type >= kSchemaBool && type <= kSchemaString;
+}
+
+bool ValidateSchema(const RecordSchema &schema, std::string *error) {
+    std::string problem;
+    if (schema.name.empty()) {
+        problem = "schema name must not be empty";
+    } else if (schema.fields.empty() || schema.fields.size() > kMaxSchemaFields) {
+        problem = "schema " + schema.name + " must have 1 to " + std::to_string(kMaxSchemaFields) + " fields";
+    }
+    for (size_t i = 0; i < schema.fields.size() && problem.empty(); i++) {
+        const SchemaField &field = schema.fields[i];
+        if (field.name.empty() || field.name.find('.') != std::string::npos) {
+            problem = "invalid field name in schema " + schema.name + ": '" + field.name + "'";
+        } else if (!IsValidSchemaFieldType(field.type)) {
+            problem = "invalid type of field " + field.name;
+        }
+        for (size_t j = 0; j < i && problem.empty(); j++) {
+            if (schema.fields[j].name == field.name) {
+                problem = "duplicate field " + field.name + " in schema " + schema.name;
+            }
+        }
+    }
+    if (!problem.empty() && error) {
+        *error = problem;
+    }
+    return problem.empty();
+}
+
+bool SameFields(const RecordSchema &a, const RecordSchema &b) {
+    if (a.fields.size() != b.fields.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.fields.size(); i++) {
+        if (a.fields[i].name != b.fields[i].name || a.fields[i].type != b.fields[i].type) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string SchemaPrefix() {
+    return kSchemaPrefix;
+}
+
+std::string SchemaKey(uint32_t id) {
+    std::string key = kSchemaPrefix;
+    PutFixed32BE(key, id);
+    return key;
+}
+
+//   name | varint field count | (type, name) per field; names length-prefixed
+std::string EncodeRecordSchema(const RecordSchema &schema) {
+    std::string value;
+    PutLengthPrefixed(value, schema.name);
+    PutVarint64(value, schema.fields.size());
+    for (const auto& field : schema.fields) {
+        value.push_back(static_cast<char>(field.type));
+        PutLengthPrefixed(value, field.name);
+    }
+    return value;
+}
+
+bool DecodeRecordSchema(const leveldb::Slice &value, RecordSchema &schema) {
+    leveldb::Slice input = value;
+    uint64_t count = 0;
+    if (!GetLengthPrefixed(input, schema.name) || !GetVarint64(input, count) || count > kMaxSchemaFields) {
+        return false;
+    }
+    schema.fields.resize(count);
+    for (auto& field : schema.fields) {
+        if (input.empty() || !IsValidSchemaFieldType(static_cast<uint8_t>(input[0]))) {
+            return false;
+        }
+        field.type = static_cast<SchemaFieldType>(static_cast<uint8_t>(input[0]));
+        input.remove_prefix(1);
+        if (!GetLengthPrefixed(input, field.name)) {
+            return false;
+        }
+    }
+    return input.empty();
+}
+
+// Integers keep their literal, so int64 values beyond 2^53 stay exact.
+static bool IntegerOf(const JsonValue &value, int64_t &integer) {
+    if (value.type != JsonValue::kNumber) {
+        return false;
+    }
+    if (!value.text.empty() && value.text.find_first_of(".eE") == std::string::npos) {
+        char *end = nullptr;
+        errno = 0;
+        integer = strtoll(value.text.c_str(), &end, 10);
+        return *end == '\0' && errno == 0;
+    }
+    if (std::trunc(value.number) != value.number || value.number < -9223372036854775808.0 ||
+        value.number >= 9223372036854775808.0) {
+        return false;
+    }
+    integer = static_cast<int64_t>(value.number);
+    return true;
+}
+
+static bool PackField(const SchemaField &field, const JsonValue &value, std::string &data) {
+    int64_t integer = 0;
+    switch (field.type) {
+        case kSchemaBool:
+            if (value.type != JsonValue::kBool) {
+                return false;
+            }
+            data.push_back(value.boolean ? 1 : 0);
+            return true;
+        case kSchemaInt32:
+            if (!IntegerOf(value, integer) || integer < INT32_MIN || integer > INT32_MAX) {
+                return false;
+            }
+            PutFixed32BE(data, static_cast<uint32_t>(static_cast<int32_t>(integer)));
+            return true;
+        case kSchemaInt64:
+            if (!IntegerOf(value, integer)) {
+                return false;
+            }
+            PutFixed64BE(data, static_cast<uint64_t>(integer));
+            return true;
+        case kSchemaDouble: {
+            if (value.type != JsonValue::kNumber) {
+                return false;
+            }
+            uint64_t bits = 0;
+            memcpy(&bits, &value.number, sizeof(bits));
+            PutFixed64BE(data, bits);
+            return true;
+        }
+        case kSchemaString:
+            if (value.type != JsonValue::kString) {
+                return false;
+            }
+            data.append(value.text);
+            return true;
+    }
+    return false;
+}
+
+bool PackRecord(const RecordSchema &schema, const JsonValue &record, std::string &packed, std::string *error) {
+    std::string problem;
+    if (record.type != JsonValue::kObject) {
+        problem = "records of schema " + schema.name + " must be objects";
+    }
+    for (size_t i = 0; i < record.members.size() && problem.empty(); i++) {
+        const std::string &name = record.members[i].first;
+        bool known = false;
+        for (const auto& field : schema.fields) {
+            known = known || field.name == name;
+        }
+        if (!known) {
+            problem = "field " + name + " is not in schema " + schema.name;
+        }
+    }
+    size_t count = schema.fields.size();
+    std::string bitmap((count + 7) / 8, '\0');
+    std::string table;
+    std::string data;
+    for (size_t i = 0; i < count && problem.empty(); i++) {
+        const SchemaField &field = schema.fields[i];
+        const JsonValue *value = record.Find(field.name);
+        if (value != nullptr && value->type != JsonValue::kNull) {
+            if (!PackField(field, *value, data)) {
+                problem = "field " + field.name + " of schema " + schema.name + " must be " +
+                          kSchemaTypeNames[field.type];
+            }
+            bitmap[i / 8] |= static_cast<char>(1 << (i % 8));
+        }
+        PutFixed32BE(table, static_cast<uint32_t>(data.size()));
+    }
+    if (!problem.empty()) {
+        if (error) {
+            *error = problem;
+        }
+        return false;
+    }
+    packed.clear();
+    PutVarint64(packed, schema.id);
+    packed.append(bitmap);
+    packed.append(table);
+    packed.append(data);
+    return true;
+}
+
+bool PackedSchemaId(const leveldb::Slice &packed, uint32_t &id) {
+    leveldb::Slice input = packed;
+    uint64_t value = 0;
+    if (!GetVarint64(input, value) || value > UINT32_MAX) {
+        return false;
+    }
+    id = static_cast<uint32_t>(value);
+    return true;
+}
+
+// The parts of a packed record; nothing is copied.
+struct PackedView {
+    const char *bitmap = nullptr;
+    const char *table = nullptr;
+    const char *data = nullptr;
+    size_t dataSize = 0;
+};
+
+static bool ViewOf(const RecordSchema &schema, const leveldb::Slice &packed, PackedView &view) {
+    leveldb::Slice input = packed;
+    uint64_t id = 0;
+    size_t count = schema.fields.size();
+    size_t bitmapSize = (count + 7) / 8;
+    if (!GetVarint64(input, id) || id != schema.id || input.size() < bitmapSize + count * 4) {
+        return false;
+    }
+    view.bitmap = input.data();
+    view.table = input.data() + bitmapSize;
+    view.data = view.table + count * 4;
+    view.dataSize = input.size() - bitmapSize - count * 4;
+    return true;
+}
+
+static bool ReadField(const SchemaField &field, const PackedView &view, size_t index, JsonValue &value) {
+    if (((static_cast<uint8_t>(view.bitmap[index / 8]) >> (index % 8)) & 1) == 0) {
+        return false;
+    }
+    uint32_t begin = index == 0 ? 0 : DecodeFixed32BE(view.table + (index - 1) * 4);
+    uint32_t end = DecodeFixed32BE(view.table + index * 4);
+    if (begin > end || end > view.dataSize) {
+        return false;
+    }
+    const char *ptr = view.data + begin;
+    size_t size = end - begin;
+    value = JsonValue();
+    switch (field.type) {
+        case kSchemaBool:
+            if (size != 1) {
+                return false;
+            }
+            value.type = JsonValue::kBool;
+            value.boolean = *ptr != 0;
+            return true;
+        case kSchemaInt32:
+        case kSchemaInt64: {
+            if (size != (field.type == kSchemaInt32 ? 4 : 8)) {
+                return false;
+            }
+            int64_t integer = size == 4 ? static_cast<int32_t>(DecodeFixed32BE(ptr))
+                                        : static_cast<int64_t>(DecodeFixed64BE(ptr));
+            value.type = JsonValue::kNumber;
+            value.number = static_cast<double>(integer);
+            value.text = std::to_string(integer);
+            return true;
+        }
+        case kSchemaDouble: {
+            if (size != 8) {
+                return false;
+            }
+            uint64_t bits = DecodeFixed64BE(ptr);
+            value.type = JsonValue::kNumber;
+            memcpy(&value.number, &bits, sizeof(bits));
+            return true;
+        }
+        case kSchemaString:
+            value.type = JsonValue::kString;
+            value.text.assign(ptr, size);
+            return true;
+    }
+    return false;
+}
+
+bool UnpackRecord(const RecordSchema &schema, const leveldb::Slice &packed, JsonValue &record) {
+    PackedView view;
+    if (!ViewOf(schema, packed, view)) {
+        return false;
+    }
+    record = JsonValue();
+    record.type = JsonValue::kObject;
+    for (size_t i = 0; i < schema.fields.size(); i++) {
+        JsonValue value;
+        if (ReadField(schema.fields[i], view, i, value)) {
+            record.members.emplace_back(schema.fields[i].name, std::move(value));
+        }
+    }
+    return true;
+}
+
+bool FindPackedField(const RecordSchema &schema, const leveldb::Slice &packed, const std::string &name,
+                     JsonValue &value) {
+    PackedView view;
+    if (!ViewOf(schema, packed, view)) {
+        return false;
+    }
+    for (size_t i = 0; i < schema.fields.size(); i++) {
+        if (schema.fields[i].name == name) {
+            return ReadField(schema.fields[i], view, i, value);
+        }
+    }
+    return false;
+}
+
+bool ProjectPackedRecord(const RecordSchema &schema, const leveldb::Slice &packed,
+                         const std::vector<std::string> &fields, JsonValue &record) {
+    PackedView view;
+    if (!ViewOf(schema, packed, view)) {
+        return false;
+    }
+    record = JsonValue();
+    record.type = JsonValue::kObject;
+    for (const auto& name : fields) {
+        for (size_t i = 0; i < schema.fields.size(); i++) {
+            JsonValue value;
+            if (schema.fields[i].name == name && ReadField(schema.fields[i], view, i, value)) {
+                record.members.emplace_back(name, std::move(value));
+                break;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,70 @@
+//
+// Created on 2026/10/19.
+//
+// Records of a defined schema are stored packed instead of as documents:
+//   varint schema id | presence bitmap (1 bit per field) |
+//   end offset per field (fixed32 BE) | field data
+// Field i occupies [end[i-1], end[i]) of the data (end[-1] is 0); absent and
+// null fields take no bytes. bool is one byte, int32 4 bytes, int64 and
+// double 8 bytes big-endian (doubles as IEEE bits), strings are raw bytes.
+// The offset table lets a read decode just the columns it asks for.
+//
+// A schema is never changed in place: defining a name again with other
+// fields adds a new version with a new id, and rows keep pointing at the
+// layout they were written with.
+
+#ifndef LEVELDB_SCHEMA_H
+#define LEVELDB_SCHEMA_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <leveldb/slice.h>
+#include "Json.h"
+
+enum SchemaFieldType : uint8_t {
+    kSchemaBool = 0,
+    kSchemaInt32 = 1,
+    kSchemaInt64 = 2,
+    kSchemaDouble = 3,
+    kSchemaString = 4,
+};
+
+struct SchemaField {
+    std::string name;
+    SchemaFieldType type = kSchemaString;
+};
+
+struct RecordSchema {
+    uint32_t id = 0;
+    std::string name;
+    std::vector<SchemaField> fields;
+};
+
+const size_t kMaxSchemaFields = 1024;
+
+bool IsValidSchemaFieldType(int type);
+// Names must be unique, non-empty and free of '.', which separates paths.
+bool ValidateSchema(const RecordSchema &schema, std::string *error);
+bool SameFields(const RecordSchema &a, const RecordSchema &b);
+
+// Definitions are persisted under meta keys by id.
+std::string SchemaPrefix();
+std::string SchemaKey(uint32_t id);
+std::string EncodeRecordSchema(const RecordSchema &schema);
+bool DecodeRecordSchema(const leveldb::Slice &value, RecordSchema &schema);
+
+// Members that are not fields of the schema, and values of the wrong type,
+// are rejected rather than dropped.
+bool PackRecord(const RecordSchema &schema, const JsonValue &record, std::string &packed, std::string *error);
+bool PackedSchemaId(const leveldb::Slice &packed, uint32_t &id);
+// Every present field, in schema order.
+bool UnpackRecord(const RecordSchema &schema, const leveldb::Slice &packed, JsonValue &record);
+// False if the field is absent or not in the schema.
+bool FindPackedField(const RecordSchema &schema, const leveldb::Slice &packed, const std::string &name,
+                     JsonValue &value);
+// An object with the requested fields that are present, in request order.
+bool ProjectPackedRecord(const RecordSchema &schema, const leveldb::Slice &packed,
+                         const std::vector<std::string> &fields, JsonValue &record);
+
+#endif // LEVELDB_SCHEMA_H
@@ -0,0 +1,224 @@
+#include "SecondaryIndex.h"
+#include "Coding.h"
+#include "Json.h"
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+
+static const std::string kIndexEntryPrefix = InternalKey("idx:");
+static const std::string kIndexSpecPrefix = InternalKey("meta:idx:");
+
+bool operator==(const IndexSpec &a, const IndexSpec &b) {
+    return a.name == b.name && a.field == b.field && a.keyPrefix == b.keyPrefix && a.type == b.type &&
+           a.scoreField == b.scoreField;
+}
+
+bool IsValidIndexType(int type) {
+    return type >= kIndexValueAuto && type <= kIndexValueCompletion;
+}
+
+static bool ParseInt64Text(const std::string &text, int64_t &value) {
+    if (text.empty()) {
+        return false;
+    }
+    char *end = nullptr;
+    errno = 0;
+    value = strtoll(text.c_str(), &end, 10);
+    return *end == '\0' && errno == 0;
+}
+
+static bool ParseDoubleText(const std::string &text, double &value) {
+    if (text.empty()) {
+        return false;
+    }
+    char *end = nullptr;
+    value = strtod(text.c_str(), &end);
+    return *end == '\0' && !std::isnan(value);
+}
+
+bool ExtractIndexField(const IndexSpec &spec, const std::string &value, KeyPart &field) {
+    if (spec.type == kIndexValueTags || spec.type == kIndexValueCompletion) {
+        return false;
+    }
+    JsonValue root;
+    const JsonValue *json = nullptr;
+    if (ParseJson(value, root)) {
+        json = root.FindPath(spec.field);
+    } else if (!spec.field.empty()) {
+        return false;
+    }
+
+    if (json == nullptr) {
+        // The whole value, which is not JSON (typically a plain string).
+        if (spec.type == kIndexValueAuto || spec.type == kIndexValueString) {
+            field.type = kKeyPartString;
+            field.bytes = value;
+            return true;
+        }
+        return false;
+    }
+    switch (json->type) {
+        case JsonValue::kString:
+            field.type = kKeyPartString;
+            field.bytes = json->text;
+            break;
+        case JsonValue::kNumber:
+            if (spec.type == kIndexValueString) {
+                field.type = kKeyPartString;
+                field.bytes = json->text;
+            } else {
+                field.type = kKeyPartDouble;
+                field.number = json->number;
+            }
+            break;
+        case JsonValue::kBool:
+            field.type = kKeyPartInt64;
+            field.int64 = json->boolean ? 1 : 0;
+            break;
+        default:
+            return false;
+    }
+    if (spec.type == kIndexValueInt64 && json->type == JsonValue::kNumber) {
+        // Re-read the literal so values above 2^53 keep their precision.
+        field.type = kKeyPartInt64;
+        return ParseInt64Text(json->text, field.int64);
+    }
+    return CoerceIndexField(spec, field);
+}
+
+bool CoerceIndexField(const IndexSpec &spec, KeyPart &field) {
+    switch (spec.type) {
+        case kIndexValueAuto:
+            if (field.type == kKeyPartUInt64) {
+                field.type = kKeyPartDouble;
+                field.number = static_cast<double>(field.uint64);
+            }
+            return field.type != kKeyPartBytes;
+        case kIndexValueString:
+            if (field.type == kKeyPartString) {
+                return true;
+            }
+            return false;
+        case kIndexValueNumber:
+            if (field.type == kKeyPartString) {
+                field.type = kKeyPartDouble;
+                return ParseDoubleText(field.bytes, field.number);
+            } else if (field.type == kKeyPartInt64) {
+                field.type = kKeyPartDouble;
+                field.number = static_cast<double>(field.int64);
+            } else if (field.type == kKeyPartUInt64) {
+                field.type = kKeyPartDouble;
+                field.number = static_cast<double>(field.uint64);
+            }
+            return field.type == kKeyPartDouble;
+        case kIndexValueInt64:
+            if (field.type == kKeyPartString) {
+                field.type = kKeyPartInt64;
+                return ParseInt64Text(field.bytes, field.int64);
+            } else if (field.type == kKeyPartDouble) {
+                if (field.number != std::floor(field.number) || std::fabs(field.number) >= 9.2e18) {
+                    return false;
+                }
+                field.type = kKeyPartInt64;
+                field.int64 = static_cast<int64_t>(field.number);
+            } else if (field.type == kKeyPartUInt64) {
+                if (field.uint64 > static_cast<uint64_t>(INT64_MAX)) {
+                    return false;
+                }
+                field.type = kKeyPartInt64;
+                field.int64 = static_cast<int64_t>(field.uint64);
+            }
+            return field.type == kKeyPartInt64;
+        case kIndexValueTags:
+        case kIndexValueCompletion:
+            return false;
+    }
+    return false;
+}
+
+std::string IndexEntryPrefix(const std::string &name) {
+    KeyPart part;
+    part.type = kKeyPartString;
+    part.bytes = name;
+    std::string prefix = kIndexEntryPrefix;
+    EncodeKeyPart(prefix, part);
+    return prefix;
+}
+
+std::string IndexEntryKey(const std::string &name, const KeyPart &field, const std::string &key) {
+    KeyPart primary;
+    primary.type = kKeyPartBytes;
+    primary.bytes = key;
+    std::string entry = IndexEntryPrefix(name);
+    EncodeKeyPart(entry, field);
+    EncodeKeyPart(entry, primary);
+    return entry;
+}
+
+bool DecodeIndexEntryKey(const leveldb::Slice &entry, KeyPart &field, std::string &key) {
+    if (!entry.starts_with(kIndexEntryPrefix)) {
+        return false;
+    }
+    std::vector<KeyPart> parts;
+    leveldb::Slice tuple(entry.data() + kIndexEntryPrefix.size(), entry.size() - kIndexEntryPrefix.size());
+    if (!DecodeKeyTuple(tuple, parts) || parts.size() != 3 || parts[2].type != kKeyPartBytes) {
+        return false;
+    }
+    field = std::move(parts[1]);
+    key = std::move(parts[2].bytes);
+    return true;
+}
+
+std::string IndexSpecPrefix() {
+    return kIndexSpecPrefix;
+}
+
+std::string IndexSpecKey(const std::string &name) {
+    return kIndexSpecPrefix + name;
+}
+
+//   ready | type | fixed32 field length | field | keyPrefix
+// Completion indexes put fixed32 score field length | score field before
+// the key prefix.
+std::string EncodeIndexSpec(const IndexSpec &spec, bool ready) {
+    std::string value;
+    value.push_back(ready ? 1 : 0);
+    value.push_back(static_cast<char>(spec.type));
+    PutFixed32BE(value, static_cast<uint32_t>(spec.field.size()));
+    value.append(spec.field);
+    if (spec.type == kIndexValueCompletion) {
+        PutFixed32BE(value, static_cast<uint32_t>(spec.scoreField.size()));
+        value.append(spec.scoreField);
+    }
+    value.append(spec.keyPrefix);
+    return value;
+}
+
+bool DecodeIndexSpec(const leveldb::Slice &value, IndexSpec &spec, bool &ready) {
+    if (value.size() < 6 || !IsValidIndexType(static_cast<uint8_t>(value[1]))) {
+        return false;
+    }
+    ready = value[0] != 0;
+    spec.type = static_cast<IndexValueType>(static_cast<uint8_t>(value[1]));
+    uint32_t fieldLength = DecodeFixed32BE(value.data() + 2);
+    if (value.size() - 6 < fieldLength) {
+        return false;
+    }
+    spec.field.assign(value.data() + 6, fieldLength);
+    size_t offset = 6 + fieldLength;
+    if (spec.type == kIndexValueCompletion) {
+        if (value.size() - offset < 4) {
+            return false;
+        }
+        uint32_t scoreLength = DecodeFixed32BE(value.data() + offset);
+        offset += 4;
+        if (value.size() - offset < scoreLength) {
+            return false;
+        }
+        spec.scoreField.assign(value.data() + offset, scoreLength);
+        offset += scoreLength;
+    }
+    spec.keyPrefix.assign(value.data() + offset, value.size() - offset);
+    return true;
+}
@@ -0,0 +1,76 @@
+//
+// Created on 2026/10/19.
+//
+// Secondary index definitions and the layout of their entries. An entry is
+// an internal key
+//   idx: | tuple(name, field, primary key)
+// with an empty value, so entries of one index are ordered by field and
+// then by primary key, and a field range is a single key range.
+
+#ifndef LEVELDB_SECONDARYINDEX_H
+#define LEVELDB_SECONDARYINDEX_H
+
+#include <string>
+#include <vector>
+#include "KeyCodec.h"
+
+enum IndexValueType : uint8_t {
+    // JSON numbers as doubles, strings as strings, booleans as 0/1; a value
+    // that is not JSON is indexed as its text.
+    kIndexValueAuto = 0,
+    kIndexValueString = 1,
+    kIndexValueNumber = 2,
+    kIndexValueInt64 = 3,
+    // Each value carries a set of tags, kept as roaring bitmaps and queried
+    // with QueryTags() rather than field ranges (see TagIndex.h).
+    kIndexValueTags = 4,
+    // Prefixes of the words of a text, ranked by a score field and queried
+    // with Complete() (see Completion.h).
+    kIndexValueCompletion = 5,
+};
+
+struct IndexSpec {
+    std::string name;
+    // Dotted path into a JSON value; empty indexes the whole value.
+    std::string field;
+    // Only keys starting with this prefix are indexed.
+    std::string keyPrefix;
+    IndexValueType type = kIndexValueAuto;
+    // Dotted path to the number completions are ranked by; completion
+    // indexes only.
+    std::string scoreField;
+};
+
+bool operator==(const IndexSpec &a, const IndexSpec &b);
+
+// Field range of a query; bounds are coerced to the index type.
+struct IndexQuery {
+    bool hasLower = false;
+    bool lowerInclusive = true;
+    KeyPart lower;
+    bool hasUpper = false;
+    bool upperInclusive = true;
+    KeyPart upper;
+    size_t limit = 0;
+    bool reverse = false;
+};
+
+bool IsValidIndexType(int type);
+// The field a value is indexed under; false if it has none.
+bool ExtractIndexField(const IndexSpec &spec, const std::string &value, KeyPart &field);
+// Converts a query bound to the representation the index stores.
+bool CoerceIndexField(const IndexSpec &spec, KeyPart &field);
+
+// Prefix shared by all entries of an index.
+std::string IndexEntryPrefix(const std::string &name);
+std::string IndexEntryKey(const std::string &name, const KeyPart &field, const std::string &key);
+bool DecodeIndexEntryKey(const leveldb::Slice &entry, KeyPart &field, std::string &key);
+
+// Definitions are persisted under meta keys; "ready" is false while the
+// index is still being backfilled.
+std::string IndexSpecPrefix();
+std::string IndexSpecKey(const std::string &name);
+std::string EncodeIndexSpec(const IndexSpec &spec, bool ready);
+bool DecodeIndexSpec(const leveldb::Slice &value, IndexSpec &spec, bool &ready);
+
+#endif // LEVELDB_SECONDARYINDEX_H
@@ -0,0 +1,77 @@
+#include "SortedSet.h"
+#include "Coding.h"
+#include "KeyCodec.h"
+#include <cstring>
+#include <vector>
+
+static const std::string kMemberPrefix = InternalKey("zsm:");
+static const std::string kScorePrefix = InternalKey("zss:");
+static const std::string kCountPrefix = InternalKey("zsc:");
+
+static KeyPart StringPart(const std::string &value) {
+    KeyPart part;
+    part.type = kKeyPartString;
+    part.bytes = value;
+    return part;
+}
+
+std::string SortedSetMemberKey(const std::string &name, const std::string &member) {
+    std::string key = kMemberPrefix;
+    EncodeKeyPart(key, StringPart(name));
+    EncodeKeyPart(key, StringPart(member));
+    return key;
+}
+
+std::string SortedSetScorePrefix(const std::string &name) {
+    std::string prefix = kScorePrefix;
+    EncodeKeyPart(prefix, StringPart(name));
+    return prefix;
+}
+
+std::string SortedSetScoreKey(const std::string &name, double score, const std::string &member) {
+    KeyPart scorePart;
+    scorePart.type = kKeyPartDouble;
+    scorePart.number = score;
+    std::string key = SortedSetScorePrefix(name);
+    EncodeKeyPart(key, scorePart);
+    EncodeKeyPart(key, StringPart(member));
+    return key;
+}
+
+bool DecodeSortedSetScoreKey(const leveldb::Slice &entry, SortedSetMember &member) {
+    if (!entry.starts_with(kScorePrefix)) {
+        return false;
+    }
+    std::vector<KeyPart> parts;
+    leveldb::Slice tuple(entry.data() + kScorePrefix.size(), entry.size() - kScorePrefix.size());
+    if (!DecodeKeyTuple(tuple, parts) || parts.size() != 3 || parts[1].type != kKeyPartDouble ||
+        parts[2].type != kKeyPartString) {
+        return false;
+    }
+    member.score = parts[1].number;
+    member.member = std::move(parts[2].bytes);
+    return true;
+}
+
+std::string SortedSetCountKey(const std::string &name) {
+    std::string key = kCountPrefix;
+    EncodeKeyPart(key, StringPart(name));
+    return key;
+}
+
+std::string EncodeScore(double score) {
+    uint64_t bits = 0;
+    memcpy(&bits, &score, sizeof(bits));
+    std::string value;
+    PutFixed64BE(value, bits);
+    return value;
+}
+
+bool DecodeScore(const leveldb::Slice &value, double &score) {
+    if (value.size() != 8) {
+        return false;
+    }
+    uint64_t bits = DecodeFixed64BE(value.data());
+    memcpy(&score, &bits, sizeof(score));
+    return true;
+}
@@ -0,0 +1,46 @@
+//
+// Created on 2026/10/19.
+//
+// Layout of sorted sets. Every set is three groups of internal keys:
+//   zsm: | tuple(name, member)        -> score (fixed64 IEEE bits)
+//   zss: | tuple(name, score, member) -> empty
+//   zsc: | tuple(name)                -> member count (fixed64)
+// The member map answers zscore() with one Get; the score index is ordered
+// by score and then member, so a score range is one key range. All three
+// change in the same WriteBatch.
+
+#ifndef LEVELDB_SORTEDSET_H
+#define LEVELDB_SORTEDSET_H
+
+#include <string>
+#include <leveldb/slice.h>
+
+struct SortedSetMember {
+    std::string member;
+    double score = 0;
+};
+
+// Score range of zrangeByScore(); offset skips matches before limit applies.
+struct ScoreRange {
+    bool hasMin = false;
+    bool minInclusive = true;
+    double min = 0;
+    bool hasMax = false;
+    bool maxInclusive = true;
+    double max = 0;
+    size_t offset = 0;
+    size_t limit = 0;
+    bool reverse = false;
+};
+
+std::string SortedSetMemberKey(const std::string &name, const std::string &member);
+// Prefix shared by the score entries of one set.
+std::string SortedSetScorePrefix(const std::string &name);
+std::string SortedSetScoreKey(const std::string &name, double score, const std::string &member);
+bool DecodeSortedSetScoreKey(const leveldb::Slice &entry, SortedSetMember &member);
+std::string SortedSetCountKey(const std::string &name);
+
+std::string EncodeScore(double score);
+bool DecodeScore(const leveldb::Slice &value, double &score);
+
+#endif // LEVELDB_SORTEDSET_H
@@ -0,0 +1,238 @@
+#include "Stream.h"
+#include "Coding.h"
+#include "KeyCodec.h"
+#include <algorithm>
+
+static const std::string kStreamManifestPrefix = InternalKey("stm:");
+static const std::string kStreamChunkPrefix = InternalKey("stc:");
+
+static std::string KeyPartOf(const std::string &key) {
+    KeyPart part;
+    part.type = kKeyPartString;
+    part.bytes = key;
+    std::string encoded;
+    EncodeKeyPart(encoded, part);
+    return encoded;
+}
+
+std::string StreamManifestKey(const std::string &key) {
+    return kStreamManifestPrefix + KeyPartOf(key);
+}
+
+std::string StreamChunkPrefix(const std::string &key) {
+    return kStreamChunkPrefix + KeyPartOf(key);
+}
+
+std::string StreamChunkKey(const std::string &key, uint64_t generation, uint32_t index) {
+    std::string chunkKey = StreamChunkPrefix(key);
+    PutFixed64BE(chunkKey, generation);
+    PutFixed32BE(chunkKey, index);
+    return chunkKey;
+}
+
+std::string EncodeStreamManifest(const StreamManifest &manifest) {
+    std::string value;
+    PutFixed64BE(value, manifest.generation);
+    PutFixed64BE(value, manifest.length);
+    PutFixed32BE(value, manifest.chunkSize);
+    return value;
+}
+
+bool DecodeStreamManifest(const leveldb::Slice &value, StreamManifest &manifest) {
+    if (value.size() != 20) {
+        return false;
+    }
+    manifest.generation = DecodeFixed64BE(value.data());
+    manifest.length = DecodeFixed64BE(value.data() + 8);
+    manifest.chunkSize = DecodeFixed32BE(value.data() + 16);
+    return manifest.chunkSize > 0;
+}
+
+uint64_t NextStreamGeneration(leveldb::DB *db, const leveldb::ReadOptions &readOptions) {
+    uint64_t next = 0;
+    leveldb::Iterator* it = db->NewIterator(readOptions);
+    for (it->Seek(kStreamManifestPrefix); it->Valid() && it->key().starts_with(kStreamManifestPrefix); it->Next()) {
+        StreamManifest manifest;
+        if (DecodeStreamManifest(it->value(), manifest)) {
+            next = std::max(next, manifest.generation + 1);
+        }
+    }
+    // Chunks sort by generation within a key, so the last chunk of each key
+    // holds its highest one; seeking past each key skips the rest.
+    it->Seek(kStreamChunkPrefix);
+    while (it->Valid() && it->key().starts_with(kStreamChunkPrefix) && it->key().size() >= 12) {
+        std::string keyPrefix(it->key().data(), it->key().size() - 12);
+        it->Seek(PrefixSuccessor(keyPrefix));
+        if (it->Valid()) {
+            it->Prev();
+        } else {
+            it->SeekToLast();
+        }
+        if (it->Valid() && it->key().starts_with(keyPrefix) && it->key().size() == keyPrefix.size() + 12) {
+            next = std::max(next, DecodeFixed64BE(it->key().data() + keyPrefix.size()) + 1);
+        }
+        it->Seek(PrefixSuccessor(keyPrefix));
+    }
+    delete it;
+    return next;
+}
+
+StreamWriter::StreamWriter(LevelDB *db, const std::string &key, uint32_t chunkSize)
+    : _db(db), _key(key), _chunkSize(chunkSize > 0 ? chunkSize : kDefaultChunkSize), _generation(0), _chunks(0),
+      _length(0), _failed(false), _done(false) {
+    _generation = _db->_streamGeneration++;
+}
+
+StreamWriter::~StreamWriter() {
+    if (!_done) {
+        Abort();
+    }
+}
+
+bool StreamWriter::WriteChunk(const leveldb::Slice &chunk) {
+    leveldb::WriteBatch batch;
+    batch.Put(StreamChunkKey(_key, _generation, _chunks), chunk);
+    if (!_db->Commit(batch)) {
+        _failed = true;
+        return false;
+    }
+    _chunks++;
+    _length += chunk.size();
+    return true;
+}
+
+bool StreamWriter::Write(const leveldb::Slice &data) {
+    if (_failed || _done) {
+        return false;
+    }
+    leveldb::Slice rest = data;
+    while (!rest.empty()) {
+        if (_buffer.empty() && rest.size() >= _chunkSize) {
+            // Whole chunks go straight from the caller's data.
+            if (!WriteChunk(leveldb::Slice(rest.data(), _chunkSize))) {
+                return false;
+            }
+            rest.remove_prefix(_chunkSize);
+            continue;
+        }
+        size_t take = std::min<size_t>(_chunkSize - _buffer.size(), rest.size());
+        _buffer.append(rest.data(), take);
+        rest.remove_prefix(take);
+        if (_buffer.size() == _chunkSize) {
+            if (!WriteChunk(_buffer)) {
+                return false;
+            }
+            _buffer.clear();
+        }
+    }
+    return true;
+}
+
+bool StreamWriter::Finish() {
+    if (_done) {
+        return false;
+    }
+    if (_failed || (!_buffer.empty() && !WriteChunk(_buffer))) {
+        Abort();
+        return false;
+    }
+    _buffer.clear();
+
+    std::string manifestKey = StreamManifestKey(_key);
+    LevelDB::KeyLockGuard lock(*_db, manifestKey);
+    std::string value;
+    StreamManifest published;
+    if (_db->_db->Get(_db->_readOptions, manifestKey, &value).ok() && DecodeStreamManifest(value, published) &&
+        published.generation > _generation) {
+        // A writer that started later has already finished; its value wins.
+        Abort();
+        return false;
+    }
+
+    leveldb::WriteBatch batch;
+    StreamManifest manifest;
+    manifest.generation = _generation;
+    manifest.length = _length;
+    manifest.chunkSize = _chunkSize;
+    batch.Put(manifestKey, EncodeStreamManifest(manifest));
+    // Older generations: the value being replaced and whatever writers that
+    // never finished left behind. Newer ones belong to writers still running.
+    std::string prefix = StreamChunkPrefix(_key);
+    std::string limit = prefix;
+    PutFixed64BE(limit, _generation);
+    leveldb::ReadOptions readOptions = _db->_readOptions;
+    readOptions.fill_cache = false;
+    leveldb::Iterator* it = _db->_db->NewIterator(readOptions);
+    for (it->Seek(prefix); it->Valid() && it->key().compare(limit) < 0; it->Next()) {
+        batch.Delete(it->key());
+    }
+    delete it;
+    _done = _db->Commit(batch);
+    if (!_done) {
+        Abort();
+    }
+    return _done;
+}
+
+void StreamWriter::Abort() {
+    _done = true;
+    _buffer.clear();
+    if (_chunks == 0) {
+        return;
+    }
+    leveldb::WriteBatch batch;
+    for (uint32_t index = 0; index < _chunks; index++) {
+        batch.Delete(StreamChunkKey(_key, _generation, index));
+    }
+    _db->Commit(batch);
+    _chunks = 0;
+}
+
+StreamReader::StreamReader(LevelDB *db, const std::string &key)
+    : _db(db), _key(key), _exists(false), _position(0), _hasChunk(false), _chunkIndex(0) {
+    std::string value;
+    _exists = _db->_db->Get(_db->_readOptions, StreamManifestKey(key), &value).ok() &&
+              DecodeStreamManifest(value, _manifest);
+}
+
+bool StreamReader::LoadChunk(uint32_t index) {
+    if (_hasChunk && _chunkIndex == index) {
+        return true;
+    }
+    // Large values would only push the working set out of the block cache.
+    leveldb::ReadOptions readOptions = _db->_readOptions;
+    readOptions.fill_cache = false;
+    _hasChunk = _db->_db->Get(readOptions, StreamChunkKey(_key, _manifest.generation, index), &_chunk).ok();
+    _chunkIndex = index;
+    return _hasChunk;
+}
+
+bool StreamReader::ReadAt(uint64_t offset, size_t length, std::string &data) {
+    data.clear();
+    if (!_exists) {
+        return false;
+    }
+    if (offset >= _manifest.length) {
+        return true;
+    }
+    length = static_cast<size_t>(std::min<uint64_t>(length, _manifest.length - offset));
+    data.reserve(length);
+    while (data.size() < length) {
+        uint64_t at = offset + data.size();
+        size_t within = static_cast<size_t>(at % _manifest.chunkSize);
+        if (!LoadChunk(static_cast<uint32_t>(at / _manifest.chunkSize)) || within >= _chunk.size()) {
+            data.clear();
+            return false;
+        }
+        data.append(_chunk, within, std::min(_chunk.size() - within, length - data.size()));
+    }
+    return true;
+}
+
+bool StreamReader::Read(size_t maxBytes, std::string &data) {
+    if (!ReadAt(_position, maxBytes, data)) {
+        return false;
+    }
+    _position += data.size();
+    return true;
+}
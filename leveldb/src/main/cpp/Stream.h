@@ -0,0 +1,93 @@
+//
+// Created on 2026/10/19.
+//
+// Values too large to handle in one piece, stored as numbered chunks apart
+// from regular keys:
+//   stm: | tuple(key)                                      -> manifest
+//   stc: | tuple(key) | fixed64 generation | fixed32 index -> chunk
+// manifest: fixed64 generation | fixed64 length | fixed32 chunk size
+// A writer fills a fresh generation and publishes it with the manifest, so
+// readers never see a half-written value; the previous generation's chunks
+// are deleted in the same batch.
+
+#ifndef LEVELDB_STREAM_H
+#define LEVELDB_STREAM_H
+
+#include <string>
+#include <stdint.h>
+#include "LevelDB.h"
+
+struct StreamManifest {
+    uint64_t generation = 0;
+    uint64_t length = 0;
+    uint32_t chunkSize = 0;
+};
+
+std::string StreamManifestKey(const std::string &key);
+// Prefix of every chunk of key, of all generations.
+std::string StreamChunkPrefix(const std::string &key);
+std::string StreamChunkKey(const std::string &key, uint64_t generation, uint32_t index);
+std::string EncodeStreamManifest(const StreamManifest &manifest);
+bool DecodeStreamManifest(const leveldb::Slice &value, StreamManifest &manifest);
+// One past the highest generation of any manifest or chunk, so that writers
+// of a new session always outrank what earlier sessions left behind.
+uint64_t NextStreamGeneration(leveldb::DB *db, const leveldb::ReadOptions &readOptions);
+
+class StreamWriter {
+public:
+    static const uint32_t kDefaultChunkSize = 64 << 10;
+
+    StreamWriter(LevelDB *db, const std::string &key, uint32_t chunkSize = kDefaultChunkSize);
+    // Abandons the value unless Finish() succeeded.
+    ~StreamWriter();
+
+    // Buffers at most one chunk; full chunks are written right away.
+    bool Write(const leveldb::Slice &data);
+    // Publishes the value in place of the previous one. False if any write
+    // failed or a writer that started later has already published, in which
+    // case nothing is published.
+    bool Finish();
+    void Abort();
+
+private:
+    bool WriteChunk(const leveldb::Slice &chunk);
+
+    LevelDB *_db;
+    std::string _key;
+    uint32_t _chunkSize;
+    uint64_t _generation;
+    uint32_t _chunks;
+    uint64_t _length;
+    std::string _buffer;
+    bool _failed;
+    bool _done;
+};
+
+class StreamReader {
+public:
+    StreamReader(LevelDB *db, const std::string &key);
+
+    bool Exists() const { return _exists; }
+    uint64_t Length() const { return _manifest.length; }
+    // Up to length bytes from offset; fewer only at the end of the value.
+    // False once the value has been replaced or removed since the reader
+    // was opened.
+    bool ReadAt(uint64_t offset, size_t length, std::string &data);
+    // Continues where the previous Read() stopped.
+    bool Read(size_t maxBytes, std::string &data);
+
+private:
+    bool LoadChunk(uint32_t index);
+
+    LevelDB *_db;
+    std::string _key;
+    bool _exists;
+    StreamManifest _manifest;
+    uint64_t _position;
+    // The last chunk read, so small sequential reads cost one Get per chunk.
+    bool _hasChunk;
+    uint32_t _chunkIndex;
+    std::string _chunk;
+};
+
+#endif // LEVELDB_STREAM_H
@@ -0,0 +1,345 @@
+#include "TagIndex.h"
+#include "Coding.h"
+#include "Json.h"
+#include <algorithm>
+#include <cctype>
+
+static const std::string kTagDeltaPrefix = InternalKey("tgd:");
+
+enum TagSection : int64_t {
+    kTagSectionKeys = 0,
+    kTagSectionIds = 1,
+    kTagSectionUniverse = 2,
+    kTagSectionBitmaps = 3,
+};
+
+static std::string TagSectionPrefix(const std::string &name, TagSection section) {
+    KeyPart part;
+    part.type = kKeyPartInt64;
+    part.int64 = section;
+    std::string prefix = IndexEntryPrefix(name);
+    EncodeKeyPart(prefix, part);
+    return prefix;
+}
+
+static void AppendUInt64Part(std::string &dst, uint64_t value) {
+    KeyPart part;
+    part.type = kKeyPartUInt64;
+    part.uint64 = value;
+    EncodeKeyPart(dst, part);
+}
+
+static bool DecodeUInt64Part(const leveldb::Slice &entry, size_t prefixSize, uint64_t &value) {
+    if (entry.size() != prefixSize + 9 || static_cast<uint8_t>(entry[prefixSize]) != kKeyPartUInt64) {
+        return false;
+    }
+    value = DecodeFixed64BE(entry.data() + prefixSize + 1);
+    return true;
+}
+
+static void AddTag(const JsonValue &item, std::vector<std::string> &tags) {
+    if (item.type == JsonValue::kString || item.type == JsonValue::kNumber) {
+        tags.push_back(item.text);
+    }
+}
+
+void ExtractIndexTags(const IndexSpec &spec, const std::string &value, std::vector<std::string> &tags) {
+    tags.clear();
+    JsonValue root;
+    if (!ParseJson(value, root)) {
+        if (spec.field.empty()) {
+            tags.push_back(value);
+        }
+        return;
+    }
+    const JsonValue *json = root.FindPath(spec.field);
+    if (json == nullptr) {
+        return;
+    }
+    if (json->type == JsonValue::kArray) {
+        for (const auto& item : json->items) {
+            AddTag(item, tags);
+        }
+    } else if (json->type == JsonValue::kObject) {
+        for (const auto& member : json->members) {
+            if (member.second.type == JsonValue::kBool && member.second.boolean) {
+                tags.push_back(member.first);
+            }
+        }
+    } else {
+        AddTag(*json, tags);
+    }
+    std::sort(tags.begin(), tags.end());
+    tags.erase(std::unique(tags.begin(), tags.end()), tags.end());
+}
+
+std::string TagKeyIdKey(const std::string &name, const std::string &key) {
+    KeyPart part;
+    part.type = kKeyPartBytes;
+    part.bytes = key;
+    std::string entry = TagSectionPrefix(name, kTagSectionKeys);
+    EncodeKeyPart(entry, part);
+    return entry;
+}
+
+std::string TagIdPrefix(const std::string &name) {
+    return TagSectionPrefix(name, kTagSectionIds);
+}
+
+std::string TagIdKey(const std::string &name, uint32_t id) {
+    std::string entry = TagIdPrefix(name);
+    AppendUInt64Part(entry, id);
+    return entry;
+}
+
+bool DecodeTagIdKey(const leveldb::Slice &entry, size_t prefixSize, uint32_t &id) {
+    uint64_t value = 0;
+    if (!DecodeUInt64Part(entry, prefixSize, value) || value > UINT32_MAX) {
+        return false;
+    }
+    id = static_cast<uint32_t>(value);
+    return true;
+}
+
+std::string TagUniversePrefix(const std::string &name) {
+    return TagSectionPrefix(name, kTagSectionUniverse);
+}
+
+std::string TagBitmapPrefix(const std::string &name, const std::string &tag) {
+    KeyPart part;
+    part.type = kKeyPartString;
+    part.bytes = tag;
+    std::string prefix = TagSectionPrefix(name, kTagSectionBitmaps);
+    EncodeKeyPart(prefix, part);
+    return prefix;
+}
+
+std::string TagContainerKey(const std::string &prefix, uint16_t high) {
+    std::string entry = prefix;
+    AppendUInt64Part(entry, high);
+    return entry;
+}
+
+bool DecodeTagContainerKey(const leveldb::Slice &entry, size_t prefixSize, uint16_t &high) {
+    uint64_t value = 0;
+    if (!DecodeUInt64Part(entry, prefixSize, value) || value > UINT16_MAX) {
+        return false;
+    }
+    high = static_cast<uint16_t>(value);
+    return true;
+}
+
+//   key: tgd: | container key     value: add | fixed16BE low
+void PutTagDelta(std::string &key, std::string &value, const std::string &prefix, uint32_t id, bool add) {
+    key = kTagDeltaPrefix + TagContainerKey(prefix, static_cast<uint16_t>(id >> 16));
+    value.clear();
+    value.push_back(add ? 1 : 0);
+    value.push_back(static_cast<char>((id >> 8) & 0xff));
+    value.push_back(static_cast<char>(id & 0xff));
+}
+
+bool DecodeTagDelta(const leveldb::Slice &key, const leveldb::Slice &value, std::string &containerKey,
+                    uint16_t &low, bool &add) {
+    if (!key.starts_with(kTagDeltaPrefix) || value.size() != 3) {
+        return false;
+    }
+    containerKey.assign(key.data() + kTagDeltaPrefix.size(), key.size() - kTagDeltaPrefix.size());
+    add = value[0] != 0;
+    low = static_cast<uint16_t>((static_cast<uint8_t>(value[1]) << 8) | static_cast<uint8_t>(value[2]));
+    return true;
+}
+
+// Recursive descent over the tokens: or := and (OR and)*,
+// and := unary (AND unary)*, unary := NOT unary | ( or ) | tag.
+struct TagExpressionParser {
+    enum TokenKind { kTokenEnd, kTokenOpen, kTokenClose, kTokenWord, kTokenQuoted };
+
+    const std::string &text;
+    size_t position = 0;
+    TokenKind kind = kTokenEnd;
+    std::string token;
+    std::string error;
+
+    explicit TagExpressionParser(const std::string &input) : text(input) {}
+
+    bool IsKeyword(const char *keyword) const {
+        return kind == kTokenWord && token == keyword;
+    }
+
+    bool Next() {
+        while (position < text.size() && isspace(static_cast<unsigned char>(text[position]))) {
+            position++;
+        }
+        token.clear();
+        if (position == text.size()) {
+            kind = kTokenEnd;
+            return true;
+        }
+        char c = text[position];
+        if (c == '(' || c == ')') {
+            kind = c == '(' ? kTokenOpen : kTokenClose;
+            position++;
+            return true;
+        }
+        if (c == '"') {
+            kind = kTokenQuoted;
+            for (position++; position < text.size() && text[position] != '"'; position++) {
+                if (text[position] == '\\' && position + 1 < text.size()) {
+                    position++;
+                }
+                token.push_back(text[position]);
+            }
+            if (position == text.size()) {
+                error = "unterminated quoted tag";
+                return false;
+            }
+            position++;
+            return true;
+        }
+        kind = kTokenWord;
+        while (position < text.size() && !isspace(static_cast<unsigned char>(text[position])) &&
+               text[position] != '(' && text[position] != ')' && text[position] != '"') {
+            token.push_back(text[position++]);
+        }
+        return true;
+    }
+
+    bool ParseOr(TagExpression &expression) {
+        return ParseList(expression, TagExpression::kOr, "OR");
+    }
+
+    bool ParseList(TagExpression &expression, TagExpression::Kind listKind, const char *keyword) {
+        TagExpression operand;
+        if (!(listKind == TagExpression::kOr ? ParseList(operand, TagExpression::kAnd, "AND")
+                                             : ParseUnary(operand))) {
+            return false;
+        }
+        if (!IsKeyword(keyword)) {
+            expression = std::move(operand);
+            return true;
+        }
+        expression = TagExpression();
+        expression.kind = listKind;
+        expression.operands.push_back(std::move(operand));
+        while (IsKeyword(keyword)) {
+            if (!Next()) {
+                return false;
+            }
+            operand = TagExpression();
+            if (!(listKind == TagExpression::kOr ? ParseList(operand, TagExpression::kAnd, "AND")
+                                                 : ParseUnary(operand))) {
+                return false;
+            }
+            expression.operands.push_back(std::move(operand));
+        }
+        return true;
+    }
+
+    bool ParseUnary(TagExpression &expression) {
+        if (IsKeyword("NOT")) {
+            expression = TagExpression();
+            expression.kind = TagExpression::kNot;
+            expression.operands.emplace_back();
+            return Next() && ParseUnary(expression.operands[0]);
+        }
+        if (kind == kTokenOpen) {
+            if (!Next() || !ParseOr(expression)) {
+                return false;
+            }
+            if (kind != kTokenClose) {
+                error = "missing )";
+                return false;
+            }
+            return Next();
+        }
+        if (kind == kTokenQuoted || (kind == kTokenWord && !IsKeyword("AND") && !IsKeyword("OR"))) {
+            expression = TagExpression();
+            expression.tag = token;
+            return Next();
+        }
+        error = kind == kTokenEnd ? "expression ends early" : "unexpected " + (kind == kTokenClose ? ")" : token);
+        return false;
+    }
+};
+
+bool ParseTagExpression(const std::string &text, TagExpression &expression, std::string &error) {
+    TagExpressionParser parser(text);
+    if (parser.Next() && parser.ParseOr(expression)) {
+        if (parser.kind == TagExpressionParser::kTokenEnd) {
+            return true;
+        }
+        parser.error = "unexpected " + (parser.kind == TagExpressionParser::kTokenClose ? ")" : parser.token);
+    }
+    error = parser.error;
+    return false;
+}
+
+struct TagEvaluator {
+    const std::function<RoaringBitmap(const std::string *tag)> &load;
+    bool universeLoaded = false;
+    RoaringBitmap universe;
+
+    explicit TagEvaluator(const std::function<RoaringBitmap(const std::string *tag)> &loader) : load(loader) {}
+
+    const RoaringBitmap &Universe() {
+        if (!universeLoaded) {
+            universe = load(nullptr);
+            universeLoaded = true;
+        }
+        return universe;
+    }
+
+    RoaringBitmap Evaluate(const TagExpression &expression) {
+        switch (expression.kind) {
+            case TagExpression::kTag:
+                return load(&expression.tag);
+            case TagExpression::kNot:
+                return Universe().AndNot(Evaluate(expression.operands[0]));
+            case TagExpression::kOr: {
+                RoaringBitmap result;
+                for (const auto& operand : expression.operands) {
+                    result = result.Or(Evaluate(operand));
+                }
+                return result;
+            }
+            case TagExpression::kAnd:
+                break;
+        }
+        // Intersect the positive operands smallest first, then subtract the
+        // negated ones, so "a AND NOT b" never materializes NOT b.
+        std::vector<RoaringBitmap> positive;
+        std::vector<const TagExpression *> negated;
+        for (const auto& operand : expression.operands) {
+            if (operand.kind == TagExpression::kNot) {
+                negated.push_back(&operand.operands[0]);
+            } else {
+                positive.push_back(Evaluate(operand));
+            }
+        }
+        RoaringBitmap result;
+        if (positive.empty()) {
+            result = Universe();
+        } else {
+            std::sort(positive.begin(), positive.end(), [](const RoaringBitmap &a, const RoaringBitmap &b) {
+                return a.Cardinality() < b.Cardinality();
+            });
+            result = std::move(positive[0]);
+            for (size_t i = 1; i < positive.size() && !result.Empty(); i++) {
+                result = result.And(positive[i]);
+            }
+        }
+        for (const TagExpression *operand : negated) {
+            if (result.Empty()) {
+                break;
+            }
+            result = result.AndNot(Evaluate(*operand));
+        }
+        return result;
+    }
+};
+
+RoaringBitmap EvaluateTagExpression(const TagExpression &expression,
+                                    const std::function<RoaringBitmap(const std::string *tag)> &load) {
+    TagEvaluator evaluator(load);
+    return evaluator.Evaluate(expression);
+}
@@ -0,0 +1,60 @@
+//
+// Created on 2026/10/19.
+//
+// Tag indexes are secondary indexes of type kIndexValueTags. Every key under
+// the index's key prefix gets a dense 32-bit id, and every tag a roaring
+// bitmap of the ids whose value carries it. All of it lives under
+// IndexEntryPrefix(name), one roaring container per entry:
+//   | int64 0 | bytes key                   -> fixed32BE id
+//   | int64 1 | uint64 id                   -> key
+//   | int64 2 | uint64 high                 -> container of every id (for NOT)
+//   | int64 3 | string tag | uint64 high    -> container of the tag's ids
+// Writers stage per-id deltas in their batch instead of containers, and
+// Commit() folds them into the stored containers, so any number of keys can
+// change in one batch.
+
+#ifndef LEVELDB_TAGINDEX_H
+#define LEVELDB_TAGINDEX_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "Roaring.h"
+#include "SecondaryIndex.h"
+
+// Strings and numbers of a JSON array, a single string or number, or the
+// members set to true of an object; sorted and without duplicates. A value
+// that is not JSON is one tag when the index has no field.
+void ExtractIndexTags(const IndexSpec &spec, const std::string &value, std::vector<std::string> &tags);
+
+std::string TagKeyIdKey(const std::string &name, const std::string &key);
+std::string TagIdPrefix(const std::string &name);
+std::string TagIdKey(const std::string &name, uint32_t id);
+bool DecodeTagIdKey(const leveldb::Slice &entry, size_t prefixSize, uint32_t &id);
+// Prefixes of the containers of all ids, and of one tag's ids.
+std::string TagUniversePrefix(const std::string &name);
+std::string TagBitmapPrefix(const std::string &name, const std::string &tag);
+std::string TagContainerKey(const std::string &prefix, uint16_t high);
+bool DecodeTagContainerKey(const leveldb::Slice &entry, size_t prefixSize, uint16_t &high);
+
+// A staged change of one id in one container; never written to the database.
+void PutTagDelta(std::string &key, std::string &value, const std::string &prefix, uint32_t id, bool add);
+bool DecodeTagDelta(const leveldb::Slice &key, const leveldb::Slice &value, std::string &containerKey,
+                    uint16_t &low, bool &add);
+
+// Tags combined with AND, OR, NOT and parentheses; NOT binds tightest, then
+// AND. A tag is a bare word or a double-quoted string with \ escapes.
+struct TagExpression {
+    enum Kind { kTag, kAnd, kOr, kNot };
+
+    Kind kind = kTag;
+    std::string tag;
+    std::vector<TagExpression> operands;
+};
+
+bool ParseTagExpression(const std::string &text, TagExpression &expression, std::string &error);
+// load(nullptr) returns the bitmap of every id, load(&tag) that of a tag.
+RoaringBitmap EvaluateTagExpression(const TagExpression &expression,
+                                    const std::function<RoaringBitmap(const std::string *tag)> &load);
+
+#endif // LEVELDB_TAGINDEX_H
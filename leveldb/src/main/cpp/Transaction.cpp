@@ -0,0 +1,87 @@
+#include "Transaction.h"
+
+bool Transaction::Get(const std::string &key, std::string &value) {
+    auto write = _writes.find(key);
+    if (write != _writes.end()) {
+        value = write->second.value;
+        return !write->second.remove;
+    }
+
+    // Retry until no write landed in between, so the recorded version is the
+    // one the value was read at.
+    uint64_t version;
+    bool exists;
+    do {
+        version = _db->KeyVersion(key);
+        ValueHeader header;
+        exists = _db->ReadValue(key, value, header);
+    } while (_db->KeyVersion(key) != version);
+    _readVersions.emplace(key, version);
+    return exists;
+}
+
+void Transaction::Put(const std::string &key, const std::string &value) {
+    PendingWrite &write = _writes[key];
+    write.remove = false;
+    write.value = value;
+}
+
+void Transaction::Remove(const std::string &key) {
+    PendingWrite &write = _writes[key];
+    write.remove = true;
+    write.value.clear();
+}
+
+bool Transaction::Commit() {
+    std::vector<std::string> keys;
+    std::vector<std::string> removed;
+    for (const auto& read : _readVersions) {
+        keys.push_back(read.first);
+    }
+    for (const auto& write : _writes) {
+        keys.push_back(write.first);
+    }
+
+    bool committed = false;
+    {
+        LevelDB::KeyLockGuard lock(*_db, keys);
+        bool valid = true;
+        for (const auto& read : _readVersions) {
+            if (_db->KeyVersion(read.first) != read.second) {
+                valid = false;
+                break;
+            }
+        }
+        if (valid) {
+            leveldb::WriteBatch batch;
+            std::unique_lock<std::recursive_mutex> dedupLock(_db->_dedupMutex, std::defer_lock);
+            for (const auto& write : _writes) {
+                _db->StageIndexChange(batch, write.first, write.second.remove ? nullptr : &write.second.value);
+                if (write.second.remove) {
+                    batch.Delete(write.first);
+                    removed.push_back(write.first);
+                } else if (!_db->StageUserValue(batch, write.first, write.second.value, ValueHeader(), dedupLock)) {
+                    valid = false;
+                    break;
+                }
+                _db->StageDropMerges(batch, write.first);
+            }
+            committed = valid && (_writes.empty() || _db->Commit(batch));
+            if (committed) {
+                for (const auto& write : _writes) {
+                    _db->ForgetMerges(write.first);
+                }
+            }
+        }
+    }
+    if (committed) {
+        _db->RecordTombstones(removed);
+    }
+    Rollback();
+    return committed;
+}
+
+void Transaction::Rollback() {
+    _readVersions.clear();
+    _writes.clear();
+}
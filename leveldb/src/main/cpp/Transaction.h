@@ -0,0 +1,40 @@
+//
+// Created on 2026/10/19.
+//
+// Optimistic multi-key transaction: reads record the version stamp of each
+// key, writes are buffered, and Commit() applies them as one WriteBatch only
+// if none of the keys read has been written since.
+
+#ifndef LEVELDB_TRANSACTION_H
+#define LEVELDB_TRANSACTION_H
+
+#include <map>
+#include <string>
+#include "LevelDB.h"
+
+class Transaction {
+public:
+    explicit Transaction(LevelDB *db) : _db(db) {}
+
+    // Sees the transaction's own buffered writes first. Never takes a lock.
+    bool Get(const std::string &key, std::string &value);
+    void Put(const std::string &key, const std::string &value);
+    void Remove(const std::string &key);
+
+    // Returns false on a conflict; the transaction can then be retried from
+    // scratch. Buffered state is cleared either way.
+    bool Commit();
+    void Rollback();
+
+private:
+    struct PendingWrite {
+        bool remove = false;
+        std::string value;
+    };
+
+    LevelDB *_db;
+    std::map<std::string, uint64_t> _readVersions;
+    std::map<std::string, PendingWrite> _writes;
+};
+
+#endif // LEVELDB_TRANSACTION_H
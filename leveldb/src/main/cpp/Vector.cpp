@@ -0,0 +1,81 @@
+#include "Vector.h"
+#include "Coding.h"
+#include "VectorKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const std::string kVectorPrefix = InternalKey("vec:");
+static const std::string kQuantizedVectorPrefix = InternalKey("vecq:");
+
+static void PutFloat(std::string &dst, float value) {
+    dst.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+static float LoadFloat(const char *ptr) {
+    float value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+std::string VectorPrefix() {
+    return kVectorPrefix;
+}
+
+std::string VectorKey(const std::string &key) {
+    return kVectorPrefix + key;
+}
+
+std::string QuantizedVectorPrefix() {
+    return kQuantizedVectorPrefix;
+}
+
+std::string QuantizedVectorKey(const std::string &key) {
+    return kQuantizedVectorPrefix + key;
+}
+
+std::string EncodeVector(const float *values, size_t dimension) {
+    std::string value;
+    value.reserve(sizeof(float) * (dimension + 1));
+    PutFloat(value, std::sqrt(GetVectorKernels().dot(values, values, dimension)));
+    value.append(reinterpret_cast<const char *>(values), sizeof(float) * dimension);
+    return value;
+}
+
+std::string EncodeQuantizedVector(const float *values, size_t dimension) {
+    float largest = 0;
+    for (size_t i = 0; i < dimension; i++) {
+        largest = std::max(largest, std::fabs(values[i]));
+    }
+    float scale = largest > 0 ? largest / 127 : 1;
+    std::string value;
+    value.reserve(sizeof(float) * 2 + dimension);
+    PutFloat(value, scale);
+    PutFloat(value, std::sqrt(GetVectorKernels().dot(values, values, dimension)));
+    for (size_t i = 0; i < dimension; i++) {
+        value.push_back(static_cast<char>(static_cast<int8_t>(std::lround(values[i] / scale))));
+    }
+    return value;
+}
+
+bool DecodeVector(const leveldb::Slice &value, float &norm, std::vector<float> &values) {
+    if (value.size() < sizeof(float) * 2 || value.size() % sizeof(float) != 0) {
+        return false;
+    }
+    norm = LoadFloat(value.data());
+    values.resize(value.size() / sizeof(float) - 1);
+    memcpy(values.data(), value.data() + sizeof(float), value.size() - sizeof(float));
+    return true;
+}
+
+bool DecodeQuantizedVector(const leveldb::Slice &value, float &scale, float &norm, const int8_t *&values,
+                           size_t &dimension) {
+    if (value.size() <= sizeof(float) * 2) {
+        return false;
+    }
+    scale = LoadFloat(value.data());
+    norm = LoadFloat(value.data() + sizeof(float));
+    values = reinterpret_cast<const int8_t *>(value.data() + sizeof(float) * 2);
+    dimension = value.size() - sizeof(float) * 2;
+    return true;
+}
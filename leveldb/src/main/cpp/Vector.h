@@ -0,0 +1,59 @@
+//
+// Created on 2026/10/19.
+//
+// Embeddings stored next to the key space, searched by brute force:
+//   vec:  | key -> float norm | float values[dim]
+//   vecq: | key -> float scale | float norm | int8 values[dim]   (optional)
+// Floats are kept in host byte order (little-endian on every target). The
+// int8 copy is a symmetric per-vector quantization (value = scale * q); a
+// quantized search ranks by it and rescores the best candidates with the
+// float vectors.
+
+#ifndef LEVELDB_VECTOR_H
+#define LEVELDB_VECTOR_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <leveldb/slice.h>
+
+enum VectorMetric : uint8_t {
+    kVectorDot = 0,
+    kVectorCosine = 1,
+    kVectorL2 = 2,
+};
+
+struct VectorSearchOptions {
+    // Only vectors whose key starts with prefix.
+    std::string prefix;
+    size_t k = 10;
+    VectorMetric metric = kVectorCosine;
+    // Scans the int8 copies; vectors stored without one are not found.
+    bool quantized = false;
+    // Partitions scanned in parallel; 0 picks one per core (at most 8).
+    size_t threads = 0;
+};
+
+// Dot products and cosine similarities rank higher first, L2 distances
+// lower first.
+struct VectorMatch {
+    std::string key;
+    float score = 0;
+};
+
+const size_t kMaxVectorDimension = 65536;
+
+std::string VectorPrefix();
+std::string VectorKey(const std::string &key);
+std::string QuantizedVectorPrefix();
+std::string QuantizedVectorKey(const std::string &key);
+
+std::string EncodeVector(const float *values, size_t dimension);
+std::string EncodeQuantizedVector(const float *values, size_t dimension);
+// Copies the values out of an encoded vector; false if it is malformed.
+bool DecodeVector(const leveldb::Slice &value, float &norm, std::vector<float> &values);
+// Points into the encoded value; nothing is copied.
+bool DecodeQuantizedVector(const leveldb::Slice &value, float &scale, float &norm, const int8_t *&values,
+                           size_t &dimension);
+
+#endif // LEVELDB_VECTOR_H
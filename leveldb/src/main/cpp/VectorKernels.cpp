@@ -0,0 +1,225 @@
+#include "VectorKernels.h"
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define LEVELDB_VECTOR_NEON 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LEVELDB_VECTOR_X86 1
+#endif
+
+static float DotScalar(const float *a, const float *b, size_t n) {
+    float sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+static float SquaredL2Scalar(const float *a, const float *b, size_t n) {
+    float sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        float d = a[i] - b[i];
+        sum += d * d;
+    }
+    return sum;
+}
+
+static int32_t DotInt8Scalar(const int8_t *a, const int8_t *b, size_t n) {
+    int32_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += static_cast<int32_t>(a[i]) * b[i];
+    }
+    return sum;
+}
+
+#if defined(LEVELDB_VECTOR_NEON)
+static inline float32x4_t MultiplyAdd(float32x4_t sum, float32x4_t a, float32x4_t b) {
+#if defined(__aarch64__)
+    return vfmaq_f32(sum, a, b);
+#else
+    return vmlaq_f32(sum, a, b);
+#endif
+}
+
+static inline float AddAcross(float32x4_t v) {
+#if defined(__aarch64__)
+    return vaddvq_f32(v);
+#else
+    float32x2_t pair = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+}
+
+static float DotNeon(const float *a, const float *b, size_t n) {
+    // Two accumulators hide the latency of the multiply-add chain.
+    float32x4_t sum0 = vdupq_n_f32(0);
+    float32x4_t sum1 = vdupq_n_f32(0);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        sum0 = MultiplyAdd(sum0, vld1q_f32(a + i), vld1q_f32(b + i));
+        sum1 = MultiplyAdd(sum1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    for (; i + 4 <= n; i += 4) {
+        sum0 = MultiplyAdd(sum0, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    return AddAcross(vaddq_f32(sum0, sum1)) + DotScalar(a + i, b + i, n - i);
+}
+
+static float SquaredL2Neon(const float *a, const float *b, size_t n) {
+    float32x4_t sum0 = vdupq_n_f32(0);
+    float32x4_t sum1 = vdupq_n_f32(0);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        float32x4_t d0 = vsubq_f32(vld1q_f32(a + i), vld1q_f32(b + i));
+        float32x4_t d1 = vsubq_f32(vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+        sum0 = MultiplyAdd(sum0, d0, d0);
+        sum1 = MultiplyAdd(sum1, d1, d1);
+    }
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t d = vsubq_f32(vld1q_f32(a + i), vld1q_f32(b + i));
+        sum0 = MultiplyAdd(sum0, d, d);
+    }
+    return AddAcross(vaddq_f32(sum0, sum1)) + SquaredL2Scalar(a + i, b + i, n - i);
+}
+
+static int32_t DotInt8Neon(const int8_t *a, const int8_t *b, size_t n) {
+    int32x4_t sum = vdupq_n_s32(0);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        int8x16_t x = vld1q_s8(a + i);
+        int8x16_t y = vld1q_s8(b + i);
+        sum = vpadalq_s16(sum, vmull_s8(vget_low_s8(x), vget_low_s8(y)));
+        sum = vpadalq_s16(sum, vmull_s8(vget_high_s8(x), vget_high_s8(y)));
+    }
+    int32_t lanes[4];
+    vst1q_s32(lanes, sum);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + DotInt8Scalar(a + i, b + i, n - i);
+}
+#endif
+
+#if defined(LEVELDB_VECTOR_X86)
+__attribute__((target("sse2"))) static inline float AddAcross(__m128 v) {
+    __m128 high = _mm_movehl_ps(v, v);
+    __m128 pair = _mm_add_ps(v, high);
+    return _mm_cvtss_f32(_mm_add_ss(pair, _mm_shuffle_ps(pair, pair, 1)));
+}
+
+__attribute__((target("sse2"))) static float DotSse(const float *a, const float *b, size_t n) {
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    return AddAcross(_mm_add_ps(sum0, sum1)) + DotScalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("sse2"))) static float SquaredL2Sse(const float *a, const float *b, size_t n) {
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128 d0 = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        __m128 d1 = _mm_sub_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4));
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(d0, d0));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(d1, d1));
+    }
+    return AddAcross(_mm_add_ps(sum0, sum1)) + SquaredL2Scalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("sse2"))) static int32_t DotInt8Sse(const int8_t *a, const int8_t *b, size_t n) {
+    __m128i sum = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        // Sign extension to 16 bits: the byte goes to the high half, then
+        // an arithmetic shift brings it back down.
+        __m128i xl = _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8);
+        __m128i xh = _mm_srai_epi16(_mm_unpackhi_epi8(x, x), 8);
+        __m128i yl = _mm_srai_epi16(_mm_unpacklo_epi8(y, y), 8);
+        __m128i yh = _mm_srai_epi16(_mm_unpackhi_epi8(y, y), 8);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(xl, yl));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(xh, yh));
+    }
+    int32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), sum);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + DotInt8Scalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2,fma"))) static inline float AddAcross256(__m256 v) {
+    return AddAcross(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+}
+
+__attribute__((target("avx2,fma"))) static float DotAvx2(const float *a, const float *b, size_t n) {
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum0);
+        sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), sum1);
+    }
+    for (; i + 8 <= n; i += 8) {
+        sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum0);
+    }
+    return AddAcross256(_mm256_add_ps(sum0, sum1)) + DotScalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2,fma"))) static float SquaredL2Avx2(const float *a, const float *b, size_t n) {
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+        __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+        sum0 = _mm256_fmadd_ps(d0, d0, sum0);
+        sum1 = _mm256_fmadd_ps(d1, d1, sum1);
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m256 d = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+        sum0 = _mm256_fmadd_ps(d, d, sum0);
+    }
+    return AddAcross256(_mm256_add_ps(sum0, sum1)) + SquaredL2Scalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2,fma"))) static int32_t DotInt8Avx2(const int8_t *a, const int8_t *b, size_t n) {
+    __m256i sum = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i x = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)));
+        __m256i y = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(x, y));
+    }
+    int32_t lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), sum);
+    int32_t total = 0;
+    for (int32_t lane : lanes) {
+        total += lane;
+    }
+    return total + DotInt8Scalar(a + i, b + i, n - i);
+}
+#endif
+
+static VectorKernels SelectKernels() {
+#if defined(LEVELDB_VECTOR_NEON)
+    return { "neon", DotNeon, SquaredL2Neon, DotInt8Neon };
+#elif defined(LEVELDB_VECTOR_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return { "avx2", DotAvx2, SquaredL2Avx2, DotInt8Avx2 };
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return { "sse2", DotSse, SquaredL2Sse, DotInt8Sse };
+    }
+    return { "scalar", DotScalar, SquaredL2Scalar, DotInt8Scalar };
+#else
+    return { "scalar", DotScalar, SquaredL2Scalar, DotInt8Scalar };
+#endif
+}
+
+const VectorKernels &GetVectorKernels() {
+    static const VectorKernels kernels = SelectKernels();
+    return kernels;
+}
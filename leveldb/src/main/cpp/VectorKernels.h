@@ -0,0 +1,23 @@
+//
+// Created on 2026/10/19.
+//
+// Distance kernels for vector search. The implementation is picked once at
+// runtime: NEON on ARM, AVX2+FMA on x86 CPUs that have it and SSE2
+// otherwise, with a portable fallback. Inputs need no particular alignment.
+
+#ifndef LEVELDB_VECTORKERNELS_H
+#define LEVELDB_VECTORKERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct VectorKernels {
+    const char *name;
+    float (*dot)(const float *a, const float *b, size_t n);
+    float (*squaredL2)(const float *a, const float *b, size_t n);
+    int32_t (*dotInt8)(const int8_t *a, const int8_t *b, size_t n);
+};
+
+const VectorKernels &GetVectorKernels();
+
+#endif // LEVELDB_VECTORKERNELS_H
@@ -1,6 +1,14 @@
 #include "napi/native_api.h"
 #include "LevelDB.h"
+#include "KeyCodec.h"
+#include "ObjectCodec.h"
+#include "Stream.h"
+#include "Transaction.h"
 #include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
 
 // assuming env is defined
 #define NAPI_CALL_RET(call, return_value)                                                                              \
@@ -106,7 +114,7 @@ static napi_value DoubleToNValue(napi_env env, double value) {
 }
 
 static double NValueToDouble(napi_env env, napi_value value) {
-    double result;
+    double result = NAN;
     napi_get_value_double(env, value, &result);
     return result;
 }
@@ -140,49 +148,615 @@ static uint64_t NValueToUInt64(napi_env env, napi_value value, bool maybeUndefin
     return result;
 }
 
-static std::vector<std::string> NValueToStringArray(napi_env env, napi_value value, bool maybeUndefined = false) {
-    std::vector<std::string> keys;
-    if (maybeUndefined && IsNValueUndefined(env, value)) {
-        return keys;
+static bool IsNValueFunction(napi_env env, napi_value value) {
+    napi_valuetype type;
+    return napi_typeof(env, value, &type) == napi_ok && type == napi_function;
+}
+
+static napi_value NAPIObject(napi_env env) {
+    napi_value result;
+    napi_create_object(env, &result);
+    return result;
+}
+
+static void SetNamedProperty(napi_env env, napi_value object, const char *name, napi_value value) {
+    napi_set_named_property(env, object, name, value);
+}
+
+static napi_value GetNamedProperty(napi_env env, napi_value object, const char *name) {
+    napi_value result = nullptr;
+    bool hasProperty = false;
+    if (napi_has_named_property(env, object, name, &hasProperty) != napi_ok || !hasProperty) {
+        return NAPIUndefined(env);
+    }
+    napi_get_named_property(env, object, name, &result);
+    return result;
+}
+
+// Uint8Array or ArrayBuffer contents; false for any other value.
+static bool NValueToBytes(napi_env env, napi_value value, std::string &bytes) {
+    bool isTypedArray = false;
+    napi_is_typedarray(env, value, &isTypedArray);
+    if (isTypedArray) {
+        napi_typedarray_type type;
+        size_t length = 0;
+        void *data = nullptr;
+        napi_get_typedarray_info(env, value, &type, &length, &data, nullptr, nullptr);
+        if (type != napi_uint8_array && type != napi_uint8_clamped_array && type != napi_int8_array) {
+            return false;
+        }
+        bytes.assign(static_cast<const char *>(data), length);
+        return true;
+    }
+    bool isArrayBuffer = false;
+    napi_is_arraybuffer(env, value, &isArrayBuffer);
+    if (isArrayBuffer) {
+        size_t length = 0;
+        void *data = nullptr;
+        napi_get_arraybuffer_info(env, value, &data, &length);
+        bytes.assign(static_cast<const char *>(data), length);
+        return true;
+    }
+    return false;
+}
+
+static napi_value BytesToNValue(napi_env env, const std::string &bytes) {
+    void *data = nullptr;
+    napi_value buffer = nullptr;
+    napi_value result = nullptr;
+    napi_create_arraybuffer(env, bytes.size(), &data, &buffer);
+    if (!bytes.empty()) {
+        memcpy(data, bytes.data(), bytes.size());
     }
+    napi_create_typedarray(env, napi_uint8_array, bytes.size(), buffer, 0, &result);
+    return result;
+}
 
+// Float32Array, or an array of numbers.
+static bool NValueToFloats(napi_env env, napi_value value, std::vector<float> &floats) {
+    bool isTypedArray = false;
+    napi_is_typedarray(env, value, &isTypedArray);
+    if (isTypedArray) {
+        napi_typedarray_type type;
+        size_t length = 0;
+        void *data = nullptr;
+        napi_get_typedarray_info(env, value, &type, &length, &data, nullptr, nullptr);
+        if (type != napi_float32_array) {
+            return false;
+        }
+        floats.resize(length);
+        if (length > 0) {
+            memcpy(floats.data(), data, length * sizeof(float));
+        }
+        return true;
+    }
+    bool isArray = false;
+    napi_is_array(env, value, &isArray);
+    if (!isArray) {
+        return false;
+    }
     uint32_t length = 0;
-    if (napi_get_array_length(env, value, &length) != napi_ok || length == 0) {
-        return keys;
+    napi_get_array_length(env, value, &length);
+    floats.resize(length);
+    for (uint32_t index = 0; index < length; index++) {
+        napi_value jsNumber = nullptr;
+        napi_get_element(env, value, index, &jsNumber);
+        floats[index] = static_cast<float>(NValueToDouble(env, jsNumber));
     }
-    keys.reserve(length);
+    return true;
+}
+
+static napi_value FloatsToNValue(napi_env env, const std::vector<float> &floats) {
+    void *data = nullptr;
+    napi_value buffer = nullptr;
+    napi_value result = nullptr;
+    napi_create_arraybuffer(env, floats.size() * sizeof(float), &data, &buffer);
+    if (!floats.empty()) {
+        memcpy(data, floats.data(), floats.size() * sizeof(float));
+    }
+    napi_create_typedarray(env, napi_float32_array, floats.size(), buffer, 0, &result);
+    return result;
+}
+
+// string -> string, number -> double, bigint -> int64, Uint8Array/ArrayBuffer
+// -> bytes and { uint64: bigint } -> uint64.
+static bool NValueToKeyPart(napi_env env, napi_value value, KeyPart &part) {
+    napi_valuetype type;
+    napi_typeof(env, value, &type);
+    if (type == napi_string) {
+        part.type = kKeyPartString;
+        part.bytes = NValueToString(env, value);
+        return true;
+    }
+    if (type == napi_number) {
+        part.type = kKeyPartDouble;
+        part.number = NValueToDouble(env, value);
+        return true;
+    }
+    if (type == napi_bigint) {
+        bool lossless = false;
+        part.type = kKeyPartInt64;
+        napi_get_value_bigint_int64(env, value, &part.int64, &lossless);
+        if (!lossless) {
+            napi_throw_range_error(env, nullptr, "bigint key part out of int64 range, use { uint64 }");
+            return false;
+        }
+        return true;
+    }
+    if (type == napi_object) {
+        if (NValueToBytes(env, value, part.bytes)) {
+            part.type = kKeyPartBytes;
+            return true;
+        }
+        napi_value jsUInt64 = GetNamedProperty(env, value, "uint64");
+        if (!IsNValueUndefined(env, jsUInt64)) {
+            part.type = kKeyPartUInt64;
+            part.uint64 = NValueToUInt64(env, jsUInt64);
+            return true;
+        }
+    }
+    napi_throw_type_error(env, nullptr, "unsupported key part");
+    return false;
+}
+
+static napi_value KeyPartToNValue(napi_env env, const KeyPart &part) {
+    switch (part.type) {
+        case kKeyPartBytes:
+            return BytesToNValue(env, part.bytes);
+        case kKeyPartString:
+            return StringToNValue(env, part.bytes);
+        case kKeyPartInt64:
+            return Int64ToNValue(env, part.int64);
+        case kKeyPartUInt64: {
+            napi_value result = NAPIObject(env);
+            SetNamedProperty(env, result, "uint64", UInt64ToNValue(env, part.uint64));
+            return result;
+        }
+        case kKeyPartDouble:
+            return DoubleToNValue(env, part.number);
+    }
+    return NAPIUndefined(env);
+}
+
+static napi_value KeyTupleToNValue(napi_env env, const std::vector<KeyPart> &parts) {
+    napi_value result = nullptr;
+    napi_create_array_with_length(env, parts.size(), &result);
+    for (size_t index = 0; index < parts.size(); index++) {
+        napi_set_element(env, result, index, KeyPartToNValue(env, parts[index]));
+    }
+    return result;
+}
+
+static bool NValueToKeyTuple(napi_env env, napi_value value, std::string &key) {
+    uint32_t length = 0;
+    napi_get_array_length(env, value, &length);
+    key.clear();
+    for (uint32_t index = 0; index < length; index++) {
+        napi_value jsPart = nullptr;
+        KeyPart part;
+        napi_get_element(env, value, index, &jsPart);
+        if (!NValueToKeyPart(env, jsPart, part)) {
+            return false;
+        }
+        EncodeKeyPart(key, part);
+    }
+    return true;
+}
+
+// Keys are strings, raw bytes or tuples (encoded with KeyCodec). Throws and
+// returns false for malformed keys and keys in the reserved 0xff 0xff range.
+static bool NValueToKey(napi_env env, napi_value value, std::string &key) {
+    bool isArray = false;
+    napi_is_array(env, value, &isArray);
+    if (isArray) {
+        if (!NValueToKeyTuple(env, value, key)) {
+            return false;
+        }
+    } else if (!NValueToBytes(env, value, key)) {
+        key = NValueToString(env, value);
+    }
+    if (IsReservedKey(key)) {
+        napi_throw_range_error(env, nullptr, "keys starting with 0xff 0xff are reserved");
+        return false;
+    }
+    return true;
+}
+
+// Reads one side of a scan range from options[inclusiveName] or
+// options[exclusiveName]; the inclusive form wins if both are given.
+static bool NValueToScanBound(napi_env env, napi_value options, const char *inclusiveName, const char *exclusiveName,
+                              bool &hasBound, bool &inclusive, std::string &bound) {
+    napi_value jsBound = GetNamedProperty(env, options, inclusiveName);
+    inclusive = true;
+    if (IsNValueUndefined(env, jsBound)) {
+        jsBound = GetNamedProperty(env, options, exclusiveName);
+        inclusive = false;
+    }
+    if (IsNValueUndefined(env, jsBound)) {
+        return true;
+    }
+    hasBound = true;
+    return NValueToKey(env, jsBound, bound);
+}
+
+static const int kMaxObjectDepth = 64;
+static const double kMaxSafeInteger = 9007199254740991.0;
+
+// Follows JSON.stringify(): undefined and function members are left out (null
+// inside arrays) and non-finite numbers become null. Bigints are kept exactly.
+// Throws and returns false for values nested too deeply or bigints beyond int64.
+static bool NValueToJsonValue(napi_env env, napi_value value, JsonValue &json, int depth = 0) {
+    if (depth > kMaxObjectDepth) {
+        napi_throw_range_error(env, nullptr, "object nested too deeply");
+        return false;
+    }
+    json = JsonValue();
+    napi_valuetype type;
+    napi_typeof(env, value, &type);
+    switch (type) {
+        case napi_boolean:
+            json.type = JsonValue::kBool;
+            json.boolean = NValueToBool(env, value);
+            return true;
+        case napi_number:
+            json.number = NValueToDouble(env, value);
+            json.type = std::isfinite(json.number) ? JsonValue::kNumber : JsonValue::kNull;
+            return true;
+        case napi_bigint: {
+            int64_t integer = 0;
+            bool lossless = false;
+            napi_get_value_bigint_int64(env, value, &integer, &lossless);
+            if (!lossless) {
+                napi_throw_range_error(env, nullptr, "bigint out of int64 range");
+                return false;
+            }
+            json.type = JsonValue::kNumber;
+            json.number = static_cast<double>(integer);
+            json.text = std::to_string(integer);
+            return true;
+        }
+        case napi_string:
+            json.type = JsonValue::kString;
+            json.text = NValueToString(env, value);
+            return true;
+        case napi_object:
+            break;
+        default:
+            return true;
+    }
+
+    bool isArray = false;
+    napi_is_array(env, value, &isArray);
+    if (isArray) {
+        uint32_t length = 0;
+        napi_get_array_length(env, value, &length);
+        json.type = JsonValue::kArray;
+        json.items.resize(length);
+        for (uint32_t index = 0; index < length; index++) {
+            napi_value jsItem = nullptr;
+            napi_get_element(env, value, index, &jsItem);
+            if (!NValueToJsonValue(env, jsItem, json.items[index], depth + 1)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    napi_value jsNames = nullptr;
+    uint32_t length = 0;
+    json.type = JsonValue::kObject;
+    napi_get_property_names(env, value, &jsNames);
+    napi_get_array_length(env, jsNames, &length);
+    json.members.reserve(length);
+    for (uint32_t index = 0; index < length; index++) {
+        napi_value jsName = nullptr;
+        napi_value jsMember = nullptr;
+        napi_valuetype memberType;
+        napi_get_element(env, jsNames, index, &jsName);
+        napi_get_property(env, value, jsName, &jsMember);
+        napi_typeof(env, jsMember, &memberType);
+        if (memberType == napi_undefined || memberType == napi_function || memberType == napi_symbol) {
+            continue;
+        }
+        json.members.emplace_back(NValueToString(env, jsName), JsonValue());
+        if (!NValueToJsonValue(env, jsMember, json.members.back().second, depth + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Integers beyond 2^53 come back as bigints.
+static napi_value JsonValueToNValue(napi_env env, const JsonValue &json) {
+    switch (json.type) {
+        case JsonValue::kNull:
+            return NAPINull(env);
+        case JsonValue::kBool:
+            return BoolToNValue(env, json.boolean);
+        case JsonValue::kNumber:
+            if (std::fabs(json.number) > kMaxSafeInteger && !json.text.empty() &&
+                json.text.find_first_of(".eE") == std::string::npos) {
+                return Int64ToNValue(env, strtoll(json.text.c_str(), nullptr, 10));
+            }
+            return DoubleToNValue(env, json.number);
+        case JsonValue::kString:
+            return StringToNValue(env, json.text);
+        case JsonValue::kArray: {
+            napi_value result = nullptr;
+            napi_create_array_with_length(env, json.items.size(), &result);
+            for (size_t index = 0; index < json.items.size(); index++) {
+                napi_set_element(env, result, index, JsonValueToNValue(env, json.items[index]));
+            }
+            return result;
+        }
+        case JsonValue::kObject: {
+            napi_value result = NAPIObject(env);
+            for (const auto& member : json.members) {
+                napi_set_property(env, result, StringToNValue(env, member.first), JsonValueToNValue(env, member.second));
+            }
+            return result;
+        }
+    }
+    return NAPIUndefined(env);
+}
+
+static const char *const kWhereOpNames[] = { "eq", "gt", "gte", "lt", "lte", "exists" };
+
+// where: [{ field, eq?, gt?, gte?, lt?, lte?, exists? }, ...]; every operator
+// given becomes one predicate. Operands must be scalars.
+static bool NValueToWhere(napi_env env, napi_value value, std::vector<WherePredicate> &where) {
+    uint32_t length = 0;
+    napi_get_array_length(env, value, &length);
+    for (uint32_t index = 0; index < length; index++) {
+        napi_value jsPredicate = nullptr;
+        napi_get_element(env, value, index, &jsPredicate);
+        std::string field = NValueToString(env, GetNamedProperty(env, jsPredicate, "field"), true);
+        for (uint8_t op = kWhereEq; op <= kWhereExists; op++) {
+            napi_value jsOperand = GetNamedProperty(env, jsPredicate, kWhereOpNames[op]);
+            if (IsNValueUndefined(env, jsOperand)) {
+                continue;
+            }
+            WherePredicate predicate;
+            predicate.field = field;
+            predicate.op = static_cast<WhereOp>(op);
+            if (op == kWhereExists) {
+                predicate.operand.type = JsonValue::kBool;
+                predicate.operand.boolean = NValueToBool(env, jsOperand);
+            } else if (!NValueToJsonValue(env, jsOperand, predicate.operand)) {
+                return false;
+            } else if (predicate.operand.type == JsonValue::kArray || predicate.operand.type == JsonValue::kObject) {
+                napi_throw_type_error(env, nullptr, "where operands must be strings, numbers, booleans or null");
+                return false;
+            }
+            where.push_back(std::move(predicate));
+        }
+    }
+    return true;
+}
+
+// Range, prefix, limit, direction and where of a scan.
+static bool NValueToScanOptions(napi_env env, napi_value value, ScanOptions &options) {
+    if (!NValueToScanBound(env, value, "gte", "gt", options.hasLower, options.lowerInclusive, options.lower) ||
+        !NValueToScanBound(env, value, "lte", "lt", options.hasUpper, options.upperInclusive, options.upper)) {
+        return false;
+    }
+    napi_value jsPrefix = GetNamedProperty(env, value, "prefix");
+    if (!IsNValueUndefined(env, jsPrefix) && !NValueToKey(env, jsPrefix, options.prefix)) {
+        return false;
+    }
+    napi_value jsLimit = GetNamedProperty(env, value, "limit");
+    if (!IsNValueUndefined(env, jsLimit)) {
+        options.limit = NValueToUInt32(env, jsLimit);
+    }
+    options.reverse = NValueToBool(env, GetNamedProperty(env, value, "reverse"));
+    napi_value jsWhere = GetNamedProperty(env, value, "where");
+    return IsNValueUndefined(env, jsWhere) || NValueToWhere(env, jsWhere, options.where);
+}
+
+// options.keyEncoding: 'utf8' (default), 'binary' or 'tuple'.
+static std::string NValueToKeyEncoding(napi_env env, napi_value options) {
+    napi_value jsKeyEncoding = GetNamedProperty(env, options, "keyEncoding");
+    return IsNValueUndefined(env, jsKeyEncoding) ? "utf8" : NValueToString(env, jsKeyEncoding);
+}
+
+static napi_value KeyToNValue(napi_env env, const std::string &key, const std::string &keyEncoding) {
+    std::vector<KeyPart> parts;
+    if (keyEncoding == "tuple" && DecodeKeyTuple(key, parts)) {
+        return KeyTupleToNValue(env, parts);
+    } else if (keyEncoding == "utf8") {
+        return StringToNValue(env, key);
+    }
+    return BytesToNValue(env, key);
+}
+
+// With valueEncoding 'object', values are returned as parsed documents (text
+// that is not JSON stays a string); 'utf8' returns objects as JSON text.
+static napi_value ScanEntriesToNValue(napi_env env, const std::vector<ScanEntry> &entries,
+                                      const std::string &keyEncoding, const std::string &valueEncoding = "utf8") {
+    napi_value result = nullptr;
+    napi_create_array_with_length(env, entries.size(), &result);
+    for (size_t index = 0; index < entries.size(); index++) {
+        napi_value entry = NAPIObject(env);
+        SetNamedProperty(env, entry, "key", KeyToNValue(env, entries[index].key, keyEncoding));
+        const ScanEntry &scanned = entries[index];
+        napi_value jsValue = nullptr;
+        JsonValue document;
+        if (valueEncoding == "object" && (scanned.isObject ? DecodeObject(scanned.value, document)
+                                                             : ParseJson(scanned.value, document))) {
+            jsValue = JsonValueToNValue(env, document);
+        } else if (scanned.isObject) {
+            std::string json;
+            ObjectToJson(scanned.value, json);
+            jsValue = StringToNValue(env, json);
+        } else {
+            jsValue = StringToNValue(env, scanned.value);
+        }
+        SetNamedProperty(env, entry, "value", jsValue);
+        napi_set_element(env, result, index, entry);
+    }
+    return result;
+}
 
+static const char *const kIndexValueTypeNames[] = { "auto", "string", "number", "int64", "tags", "completion" };
+
+// Index field values: booleans are stored as 0/1.
+static bool NValueToIndexField(napi_env env, napi_value value, KeyPart &field) {
+    napi_valuetype type;
+    napi_typeof(env, value, &type);
+    if (type == napi_boolean) {
+        field.type = kKeyPartInt64;
+        field.int64 = NValueToBool(env, value) ? 1 : 0;
+        return true;
+    }
+    return NValueToKeyPart(env, value, field);
+}
+
+// Reads one side of an index query; eq sets both sides.
+static bool NValueToIndexBound(napi_env env, napi_value query, const char *inclusiveName, const char *exclusiveName,
+                               bool &hasBound, bool &inclusive, KeyPart &bound) {
+    napi_value jsBound = GetNamedProperty(env, query, "eq");
+    inclusive = true;
+    if (IsNValueUndefined(env, jsBound)) {
+        jsBound = GetNamedProperty(env, query, inclusiveName);
+    }
+    if (IsNValueUndefined(env, jsBound)) {
+        jsBound = GetNamedProperty(env, query, exclusiveName);
+        inclusive = false;
+    }
+    if (IsNValueUndefined(env, jsBound)) {
+        return true;
+    }
+    hasBound = true;
+    return NValueToIndexField(env, jsBound, bound);
+}
+
+static bool NValueToKeys(napi_env env, napi_value value, std::vector<std::string> &keys) {
+    uint32_t length = 0;
+    if (napi_get_array_length(env, value, &length) != napi_ok) {
+        return true;
+    }
+    keys.reserve(length);
     for (uint32_t index = 0; index < length; index++) {
         napi_value jsKey = nullptr;
+        std::string key;
         if (napi_get_element(env, value, index, &jsKey) != napi_ok) {
             continue;
         }
-        keys.push_back(NValueToString(env, jsKey));
+        if (!NValueToKey(env, jsKey, key)) {
+            return false;
+        }
+        keys.push_back(std::move(key));
+    }
+    return true;
+}
+
+static void NValueToStrings(napi_env env, napi_value value, std::vector<std::string> &strings) {
+    uint32_t length = 0;
+    if (napi_get_array_length(env, value, &length) != napi_ok) {
+        return;
+    }
+    strings.reserve(length);
+    for (uint32_t index = 0; index < length; index++) {
+        napi_value jsString = nullptr;
+        napi_get_element(env, value, index, &jsString);
+        strings.push_back(NValueToString(env, jsString));
+    }
+}
+
+// A missing range, or a missing bound, is open. Bounds are decoded like keys
+// so binary and tuple keys can be used; throws and returns false otherwise.
+static bool NValueToKeyRange(napi_env env, napi_value value, KeyRange &range) {
+    if (IsNValueUndefined(env, value)) {
+        return true;
+    }
+    napi_value jsStart = GetNamedProperty(env, value, "start");
+    if (!IsNValueUndefined(env, jsStart) && !NValueToKey(env, jsStart, range.start)) {
+        return false;
+    }
+    napi_value jsLimit = GetNamedProperty(env, value, "limit");
+    return IsNValueUndefined(env, jsLimit) || NValueToKey(env, jsLimit, range.limit);
+}
+
+static int64_t NValueToTtlMs(napi_env env, napi_value options) {
+    if (options == nullptr || IsNValueUndefined(env, options)) {
+        return 0;
     }
-    return keys;
+    napi_value jsTtl = GetNamedProperty(env, options, "ttlMs");
+    return IsNValueUndefined(env, jsTtl) ? 0 : static_cast<int64_t>(NValueToDouble(env, jsTtl));
 }
 
-static napi_value StringArrayToNValue(napi_env env, const std::vector<std::string> &value) {
-    napi_value jsArr = nullptr;
-    napi_create_array_with_length(env, value.size(), &jsArr);
-    for (size_t index = 0; index < value.size(); index++) {
-        auto jsKey = StringToNValue(env, value[index]);
-        napi_set_element(env, jsArr, index, jsKey);
+static bool NValueToKeyRanges(napi_env env, napi_value value, std::vector<KeyRange> &ranges) {
+    uint32_t length = 0;
+    if (napi_get_array_length(env, value, &length) != napi_ok || length == 0) {
+        return true;
+    }
+    ranges.reserve(length);
+
+    for (uint32_t index = 0; index < length; index++) {
+        napi_value jsRange = nullptr;
+        KeyRange range;
+        if (napi_get_element(env, value, index, &jsRange) != napi_ok) {
+            continue;
+        }
+        if (!NValueToKeyRange(env, jsRange, range)) {
+            return false;
+        }
+        ranges.push_back(std::move(range));
     }
-    return jsArr;
+    return true;
 }
 
-// export const open: (path: string) => number;
+// export const open: (path: string, options?: OpenOptions) => number;
 static napi_value open(napi_env env, napi_callback_info info) {
-    size_t argc = 1;
-    napi_value args[1] = {nullptr};
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
     NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
     
     std::string path = NValueToString(env, args[0]);
+    OpenOptions options;
+    if (argc > 1 && !IsNValueUndefined(env, args[1])) {
+        options.comparator = NValueToString(env, GetNamedProperty(env, args[1], "comparator"), true);
+        napi_value jsMaxBytes = GetNamedProperty(env, args[1], "maxBytes");
+        if (!IsNValueUndefined(env, jsMaxBytes)) {
+            options.maxBytes = static_cast<uint64_t>(std::max(0.0, NValueToDouble(env, jsMaxBytes)));
+        }
+        std::string eviction = NValueToString(env, GetNamedProperty(env, args[1], "eviction"), true);
+        if (eviction == "fifo") {
+            options.eviction = kCacheEvictFifo;
+        } else if (!eviction.empty() && eviction != "lru") {
+            napi_throw_range_error(env, nullptr, ("unknown eviction policy: " + eviction).c_str());
+            return NAPIUndefined(env);
+        }
+        napi_value jsBlobThreshold = GetNamedProperty(env, args[1], "blobThreshold");
+        if (!IsNValueUndefined(env, jsBlobThreshold)) {
+            options.blobThreshold = static_cast<uint64_t>(std::max(0.0, NValueToDouble(env, jsBlobThreshold)));
+        }
+        napi_value jsBlobGcRatio = GetNamedProperty(env, args[1], "blobGcRatio");
+        if (!IsNValueUndefined(env, jsBlobGcRatio)) {
+            options.blobGcRatio = NValueToDouble(env, jsBlobGcRatio);
+        }
+        std::string compression = NValueToString(env, GetNamedProperty(env, args[1], "compression"), true);
+        if (compression == "lz") {
+            options.compression = kCompressionLz;
+        } else if (!compression.empty() && compression != "none") {
+            napi_throw_range_error(env, nullptr, ("unknown compression: " + compression).c_str());
+            return NAPIUndefined(env);
+        }
+        napi_value jsCompressionMinBytes = GetNamedProperty(env, args[1], "compressionMinBytes");
+        if (!IsNValueUndefined(env, jsCompressionMinBytes)) {
+            options.compressionMinBytes = NValueToUInt32(env, jsCompressionMinBytes);
+        }
+        napi_value jsDedupThreshold = GetNamedProperty(env, args[1], "dedupThreshold");
+        if (!IsNValueUndefined(env, jsDedupThreshold)) {
+            options.dedupThreshold = static_cast<uint64_t>(std::max(0.0, NValueToDouble(env, jsDedupThreshold)));
+        }
+    }
     
     LevelDB *_db = new LevelDB();
-    bool flag = _db->Open(path);
+    std::string error;
+    bool flag = _db->Open(path, options, &error);
     if (!flag) {
+        delete _db;
+        napi_throw_error(env, nullptr, error.c_str());
         return NAPIUndefined(env);
     }
     return UInt64ToNValue(env, (uint64_t) _db);
@@ -205,10 +779,10 @@ static napi_value close(napi_env env, napi_callback_info info) {
     return NAPIUndefined(env);
 }
 
-// export const allKeys: (ptr: number) => string[];
+// export const allKeys: (ptr: number, options?: KeyListOptions) => LevelDBKey[];
 static napi_value allKeys(napi_env env, napi_callback_info info) {
-    size_t argc = 1;
-    napi_value args[1] = {nullptr};
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
     NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
     
     int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
@@ -217,11 +791,20 @@ static napi_value allKeys(napi_env env, napi_callback_info info) {
         return NAPIUndefined(env);
     }
     
+    std::string keyEncoding = "utf8";
+    if (argc > 1 && !IsNValueUndefined(env, args[1])) {
+        keyEncoding = NValueToKeyEncoding(env, args[1]);
+    }
     std::vector<std::string> keys = _db->GetAllKeys();
-    return StringArrayToNValue(env, keys);
+    napi_value result = nullptr;
+    napi_create_array_with_length(env, keys.size(), &result);
+    for (size_t index = 0; index < keys.size(); index++) {
+        napi_set_element(env, result, index, KeyToNValue(env, keys[index], keyEncoding));
+    }
+    return result;
 }
 
-// export const removeValueForKey: (ptr: number, key: string) => void;
+// export const removeValueForKey: (ptr: number, key: LevelDBKey) => void;
 static napi_value removeValueForKey(napi_env env, napi_callback_info info) {
     size_t argc = 2;
     napi_value args[2] = {nullptr};
@@ -233,12 +816,15 @@ static napi_value removeValueForKey(napi_env env, napi_callback_info info) {
         return NAPIUndefined(env);
     }
     
-    std::string key = NValueToString(env, args[1]);
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
     _db->Remove(key);
     return NAPIUndefined(env);
 }
 
-// export const removeValuesForKeys: (ptr: number, keys: string[]) => void;
+// export const removeValuesForKeys: (ptr: number, keys: LevelDBKey[]) => void;
 static napi_value removeValuesForKeys(napi_env env, napi_callback_info info) {
     size_t argc = 2;
     napi_value args[2] = {nullptr};
@@ -250,12 +836,15 @@ static napi_value removeValuesForKeys(napi_env env, napi_callback_info info) {
         return NAPIUndefined(env);
     }
     
-    std::vector<std::string> keys = NValueToStringArray(env, args[1]);
+    std::vector<std::string> keys;
+    if (!NValueToKeys(env, args[1], keys)) {
+        return NAPIUndefined(env);
+    }
     _db->Remove(keys);
     return NAPIUndefined(env);
 }
 
-// export const stringForKey: (ptr: number, key: string) => string;
+// export const stringForKey: (ptr: number, key: LevelDBKey) => string;
 static napi_value stringForKey(napi_env env, napi_callback_info info) {
     size_t argc = 2;
     napi_value args[2] = {nullptr};
@@ -267,7 +856,10 @@ static napi_value stringForKey(napi_env env, napi_callback_info info) {
         return NAPIUndefined(env);
     }
     
-    std::string key = NValueToString(env, args[1]);
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
     std::string value;
     if (!_db->Get(key, value)) {
         return NAPIUndefined(env);
@@ -275,7 +867,7 @@ static napi_value stringForKey(napi_env env, napi_callback_info info) {
     return StringToNValue(env, value);
 }
 
-// export const boolForKey: (ptr: number, key: string) => boolean;
+// export const boolForKey: (ptr: number, key: LevelDBKey) => boolean;
 static napi_value boolForKey(napi_env env, napi_callback_info info) {
     size_t argc = 2;
     napi_value args[2] = {nullptr};
@@ -287,7 +879,10 @@ static napi_value boolForKey(napi_env env, napi_callback_info info) {
         return NAPIUndefined(env);
     }
     
-    std::string key = NValueToString(env, args[1]);
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
     bool value;
     if (!_db->Get(key, value)) {
         return NAPIUndefined(env);
@@ -295,7 +890,7 @@ static napi_value boolForKey(napi_env env, napi_callback_info info) {
     return BoolToNValue(env, value);
 }
 
-// export const int32ForKey: (ptr: number, key: string) => number;
+// export const int32ForKey: (ptr: number, key: LevelDBKey) => number;
 static napi_value int32ForKey(napi_env env, napi_callback_info info) {
     size_t argc = 2;
     napi_value args[2] = {nullptr};
@@ -307,7 +902,10 @@ static napi_value int32ForKey(napi_env env, napi_callback_info info) {
         return NAPIUndefined(env);
     }
     
-    std::string key = NValueToString(env, args[1]);
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
     int32_t value;
     if (!_db->Get(key, value)) {
         return NAPIUndefined(env);
@@ -315,7 +913,7 @@ static napi_value int32ForKey(napi_env env, napi_callback_info info) {
     return Int32ToNValue(env, value);
 }
 
-// export const uint32ForKey: (ptr: number, key: string) => number;
+// export const uint32ForKey: (ptr: number, key: LevelDBKey) => number;
 static napi_value uint32ForKey(napi_env env, napi_callback_info info) {
     size_t argc = 2;
     napi_value args[2] = {nullptr};
@@ -327,7 +925,10 @@ static napi_value uint32ForKey(napi_env env, napi_callback_info info) {
         return NAPIUndefined(env);
     }
     
-    std::string key = NValueToString(env, args[1]);
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
     uint32_t value;
     if (!_db->Get(key, value)) {
         return NAPIUndefined(env);
@@ -335,7 +936,7 @@ static napi_value uint32ForKey(napi_env env, napi_callback_info info) {
     return UInt32ToNValue(env, value);
 }
 
-// export const int64ForKey: (ptr: number, key: string) => number;
+// export const int64ForKey: (ptr: number, key: LevelDBKey) => number;
 static napi_value int64ForKey(napi_env env, napi_callback_info info) {
     size_t argc = 2;
     napi_value args[2] = {nullptr};
@@ -347,7 +948,10 @@ static napi_value int64ForKey(napi_env env, napi_callback_info info) {
         return NAPIUndefined(env);
     }
     
-    std::string key = NValueToString(env, args[1]);
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
     int64_t value;
     if (!_db->Get(key, value)) {
         return NAPIUndefined(env);
@@ -355,7 +959,7 @@ static napi_value int64ForKey(napi_env env, napi_callback_info info) {
     return Int64ToNValue(env,value);
 }
 
-// export const uint64ForKey: (ptr: number, key: string) => number;
+// export const uint64ForKey: (ptr: number, key: LevelDBKey) => number;
 static napi_value uint64ForKey(napi_env env, napi_callback_info info) {
     size_t argc = 2;
     napi_value args[2] = {nullptr};
@@ -367,7 +971,10 @@ static napi_value uint64ForKey(napi_env env, napi_callback_info info) {
         return NAPIUndefined(env);
     }
     
-    std::string key = NValueToString(env, args[1]);
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
     uint64_t value;
     if (!_db->Get(key, value)) {
         return NAPIUndefined(env);
@@ -375,7 +982,7 @@ static napi_value uint64ForKey(napi_env env, napi_callback_info info) {
     return UInt64ToNValue(env,value);
 }
 
-// export const floatForKey: (ptr: number, key: string) => number;
+// export const floatForKey: (ptr: number, key: LevelDBKey) => number;
 static napi_value floatForKey(napi_env env, napi_callback_info info) {
     size_t argc = 2;
     napi_value args[2] = {nullptr};
@@ -387,7 +994,10 @@ static napi_value floatForKey(napi_env env, napi_callback_info info) {
         return NAPIUndefined(env);
     }
     
-    std::string key = NValueToString(env, args[1]);
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
     float value;
     if (!_db->Get(key, value)) {
         return NAPIUndefined(env);
@@ -395,7 +1005,7 @@ static napi_value floatForKey(napi_env env, napi_callback_info info) {
     return DoubleToNValue(env, value);
 }
 
-// export const doubleForKey: (ptr: number, key: string) => number;
+// export const doubleForKey: (ptr: number, key: LevelDBKey) => number;
 static napi_value doubleForKey(napi_env env, napi_callback_info info) {
     size_t argc = 2;
     napi_value args[2] = {nullptr};
@@ -407,7 +1017,10 @@ static napi_value doubleForKey(napi_env env, napi_callback_info info) {
         return NAPIUndefined(env);
     }
     
-    std::string key = NValueToString(env, args[1]);
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
     double value;
     if (!_db->Get(key, value)) {
         return NAPIUndefined(env);
@@ -415,10 +1028,10 @@ static napi_value doubleForKey(napi_env env, napi_callback_info info) {
     return DoubleToNValue(env, value);
 }
 
-// export const setStringValue: (ptr: number, key: string, value: string) => void;
+// export const setStringValue: (ptr: number, key: LevelDBKey, value: string, options?: PutOptions) => void;
 static napi_value setStringValue(napi_env env, napi_callback_info info) {
-    size_t argc = 3;
-    napi_value args[3] = {nullptr};
+    size_t argc = 4;
+    napi_value args[4] = {nullptr};
     NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
     
     int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
@@ -427,16 +1040,19 @@ static napi_value setStringValue(napi_env env, napi_callback_info info) {
         return NAPIUndefined(env);
     }
     
-    std::string key = NValueToString(env, args[1]);
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
     std::string value = NValueToString(env, args[2]);
-    _db->Put(key,value);
+    _db->Put(key, value, NValueToTtlMs(env, args[3]));
     return NAPIUndefined(env);
 }
 
-// export const setBoolValue: (ptr: number, key: string, value: boolean) => void;
+// export const setBoolValue: (ptr: number, key: LevelDBKey, value: boolean, options?: PutOptions) => void;
 static napi_value setBoolValue(napi_env env, napi_callback_info info) {
-    size_t argc = 3;
-    napi_value args[3] = {nullptr};
+    size_t argc = 4;
+    napi_value args[4] = {nullptr};
     NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
     
     int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
@@ -445,16 +1061,19 @@ static napi_value setBoolValue(napi_env env, napi_callback_info info) {
         return NAPIUndefined(env);
     }
     
-    std::string key = NValueToString(env, args[1]);
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
     bool value = NValueToBool(env, args[2]);
-    _db->Put(key, value);
+    _db->Put(key, value, NValueToTtlMs(env, args[3]));
     return NAPIUndefined(env);
 }
 
-// export const setInt32Value: (ptr: number, key: string, value: number) => void;
+// export const setInt32Value: (ptr: number, key: LevelDBKey, value: number, options?: PutOptions) => void;
 static napi_value setInt32Value(napi_env env, napi_callback_info info) {
-    size_t argc = 3;
-    napi_value args[3] = {nullptr};
+    size_t argc = 4;
+    napi_value args[4] = {nullptr};
     NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
     
     int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
@@ -463,16 +1082,19 @@ static napi_value setInt32Value(napi_env env, napi_callback_info info) {
         return NAPIUndefined(env);
     }
     
-    std::string key = NValueToString(env, args[1]);
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
     int32_t value = NValueToInt32(env, args[2]);
-    _db->Put(key, static_cast<int32_t>(value));
+    _db->Put(key, static_cast<int32_t>(value), NValueToTtlMs(env, args[3]));
     return NAPIUndefined(env);
 }
 
-// export const setUInt32Value: (ptr: number, key: string, value: number) => void;
+// export const setUInt32Value: (ptr: number, key: LevelDBKey, value: number, options?: PutOptions) => void;
 static napi_value setUInt32Value(napi_env env, napi_callback_info info) {
-    size_t argc = 3;
-    napi_value args[3] = {nullptr};
+    size_t argc = 4;
+    napi_value args[4] = {nullptr};
     NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
     
     int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
@@ -481,16 +1103,19 @@ static napi_value setUInt32Value(napi_env env, napi_callback_info info) {
         return NAPIUndefined(env);
     }
     
-    std::string key = NValueToString(env, args[1]);
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
     uint32_t value = NValueToUInt32(env, args[2]);
-    _db->Put(key, static_cast<uint32_t>(value));
+    _db->Put(key, static_cast<uint32_t>(value), NValueToTtlMs(env, args[3]));
     return NAPIUndefined(env);
 }
 
-// export const setInt64Value: (ptr: number, key: string, value: number) => void;
+// export const setInt64Value: (ptr: number, key: LevelDBKey, value: number, options?: PutOptions) => void;
 static napi_value setInt64Value(napi_env env, napi_callback_info info) {
-    size_t argc = 3;
-    napi_value args[3] = {nullptr};
+    size_t argc = 4;
+    napi_value args[4] = {nullptr};
     NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
     
     int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
@@ -499,16 +1124,19 @@ static napi_value setInt64Value(napi_env env, napi_callback_info info) {
         return NAPIUndefined(env);
     }
     
-    std::string key = NValueToString(env, args[1]);
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
     int64_t value = NValueToInt64(env, args[2]);
-    _db->Put(key, static_cast<int64_t>(value));
+    _db->Put(key, static_cast<int64_t>(value), NValueToTtlMs(env, args[3]));
     return NAPIUndefined(env);
 }
 
-// export const setUInt64Value: (ptr: number, key: string, value: number) => void;
+// export const setUInt64Value: (ptr: number, key: LevelDBKey, value: number, options?: PutOptions) => void;
 static napi_value setUInt64Value(napi_env env, napi_callback_info info) {
-    size_t argc = 3;
-    napi_value args[3] = {nullptr};
+    size_t argc = 4;
+    napi_value args[4] = {nullptr};
     NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
     
     int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
@@ -517,16 +1145,19 @@ static napi_value setUInt64Value(napi_env env, napi_callback_info info) {
         return NAPIUndefined(env);
     }
     
-    std::string key = NValueToString(env, args[1]);
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
     uint64_t value = NValueToUInt64(env, args[2]);
-    _db->Put(key, static_cast<uint64_t>(value));
+    _db->Put(key, static_cast<uint64_t>(value), NValueToTtlMs(env, args[3]));
     return NAPIUndefined(env);
 }
 
-// export const setFloatValue: (ptr: number, key: string, value: number) => void;
+// export const setFloatValue: (ptr: number, key: LevelDBKey, value: number, options?: PutOptions) => void;
 static napi_value setFloatValue(napi_env env, napi_callback_info info) {
-    size_t argc = 3;
-    napi_value args[3] = {nullptr};
+    size_t argc = 4;
+    napi_value args[4] = {nullptr};
     NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
     
     int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
@@ -535,16 +1166,19 @@ static napi_value setFloatValue(napi_env env, napi_callback_info info) {
         return NAPIUndefined(env);
     }
     
-    std::string key = NValueToString(env, args[1]);
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
     float value = NValueToDouble(env, args[2]);
-    _db->Put(key, static_cast<float>(value));
+    _db->Put(key, static_cast<float>(value), NValueToTtlMs(env, args[3]));
     return NAPIUndefined(env);
 }
 
-// export const setDoubleValue: (ptr: number, key: string, value: number) => void;
+// export const setDoubleValue: (ptr: number, key: LevelDBKey, value: number, options?: PutOptions) => void;
 static napi_value setDoubleValue(napi_env env, napi_callback_info info) {
-    size_t argc = 3;
-    napi_value args[3] = {nullptr};
+    size_t argc = 4;
+    napi_value args[4] = {nullptr};
     NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
     
     int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
@@ -553,12 +1187,2033 @@ static napi_value setDoubleValue(napi_env env, napi_callback_info info) {
         return NAPIUndefined(env);
     }
     
-    std::string key = NValueToString(env, args[1]);
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
     double value = NValueToDouble(env, args[2]);
-    _db->Put(key, value);
+    _db->Put(key, value, NValueToTtlMs(env, args[3]));
     return NAPIUndefined(env);
 }
 
+// export const setObject: (ptr: number, key: LevelDBKey, value: Object, options?: PutOptions) => void;
+static napi_value setObject(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    JsonValue value;
+    if (!NValueToJsonValue(env, args[2], value)) {
+        return NAPIUndefined(env);
+    }
+    _db->PutObject(key, value, NValueToTtlMs(env, args[3]));
+    return NAPIUndefined(env);
+}
+
+// export const objectForKey: (ptr: number, key: LevelDBKey) => Object | undefined;
+static napi_value objectForKey(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    JsonValue value;
+    if (!_db->GetObject(key, value)) {
+        return NAPIUndefined(env);
+    }
+    return JsonValueToNValue(env, value);
+}
+
+// export const getProperty: (ptr: number, name: string) => string | undefined;
+static napi_value getProperty(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string name = NValueToString(env, args[1]);
+    std::string value;
+    if (!_db->GetProperty(name, value)) {
+        return NAPIUndefined(env);
+    }
+    return StringToNValue(env, value);
+}
+
+// export const getStats: (ptr: number) => LevelDBStats;
+static napi_value getStats(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    DBStats stats = _db->GetStats();
+    napi_value jsFilesAtLevel = nullptr;
+    napi_create_array_with_length(env, stats.filesAtLevel.size(), &jsFilesAtLevel);
+    int32_t totalFiles = 0;
+    for (size_t index = 0; index < stats.filesAtLevel.size(); index++) {
+        napi_set_element(env, jsFilesAtLevel, index, Int32ToNValue(env, stats.filesAtLevel[index]));
+        totalFiles += stats.filesAtLevel[index];
+    }
+
+    napi_value jsLevels = nullptr;
+    napi_create_array_with_length(env, stats.levels.size(), &jsLevels);
+    for (size_t index = 0; index < stats.levels.size(); index++) {
+        const LevelStats &level = stats.levels[index];
+        napi_value jsLevel = NAPIObject(env);
+        SetNamedProperty(env, jsLevel, "level", Int32ToNValue(env, level.level));
+        SetNamedProperty(env, jsLevel, "files", Int32ToNValue(env, level.files));
+        SetNamedProperty(env, jsLevel, "sizeMB", DoubleToNValue(env, level.sizeMB));
+        SetNamedProperty(env, jsLevel, "timeSec", DoubleToNValue(env, level.timeSec));
+        SetNamedProperty(env, jsLevel, "readMB", DoubleToNValue(env, level.readMB));
+        SetNamedProperty(env, jsLevel, "writeMB", DoubleToNValue(env, level.writeMB));
+        napi_set_element(env, jsLevels, index, jsLevel);
+    }
+
+    napi_value result = NAPIObject(env);
+    SetNamedProperty(env, result, "filesAtLevel", jsFilesAtLevel);
+    SetNamedProperty(env, result, "totalFiles", Int32ToNValue(env, totalFiles));
+    SetNamedProperty(env, result, "levels", jsLevels);
+    SetNamedProperty(env, result, "approximateMemoryUsage",
+                     DoubleToNValue(env, static_cast<double>(stats.approximateMemoryUsage)));
+    SetNamedProperty(env, result, "stats", StringToNValue(env, stats.stats));
+    SetNamedProperty(env, result, "sstables", StringToNValue(env, stats.sstables));
+    return result;
+}
+
+// export const approximateSize: (ptr: number, ranges: KeyRange[]) => number[];
+static napi_value approximateSize(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::vector<KeyRange> ranges;
+    if (!NValueToKeyRanges(env, args[1], ranges)) {
+        return NAPIUndefined(env);
+    }
+    std::vector<uint64_t> sizes = _db->GetApproximateSizes(ranges);
+    napi_value jsSizes = nullptr;
+    napi_create_array_with_length(env, sizes.size(), &jsSizes);
+    for (size_t index = 0; index < sizes.size(); index++) {
+        napi_set_element(env, jsSizes, index, DoubleToNValue(env, static_cast<double>(sizes[index])));
+    }
+    return jsSizes;
+}
+
+struct CompactionWork {
+    napi_async_work work = nullptr;
+    napi_deferred deferred = nullptr;
+    napi_threadsafe_function progress = nullptr;
+    LevelDB *db = nullptr;
+    KeyRange range;
+    uint64_t cancelEpoch = 0;
+    CompactionResult result;
+};
+
+struct CompactionProgressEvent {
+    int completed;
+    int total;
+};
+
+static void CallCompactionProgress(napi_env env, napi_value jsCallback, void *, void *data) {
+    CompactionProgressEvent *event = static_cast<CompactionProgressEvent *>(data);
+    if (env != nullptr && jsCallback != nullptr) {
+        napi_value argv[2] = {Int32ToNValue(env, event->completed), Int32ToNValue(env, event->total)};
+        napi_call_function(env, NAPIUndefined(env), jsCallback, 2, argv, nullptr);
+    }
+    delete event;
+}
+
+static void ExecuteCompaction(napi_env, void *data) {
+    CompactionWork *work = static_cast<CompactionWork *>(data);
+    work->result = work->db->CompactRange(work->range, work->cancelEpoch, [work](int completed, int total) {
+        if (work->progress) {
+            napi_call_threadsafe_function(work->progress, new CompactionProgressEvent{completed, total},
+                                          napi_tsfn_nonblocking);
+        }
+    });
+    work->db->ReleaseTask();
+}
+
+static void CompleteCompaction(napi_env env, napi_status, void *data) {
+    CompactionWork *work = static_cast<CompactionWork *>(data);
+    napi_value result = NAPIObject(env);
+    SetNamedProperty(env, result, "sizeBefore", DoubleToNValue(env, static_cast<double>(work->result.sizeBefore)));
+    SetNamedProperty(env, result, "sizeAfter", DoubleToNValue(env, static_cast<double>(work->result.sizeAfter)));
+    SetNamedProperty(env, result, "totalRanges", Int32ToNValue(env, work->result.totalRanges));
+    SetNamedProperty(env, result, "completedRanges", Int32ToNValue(env, work->result.completedRanges));
+    SetNamedProperty(env, result, "cancelled", BoolToNValue(env, work->result.cancelled));
+    napi_resolve_deferred(env, work->deferred, result);
+    if (work->progress) {
+        napi_release_threadsafe_function(work->progress, napi_tsfn_release);
+    }
+    napi_delete_async_work(env, work->work);
+    delete work;
+}
+
+// export const compactAsync: (ptr: number, range?: KeyRange, onProgress?: (completed: number, total: number) => void) => Promise<CompactionResult>;
+static napi_value compactAsync(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    KeyRange range;
+    if (!NValueToKeyRange(env, args[1], range)) {
+        return NAPIUndefined(env);
+    }
+    
+    napi_value promise = nullptr;
+    CompactionWork *work = new CompactionWork();
+    NAPI_CALL(napi_create_promise(env, &work->deferred, &promise));
+    if (!_db->RetainTask()) {
+        napi_reject_deferred(env, work->deferred, StringToNValue(env, "database is closed"));
+        delete work;
+        return promise;
+    }
+    work->db = _db;
+    work->range = range;
+    work->cancelEpoch = _db->CompactionEpoch();
+    if (argc > 2 && IsNValueFunction(env, args[2])) {
+        napi_create_threadsafe_function(env, args[2], nullptr, StringToNValue(env, "compactProgress"), 0, 1,
+                                        nullptr, nullptr, nullptr, CallCompactionProgress, &work->progress);
+    }
+    napi_create_async_work(env, nullptr, StringToNValue(env, "compactAsync"), ExecuteCompaction,
+                           CompleteCompaction, work, &work->work);
+    napi_queue_async_work(env, work->work);
+    return promise;
+}
+
+// export const cancelCompaction: (ptr: number) => void;
+static napi_value cancelCompaction(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    _db->CancelCompaction();
+    return NAPIUndefined(env);
+}
+
+// export const setIdleCompaction: (ptr: number, options: IdleCompactionOptions) => void;
+static napi_value setIdleCompaction(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    bool enabled = NValueToBool(env, GetNamedProperty(env, args[1], "enabled"));
+    napi_value jsInterval = GetNamedProperty(env, args[1], "intervalMs");
+    napi_value jsMaxRanges = GetNamedProperty(env, args[1], "maxRanges");
+    int64_t intervalMs = IsNValueUndefined(env, jsInterval) ? 6 * 3600 * 1000 : NValueToDouble(env, jsInterval);
+    int32_t maxRanges = IsNValueUndefined(env, jsMaxRanges) ? 0 : NValueToInt32(env, jsMaxRanges);
+    _db->SetIdleCompaction(enabled, intervalMs, maxRanges);
+    return NAPIUndefined(env);
+}
+
+// export const reportDeviceState: (ptr: number, state: DeviceState) => void;
+static napi_value reportDeviceState(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    bool idle = NValueToBool(env, GetNamedProperty(env, args[1], "idle"));
+    bool charging = NValueToBool(env, GetNamedProperty(env, args[1], "charging"));
+    _db->ReportDeviceState(idle, charging);
+    return NAPIUndefined(env);
+}
+
+// export const setTombstoneCompaction: (ptr: number, options: TombstoneCompactionOptions) => void;
+static napi_value setTombstoneCompaction(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    bool enabled = NValueToBool(env, GetNamedProperty(env, args[1], "enabled"));
+    napi_value jsThreshold = GetNamedProperty(env, args[1], "threshold");
+    napi_value jsDelimiters = GetNamedProperty(env, args[1], "delimiters");
+    uint64_t threshold = IsNValueUndefined(env, jsThreshold) ? 10000 : NValueToDouble(env, jsThreshold);
+    std::string delimiters = IsNValueUndefined(env, jsDelimiters) ? ":/" : NValueToString(env, jsDelimiters);
+    _db->SetTombstoneCompaction(enabled, threshold, delimiters);
+    return NAPIUndefined(env);
+}
+
+// export const tombstoneStats: (ptr: number) => TombstoneStats[];
+static napi_value tombstoneStats(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::vector<TombstoneRange> ranges = _db->GetTombstoneStats();
+    napi_value jsRanges = nullptr;
+    napi_create_array_with_length(env, ranges.size(), &jsRanges);
+    for (size_t index = 0; index < ranges.size(); index++) {
+        napi_value jsRange = NAPIObject(env);
+        SetNamedProperty(env, jsRange, "prefix", StringToNValue(env, ranges[index].prefix));
+        SetNamedProperty(env, jsRange, "count", DoubleToNValue(env, static_cast<double>(ranges[index].count)));
+        SetNamedProperty(env, jsRange, "start", StringToNValue(env, ranges[index].start));
+        SetNamedProperty(env, jsRange, "limit", StringToNValue(env, ranges[index].limit));
+        napi_set_element(env, jsRanges, index, jsRange);
+    }
+    return jsRanges;
+}
+
+static napi_value WritePressureToNValue(napi_env env, const WritePressure &pressure) {
+    napi_value result = NAPIObject(env);
+    SetNamedProperty(env, result, "level", Int32ToNValue(env, pressure.level));
+    SetNamedProperty(env, result, "l0Files", Int32ToNValue(env, pressure.l0Files));
+    SetNamedProperty(env, result, "memtableBytes", DoubleToNValue(env, static_cast<double>(pressure.memtableBytes)));
+    SetNamedProperty(env, result, "writeBufferSize",
+                     DoubleToNValue(env, static_cast<double>(pressure.writeBufferSize)));
+    SetNamedProperty(env, result, "avgWriteLatencyUs", DoubleToNValue(env, pressure.avgWriteLatencyUs));
+    SetNamedProperty(env, result, "maxWriteLatencyUs", DoubleToNValue(env, pressure.maxWriteLatencyUs));
+    return result;
+}
+
+// Releases the JS callback once the native listener that captured it is gone.
+struct ThreadsafeCallback {
+    napi_threadsafe_function tsfn = nullptr;
+    ~ThreadsafeCallback() {
+        if (tsfn) {
+            napi_release_threadsafe_function(tsfn, napi_tsfn_release);
+        }
+    }
+};
+
+static void CallWritePressure(napi_env env, napi_value jsCallback, void *, void *data) {
+    WritePressure *pressure = static_cast<WritePressure *>(data);
+    if (env != nullptr && jsCallback != nullptr) {
+        napi_value argv[1] = {WritePressureToNValue(env, *pressure)};
+        napi_call_function(env, NAPIUndefined(env), jsCallback, 1, argv, nullptr);
+    }
+    delete pressure;
+}
+
+// export const writePressure: (ptr: number) => WritePressure;
+static napi_value writePressure(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    return WritePressureToNValue(env, _db->GetWritePressure());
+}
+
+// export const onWritePressure: (ptr: number, callback?: (pressure: WritePressure) => void) => void;
+static napi_value onWritePressure(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    if (argc < 2 || !IsNValueFunction(env, args[1])) {
+        _db->SetWritePressureListener(nullptr);
+        return NAPIUndefined(env);
+    }
+    auto callback = std::make_shared<ThreadsafeCallback>();
+    NAPI_CALL(napi_create_threadsafe_function(env, args[1], nullptr, StringToNValue(env, "writePressure"), 0, 1,
+                                              nullptr, nullptr, nullptr, CallWritePressure, &callback->tsfn));
+    napi_unref_threadsafe_function(env, callback->tsfn);
+    _db->SetWritePressureListener([callback](const WritePressure &pressure) {
+        napi_call_threadsafe_function(callback->tsfn, new WritePressure(pressure), napi_tsfn_nonblocking);
+    });
+    return NAPIUndefined(env);
+}
+
+// export const sweepExpired: (ptr: number, maxKeys?: number) => number;
+static napi_value sweepExpired(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    size_t maxKeys = IsNValueUndefined(env, args[1]) ? 0 : NValueToDouble(env, args[1]);
+    return DoubleToNValue(env, static_cast<double>(_db->SweepExpired(maxKeys)));
+}
+
+// export const setExpirySweep: (ptr: number, options: ExpirySweepOptions) => void;
+static napi_value setExpirySweep(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    napi_value jsInterval = GetNamedProperty(env, args[1], "intervalMs");
+    napi_value jsBatchSize = GetNamedProperty(env, args[1], "batchSize");
+    int64_t intervalMs = IsNValueUndefined(env, jsInterval) ? 60 * 1000 : NValueToDouble(env, jsInterval);
+    size_t batchSize = IsNValueUndefined(env, jsBatchSize) ? 1000 : NValueToDouble(env, jsBatchSize);
+    _db->SetExpirySweep(intervalMs, batchSize);
+    return NAPIUndefined(env);
+}
+
+// export const increment: (ptr: number, key: LevelDBKey, delta: bigint) => bigint | undefined;
+static napi_value increment(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    int64_t delta = NValueToInt64(env, args[2]);
+    int64_t result = 0;
+    if (!_db->Increment(key, delta, result)) {
+        return NAPIUndefined(env);
+    }
+    return Int64ToNValue(env, result);
+}
+
+// export const compareAndSwap: (ptr: number, key: LevelDBKey, expected: string | undefined, value: string) => boolean;
+static napi_value compareAndSwap(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    bool expectAbsent = IsNValueUndefined(env, args[2]);
+    std::string expected = NValueToString(env, args[2], true);
+    std::string value = NValueToString(env, args[3]);
+    return BoolToNValue(env, _db->CompareAndSwap(key, expectAbsent ? nullptr : &expected, value));
+}
+
+// export const getAndSet: (ptr: number, key: LevelDBKey, value: string) => string | undefined;
+static napi_value getAndSet(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    std::string value = NValueToString(env, args[2]);
+    std::string previous;
+    if (!_db->GetAndSet(key, value, previous)) {
+        return NAPIUndefined(env);
+    }
+    return StringToNValue(env, previous);
+}
+
+// export const merge: (ptr: number, key: LevelDBKey, op: MergeOperator, operand: bigint | number | string) => boolean;
+static napi_value merge(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    std::string opName = NValueToString(env, args[2]);
+    MergeOperator op;
+    if (opName == "add") {
+        op = kMergeAdd;
+    } else if (opName == "max") {
+        op = kMergeMax;
+    } else if (opName == "append") {
+        op = kMergeAppend;
+    } else {
+        napi_throw_error(env, nullptr, ("unknown merge operator: " + opName).c_str());
+        return NAPIUndefined(env);
+    }
+
+    napi_valuetype type;
+    napi_typeof(env, args[3], &type);
+    std::string operand;
+    bool exact = true;
+    if (op == kMergeAppend) {
+        napi_value text = args[3];
+        if (type != napi_string) {
+            napi_coerce_to_string(env, args[3], &text);
+        }
+        operand = NValueToString(env, text);
+    } else if (type == napi_bigint) {
+        int64_t value = 0;
+        napi_get_value_bigint_int64(env, args[3], &value, &exact);
+        operand = std::to_string(value);
+    } else if (type == napi_number) {
+        // Only integers that a double holds exactly.
+        double value = NValueToDouble(env, args[3]);
+        exact = std::trunc(value) == value && std::fabs(value) <= kMaxSafeInteger;
+        operand = exact ? std::to_string(static_cast<int64_t>(value)) : std::string();
+    } else {
+        operand = NValueToString(env, args[3]);
+    }
+    if (!exact || !LevelDB::IsValidMergeOperand(op, operand)) {
+        napi_throw_error(env, nullptr, (opName + " needs an int64 operand").c_str());
+        return NAPIUndefined(env);
+    }
+    return BoolToNValue(env, _db->Merge(key, op, operand));
+}
+
+// export const setMergeCollapseThreshold: (ptr: number, threshold: number) => void;
+static napi_value setMergeCollapseThreshold(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    _db->SetMergeCollapseThreshold(NValueToUInt32(env, args[1]));
+    return NAPIUndefined(env);
+}
+
+// export const beginTransaction: (ptr: number) => number;
+static napi_value beginTransaction(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    Transaction *_txn = new Transaction(_db);
+    return UInt64ToNValue(env, (uint64_t) _txn);
+}
+
+// export const txnGet: (txn: number, key: LevelDBKey) => string | undefined;
+static napi_value txnGet(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _txn_instance_ptr = NValueToInt64(env, args[0]);
+    Transaction* _txn = reinterpret_cast<Transaction*>(_txn_instance_ptr);
+    if (!_txn) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    std::string value;
+    if (!_txn->Get(key, value)) {
+        return NAPIUndefined(env);
+    }
+    return StringToNValue(env, value);
+}
+
+// export const txnPut: (txn: number, key: LevelDBKey, value: string) => void;
+static napi_value txnPut(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _txn_instance_ptr = NValueToInt64(env, args[0]);
+    Transaction* _txn = reinterpret_cast<Transaction*>(_txn_instance_ptr);
+    if (!_txn) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    std::string value = NValueToString(env, args[2]);
+    _txn->Put(key, value);
+    return NAPIUndefined(env);
+}
+
+// export const txnRemove: (txn: number, key: LevelDBKey) => void;
+static napi_value txnRemove(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _txn_instance_ptr = NValueToInt64(env, args[0]);
+    Transaction* _txn = reinterpret_cast<Transaction*>(_txn_instance_ptr);
+    if (!_txn) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    _txn->Remove(key);
+    return NAPIUndefined(env);
+}
+
+// export const txnCommit: (txn: number) => boolean;
+static napi_value txnCommit(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _txn_instance_ptr = NValueToInt64(env, args[0]);
+    Transaction* _txn = reinterpret_cast<Transaction*>(_txn_instance_ptr);
+    if (!_txn) {
+        return NAPIUndefined(env);
+    }
+    
+    return BoolToNValue(env, _txn->Commit());
+}
+
+// export const txnRelease: (txn: number) => void;
+static napi_value txnRelease(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _txn_instance_ptr = NValueToInt64(env, args[0]);
+    Transaction* _txn = reinterpret_cast<Transaction*>(_txn_instance_ptr);
+    if (!_txn) {
+        return NAPIUndefined(env);
+    }
+    
+    delete _txn;
+    return NAPIUndefined(env);
+}
+
+// export const encodeKey: (parts: KeyPart[]) => Uint8Array;
+static napi_value encodeKey(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    std::string key;
+    if (!NValueToKeyTuple(env, args[0], key)) {
+        return NAPIUndefined(env);
+    }
+    return BytesToNValue(env, key);
+}
+
+// export const decodeKey: (key: Uint8Array | ArrayBuffer) => KeyPart[] | undefined;
+static napi_value decodeKey(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    std::string key;
+    std::vector<KeyPart> parts;
+    if (!NValueToBytes(env, args[0], key) || !DecodeKeyTuple(key, parts)) {
+        return NAPIUndefined(env);
+    }
+    return KeyTupleToNValue(env, parts);
+}
+
+// export const scan: (ptr: number, options?: ScanOptions) => ScanEntry[];
+static napi_value scan(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    ScanOptions options;
+    std::string keyEncoding = "utf8";
+    std::string valueEncoding;
+    if (!IsNValueUndefined(env, args[1])) {
+        if (!NValueToScanOptions(env, args[1], options)) {
+            return NAPIUndefined(env);
+        }
+        keyEncoding = NValueToKeyEncoding(env, args[1]);
+        valueEncoding = NValueToString(env, GetNamedProperty(env, args[1], "valueEncoding"), true);
+        napi_value jsProject = GetNamedProperty(env, args[1], "project");
+        if (!IsNValueUndefined(env, jsProject)) {
+            NValueToStrings(env, jsProject, options.project);
+        }
+    }
+
+    return ScanEntriesToNValue(env, _db->Scan(options), keyEncoding, valueEncoding);
+}
+
+// export const aggregate: (ptr: number, range?: ScanOptions, options?: AggregateOptions) => AggregateResult;
+static napi_value aggregate(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    ScanOptions range;
+    if (!IsNValueUndefined(env, args[1]) && !NValueToScanOptions(env, args[1], range)) {
+        return NAPIUndefined(env);
+    }
+    AggregateOptions options;
+    if (!IsNValueUndefined(env, args[2])) {
+        options.field = NValueToString(env, GetNamedProperty(env, args[2], "field"), true);
+        napi_value jsHistogram = GetNamedProperty(env, args[2], "histogram");
+        if (!IsNValueUndefined(env, jsHistogram)) {
+            options.histogram.min = NValueToDouble(env, GetNamedProperty(env, jsHistogram, "min"));
+            options.histogram.max = NValueToDouble(env, GetNamedProperty(env, jsHistogram, "max"));
+            options.histogram.buckets = NValueToUInt32(env, GetNamedProperty(env, jsHistogram, "buckets"));
+            if (options.histogram.buckets == 0 || !(options.histogram.max > options.histogram.min)) {
+                napi_throw_range_error(env, nullptr, "histogram needs buckets > 0 and max > min");
+                return NAPIUndefined(env);
+            }
+        }
+    }
+
+    AggregateResult aggregated = _db->Aggregate(range, options);
+    napi_value result = NAPIObject(env);
+    SetNamedProperty(env, result, "count", DoubleToNValue(env, static_cast<double>(aggregated.count)));
+    SetNamedProperty(env, result, "skipped", DoubleToNValue(env, static_cast<double>(aggregated.skipped)));
+    SetNamedProperty(env, result, "sum", DoubleToNValue(env, aggregated.sum));
+    if (aggregated.count > 0) {
+        SetNamedProperty(env, result, "min", DoubleToNValue(env, aggregated.min));
+        SetNamedProperty(env, result, "max", DoubleToNValue(env, aggregated.max));
+        SetNamedProperty(env, result, "mean", DoubleToNValue(env, aggregated.sum / aggregated.count));
+    }
+    if (!aggregated.histogram.empty()) {
+        napi_value jsBuckets = nullptr;
+        napi_create_array_with_length(env, aggregated.histogram.size(), &jsBuckets);
+        for (size_t index = 0; index < aggregated.histogram.size(); index++) {
+            napi_set_element(env, jsBuckets, index, DoubleToNValue(env, static_cast<double>(aggregated.histogram[index])));
+        }
+        napi_value jsHistogram = NAPIObject(env);
+        SetNamedProperty(env, jsHistogram, "buckets", jsBuckets);
+        SetNamedProperty(env, jsHistogram, "below", DoubleToNValue(env, static_cast<double>(aggregated.below)));
+        SetNamedProperty(env, jsHistogram, "above", DoubleToNValue(env, static_cast<double>(aggregated.above)));
+        SetNamedProperty(env, result, "histogram", jsHistogram);
+    }
+    return result;
+}
+
+static napi_value SortedSetMembersToNValue(napi_env env, const std::vector<SortedSetMember> &members) {
+    napi_value result = nullptr;
+    napi_create_array_with_length(env, members.size(), &result);
+    for (size_t index = 0; index < members.size(); index++) {
+        napi_value jsMember = NAPIObject(env);
+        SetNamedProperty(env, jsMember, "member", StringToNValue(env, members[index].member));
+        SetNamedProperty(env, jsMember, "score", DoubleToNValue(env, members[index].score));
+        napi_set_element(env, result, index, jsMember);
+    }
+    return result;
+}
+
+// Reads one side of a score range from range[inclusiveName] or range[exclusiveName].
+static void NValueToScoreBound(napi_env env, napi_value range, const char *inclusiveName, const char *exclusiveName,
+                               bool &hasBound, bool &inclusive, double &bound) {
+    napi_value jsBound = GetNamedProperty(env, range, inclusiveName);
+    inclusive = true;
+    if (IsNValueUndefined(env, jsBound)) {
+        jsBound = GetNamedProperty(env, range, exclusiveName);
+        inclusive = false;
+    }
+    if (!IsNValueUndefined(env, jsBound)) {
+        hasBound = true;
+        bound = NValueToDouble(env, jsBound);
+    }
+}
+
+// export const zadd: (ptr: number, name: string, members: SortedSetMember[]) => number;
+static napi_value zadd(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string name = NValueToString(env, args[1]);
+    std::vector<SortedSetMember> members;
+    uint32_t length = 0;
+    napi_get_array_length(env, args[2], &length);
+    members.reserve(length);
+    for (uint32_t index = 0; index < length; index++) {
+        napi_value jsMember = nullptr;
+        napi_get_element(env, args[2], index, &jsMember);
+        SortedSetMember member;
+        member.member = NValueToString(env, GetNamedProperty(env, jsMember, "member"));
+        member.score = NValueToDouble(env, GetNamedProperty(env, jsMember, "score"));
+        if (std::isnan(member.score)) {
+            napi_throw_range_error(env, nullptr, "score must be a number");
+            return NAPIUndefined(env);
+        }
+        members.push_back(std::move(member));
+    }
+    uint64_t added = 0;
+    if (!_db->ZAdd(name, members, added)) {
+        return NAPIUndefined(env);
+    }
+    return DoubleToNValue(env, static_cast<double>(added));
+}
+
+// export const zrem: (ptr: number, name: string, members: string[]) => number;
+static napi_value zrem(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string name = NValueToString(env, args[1]);
+    std::vector<std::string> members;
+    uint32_t length = 0;
+    napi_get_array_length(env, args[2], &length);
+    for (uint32_t index = 0; index < length; index++) {
+        napi_value jsMember = nullptr;
+        napi_get_element(env, args[2], index, &jsMember);
+        members.push_back(NValueToString(env, jsMember));
+    }
+    uint64_t removed = 0;
+    if (!_db->ZRem(name, members, removed)) {
+        return NAPIUndefined(env);
+    }
+    return DoubleToNValue(env, static_cast<double>(removed));
+}
+
+// export const zscore: (ptr: number, name: string, member: string) => number | undefined;
+static napi_value zscore(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    double score = 0;
+    if (!_db->ZScore(NValueToString(env, args[1]), NValueToString(env, args[2]), score)) {
+        return NAPIUndefined(env);
+    }
+    return DoubleToNValue(env, score);
+}
+
+// export const zcard: (ptr: number, name: string) => number;
+static napi_value zcard(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    return DoubleToNValue(env, static_cast<double>(_db->ZCard(NValueToString(env, args[1]))));
+}
+
+// export const zrank: (ptr: number, name: string, member: string, reverse?: boolean) => number | undefined;
+static napi_value zrank(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    uint64_t rank = 0;
+    if (!_db->ZRank(NValueToString(env, args[1]), NValueToString(env, args[2]), NValueToBool(env, args[3]), rank)) {
+        return NAPIUndefined(env);
+    }
+    return DoubleToNValue(env, static_cast<double>(rank));
+}
+
+// export const zrangeByScore: (ptr: number, name: string, range?: ScoreRange) => SortedSetMember[];
+static napi_value zrangeByScore(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    ScoreRange range;
+    if (!IsNValueUndefined(env, args[2])) {
+        napi_value jsRange = args[2];
+        NValueToScoreBound(env, jsRange, "gte", "gt", range.hasMin, range.minInclusive, range.min);
+        NValueToScoreBound(env, jsRange, "lte", "lt", range.hasMax, range.maxInclusive, range.max);
+        napi_value jsOffset = GetNamedProperty(env, jsRange, "offset");
+        if (!IsNValueUndefined(env, jsOffset)) {
+            range.offset = NValueToUInt32(env, jsOffset);
+        }
+        napi_value jsLimit = GetNamedProperty(env, jsRange, "limit");
+        if (!IsNValueUndefined(env, jsLimit)) {
+            range.limit = NValueToUInt32(env, jsLimit);
+        }
+        range.reverse = NValueToBool(env, GetNamedProperty(env, jsRange, "reverse"));
+    }
+    return SortedSetMembersToNValue(env, _db->ZRangeByScore(NValueToString(env, args[1]), range));
+}
+
+// export const enqueue: (ptr: number, name: string, items: string[]) => number | undefined;
+static napi_value enqueue(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string name = NValueToString(env, args[1]);
+    std::vector<std::string> items;
+    uint32_t length = 0;
+    napi_get_array_length(env, args[2], &length);
+    items.reserve(length);
+    for (uint32_t index = 0; index < length; index++) {
+        napi_value jsItem = nullptr;
+        napi_get_element(env, args[2], index, &jsItem);
+        items.push_back(NValueToString(env, jsItem));
+    }
+    uint64_t firstSeq = 0;
+    if (!_db->Enqueue(name, items, firstSeq)) {
+        return NAPIUndefined(env);
+    }
+    return DoubleToNValue(env, static_cast<double>(firstSeq));
+}
+
+// export const peek: (ptr: number, name: string, maxItems: number) => QueueItem[];
+static napi_value peek(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::vector<QueueItem> items = _db->Peek(NValueToString(env, args[1]), NValueToUInt32(env, args[2]));
+    napi_value result = nullptr;
+    napi_create_array_with_length(env, items.size(), &result);
+    for (size_t index = 0; index < items.size(); index++) {
+        napi_value jsItem = NAPIObject(env);
+        SetNamedProperty(env, jsItem, "seq", DoubleToNValue(env, static_cast<double>(items[index].seq)));
+        SetNamedProperty(env, jsItem, "value", StringToNValue(env, items[index].value));
+        napi_set_element(env, result, index, jsItem);
+    }
+    return result;
+}
+
+// export const ack: (ptr: number, name: string, upToSeq: number) => number;
+static napi_value ack(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    double upToSeq = NValueToDouble(env, args[2]);
+    uint64_t acked = 0;
+    if (upToSeq >= 0) {
+        _db->Ack(NValueToString(env, args[1]), static_cast<uint64_t>(upToSeq), acked);
+    }
+    return DoubleToNValue(env, static_cast<double>(acked));
+}
+
+// export const queueLength: (ptr: number, name: string) => number;
+static napi_value queueLength(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    return DoubleToNValue(env, static_cast<double>(_db->QueueLength(NValueToString(env, args[1]))));
+}
+
+struct BlobGcWork {
+    napi_async_work work = nullptr;
+    napi_deferred deferred = nullptr;
+    LevelDB *db = nullptr;
+    bool sealActive = false;
+    BlobGcResult result;
+};
+
+static void ExecuteBlobGc(napi_env, void *data) {
+    BlobGcWork *work = static_cast<BlobGcWork *>(data);
+    work->result = work->db->CollectBlobGarbage(work->sealActive);
+    work->db->ReleaseTask();
+}
+
+static void CompleteBlobGc(napi_env env, napi_status, void *data) {
+    BlobGcWork *work = static_cast<BlobGcWork *>(data);
+    napi_value result = NAPIObject(env);
+    SetNamedProperty(env, result, "filesRewritten", Int32ToNValue(env, work->result.filesRewritten));
+    SetNamedProperty(env, result, "bytesMoved", DoubleToNValue(env, static_cast<double>(work->result.bytesMoved)));
+    SetNamedProperty(env, result, "bytesReclaimed",
+                     DoubleToNValue(env, static_cast<double>(work->result.bytesReclaimed)));
+    napi_resolve_deferred(env, work->deferred, result);
+    napi_delete_async_work(env, work->work);
+    delete work;
+}
+
+// export const collectBlobGarbage: (ptr: number, sealActive?: boolean) => Promise<BlobGcResult>;
+static napi_value collectBlobGarbage(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    napi_value promise = nullptr;
+    BlobGcWork *work = new BlobGcWork();
+    NAPI_CALL(napi_create_promise(env, &work->deferred, &promise));
+    if (!_db->RetainTask()) {
+        napi_reject_deferred(env, work->deferred, StringToNValue(env, "database is closed"));
+        delete work;
+        return promise;
+    }
+    work->db = _db;
+    work->sealActive = argc > 1 && !IsNValueUndefined(env, args[1]) && NValueToBool(env, args[1]);
+    napi_create_async_work(env, nullptr, StringToNValue(env, "collectBlobGarbage"), ExecuteBlobGc,
+                           CompleteBlobGc, work, &work->work);
+    napi_queue_async_work(env, work->work);
+    return promise;
+}
+
+struct DictionaryWork {
+    napi_async_work work = nullptr;
+    napi_deferred deferred = nullptr;
+    LevelDB *db = nullptr;
+    DictionaryOptions options;
+    bool trained = false;
+    uint32_t id = 0;
+    std::string error;
+};
+
+static void ExecuteDictionaryTraining(napi_env, void *data) {
+    DictionaryWork *work = static_cast<DictionaryWork *>(data);
+    work->trained = work->db->TrainCompressionDictionary(work->options, work->id, &work->error);
+    work->db->ReleaseTask();
+}
+
+static void CompleteDictionaryTraining(napi_env env, napi_status, void *data) {
+    DictionaryWork *work = static_cast<DictionaryWork *>(data);
+    if (work->trained) {
+        napi_resolve_deferred(env, work->deferred, UInt32ToNValue(env, work->id));
+    } else {
+        napi_reject_deferred(env, work->deferred, StringToNValue(env, work->error));
+    }
+    napi_delete_async_work(env, work->work);
+    delete work;
+}
+
+// export const trainCompressionDictionary: (ptr: number, options?: DictionaryOptions) => Promise<number>;
+static napi_value trainCompressionDictionary(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    DictionaryOptions options;
+    if (argc > 1 && !IsNValueUndefined(env, args[1])) {
+        napi_value jsPrefix = GetNamedProperty(env, args[1], "prefix");
+        if (!IsNValueUndefined(env, jsPrefix) && !NValueToKey(env, jsPrefix, options.prefix)) {
+            return NAPIUndefined(env);
+        }
+        napi_value jsSampleCount = GetNamedProperty(env, args[1], "sampleCount");
+        if (!IsNValueUndefined(env, jsSampleCount)) {
+            options.sampleCount = std::max<uint32_t>(NValueToUInt32(env, jsSampleCount), 1);
+        }
+        napi_value jsMaxSize = GetNamedProperty(env, args[1], "maxSize");
+        if (!IsNValueUndefined(env, jsMaxSize)) {
+            options.maxSize = NValueToUInt32(env, jsMaxSize);
+        }
+    }
+    napi_value promise = nullptr;
+    DictionaryWork *work = new DictionaryWork();
+    NAPI_CALL(napi_create_promise(env, &work->deferred, &promise));
+    if (!_db->RetainTask()) {
+        napi_reject_deferred(env, work->deferred, StringToNValue(env, "database is closed"));
+        delete work;
+        return promise;
+    }
+    work->db = _db;
+    work->options = options;
+    napi_create_async_work(env, nullptr, StringToNValue(env, "trainCompressionDictionary"),
+                           ExecuteDictionaryTraining, CompleteDictionaryTraining, work, &work->work);
+    napi_queue_async_work(env, work->work);
+    return promise;
+}
+
+// export const openWriteStream: (ptr: number, key: LevelDBKey, chunkSize?: number) => number;
+static napi_value openWriteStream(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    uint32_t chunkSize = StreamWriter::kDefaultChunkSize;
+    if (argc > 2 && !IsNValueUndefined(env, args[2])) {
+        chunkSize = NValueToUInt32(env, args[2]);
+    }
+    StreamWriter *_writer = new StreamWriter(_db, key, chunkSize);
+    return UInt64ToNValue(env, (uint64_t) _writer);
+}
+
+// export const streamWrite: (writer: number, data: string | Uint8Array | ArrayBuffer) => boolean;
+static napi_value streamWrite(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _writer_instance_ptr = NValueToInt64(env, args[0]);
+    StreamWriter* _writer = reinterpret_cast<StreamWriter*>(_writer_instance_ptr);
+    if (!_writer) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string data;
+    if (!NValueToBytes(env, args[1], data)) {
+        data = NValueToString(env, args[1]);
+    }
+    return BoolToNValue(env, _writer->Write(data));
+}
+
+// export const streamFinish: (writer: number) => boolean;
+static napi_value streamFinish(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _writer_instance_ptr = NValueToInt64(env, args[0]);
+    StreamWriter* _writer = reinterpret_cast<StreamWriter*>(_writer_instance_ptr);
+    if (!_writer) {
+        return NAPIUndefined(env);
+    }
+    
+    bool finished = _writer->Finish();
+    delete _writer;
+    return BoolToNValue(env, finished);
+}
+
+// export const streamAbort: (writer: number) => void;
+static napi_value streamAbort(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _writer_instance_ptr = NValueToInt64(env, args[0]);
+    StreamWriter* _writer = reinterpret_cast<StreamWriter*>(_writer_instance_ptr);
+    if (!_writer) {
+        return NAPIUndefined(env);
+    }
+    
+    delete _writer;
+    return NAPIUndefined(env);
+}
+
+// export const openReadStream: (ptr: number, key: LevelDBKey) => number | undefined;
+static napi_value openReadStream(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    StreamReader *_reader = new StreamReader(_db, key);
+    if (!_reader->Exists()) {
+        delete _reader;
+        return NAPIUndefined(env);
+    }
+    return UInt64ToNValue(env, (uint64_t) _reader);
+}
+
+// export const streamRead: (reader: number, maxBytes: number) => Uint8Array | undefined;
+static napi_value streamRead(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _reader_instance_ptr = NValueToInt64(env, args[0]);
+    StreamReader* _reader = reinterpret_cast<StreamReader*>(_reader_instance_ptr);
+    if (!_reader) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string data;
+    if (!_reader->Read(NValueToUInt32(env, args[1]), data)) {
+        return NAPIUndefined(env);
+    }
+    return BytesToNValue(env, data);
+}
+
+// export const streamReadAt: (reader: number, offset: number, length: number) => Uint8Array | undefined;
+static napi_value streamReadAt(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _reader_instance_ptr = NValueToInt64(env, args[0]);
+    StreamReader* _reader = reinterpret_cast<StreamReader*>(_reader_instance_ptr);
+    if (!_reader) {
+        return NAPIUndefined(env);
+    }
+    
+    double offset = NValueToDouble(env, args[1]);
+    std::string data;
+    if (offset < 0 || !_reader->ReadAt(static_cast<uint64_t>(offset), NValueToUInt32(env, args[2]), data)) {
+        return NAPIUndefined(env);
+    }
+    return BytesToNValue(env, data);
+}
+
+// export const streamSize: (reader: number) => number;
+static napi_value streamSize(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _reader_instance_ptr = NValueToInt64(env, args[0]);
+    StreamReader* _reader = reinterpret_cast<StreamReader*>(_reader_instance_ptr);
+    if (!_reader) {
+        return NAPIUndefined(env);
+    }
+    
+    return DoubleToNValue(env, static_cast<double>(_reader->Length()));
+}
+
+// export const streamRelease: (reader: number) => void;
+static napi_value streamRelease(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _reader_instance_ptr = NValueToInt64(env, args[0]);
+    StreamReader* _reader = reinterpret_cast<StreamReader*>(_reader_instance_ptr);
+    if (!_reader) {
+        return NAPIUndefined(env);
+    }
+    
+    delete _reader;
+    return NAPIUndefined(env);
+}
+
+// export const streamLength: (ptr: number, key: LevelDBKey) => number | undefined;
+static napi_value streamLength(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    uint64_t length = 0;
+    if (!NValueToKey(env, args[1], key) || !_db->GetStreamLength(key, length)) {
+        return NAPIUndefined(env);
+    }
+    return DoubleToNValue(env, static_cast<double>(length));
+}
+
+// export const removeStream: (ptr: number, key: LevelDBKey) => boolean;
+static napi_value removeStream(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    return BoolToNValue(env, _db->RemoveStream(key));
+}
+
+// export const putVector: (ptr: number, key: LevelDBKey, vector: Float32Array, options?: VectorPutOptions) => boolean;
+static napi_value putVector(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    std::vector<float> vector;
+    if (!NValueToFloats(env, args[2], vector)) {
+        napi_throw_type_error(env, nullptr, "vector must be a Float32Array or an array of numbers");
+        return NAPIUndefined(env);
+    }
+    bool quantize = argc > 3 && !IsNValueUndefined(env, args[3]) &&
+                    NValueToBool(env, GetNamedProperty(env, args[3], "quantize"));
+    return BoolToNValue(env, _db->PutVector(key, vector.data(), vector.size(), quantize));
+}
+
+// export const getVector: (ptr: number, key: LevelDBKey) => Float32Array | undefined;
+static napi_value getVector(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    std::vector<float> vector;
+    if (!_db->GetVector(key, vector)) {
+        return NAPIUndefined(env);
+    }
+    return FloatsToNValue(env, vector);
+}
+
+// export const removeVector: (ptr: number, key: LevelDBKey) => boolean;
+static napi_value removeVector(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    return BoolToNValue(env, _db->RemoveVector(key));
+}
+
+static const char *const kVectorMetricNames[] = { "dot", "cosine", "l2" };
+
+struct VectorSearchWork {
+    napi_async_work work = nullptr;
+    napi_deferred deferred = nullptr;
+    LevelDB *db = nullptr;
+    std::vector<float> query;
+    VectorSearchOptions options;
+    std::vector<VectorMatch> matches;
+};
+
+static void ExecuteVectorSearch(napi_env, void *data) {
+    VectorSearchWork *work = static_cast<VectorSearchWork *>(data);
+    work->matches = work->db->SearchVectors(work->query, work->options);
+    work->db->ReleaseTask();
+}
+
+static void CompleteVectorSearch(napi_env env, napi_status, void *data) {
+    VectorSearchWork *work = static_cast<VectorSearchWork *>(data);
+    napi_value result = nullptr;
+    napi_create_array_with_length(env, work->matches.size(), &result);
+    for (size_t index = 0; index < work->matches.size(); index++) {
+        napi_value jsMatch = NAPIObject(env);
+        SetNamedProperty(env, jsMatch, "key", StringToNValue(env, work->matches[index].key));
+        SetNamedProperty(env, jsMatch, "score", DoubleToNValue(env, work->matches[index].score));
+        napi_set_element(env, result, index, jsMatch);
+    }
+    napi_resolve_deferred(env, work->deferred, result);
+    napi_delete_async_work(env, work->work);
+    delete work;
+}
+
+// export const searchVectors: (ptr: number, prefix: LevelDBKey, query: Float32Array, k: number, metric?: VectorMetric, options?: VectorSearchOptions) => Promise<VectorMatch[]>;
+static napi_value searchVectors(napi_env env, napi_callback_info info) {
+    size_t argc = 6;
+    napi_value args[6] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    VectorSearchOptions options;
+    if (!IsNValueUndefined(env, args[1]) && !NValueToKey(env, args[1], options.prefix)) {
+        return NAPIUndefined(env);
+    }
+    std::vector<float> query;
+    if (!NValueToFloats(env, args[2], query)) {
+        napi_throw_type_error(env, nullptr, "query must be a Float32Array or an array of numbers");
+        return NAPIUndefined(env);
+    }
+    options.k = NValueToUInt32(env, args[3]);
+    if (argc > 4 && !IsNValueUndefined(env, args[4])) {
+        std::string metricName = NValueToString(env, args[4]);
+        auto begin = std::begin(kVectorMetricNames);
+        auto found = std::find(begin, std::end(kVectorMetricNames), metricName);
+        if (found == std::end(kVectorMetricNames)) {
+            napi_throw_range_error(env, nullptr, ("unknown vector metric: " + metricName).c_str());
+            return NAPIUndefined(env);
+        }
+        options.metric = static_cast<VectorMetric>(found - begin);
+    }
+    if (argc > 5 && !IsNValueUndefined(env, args[5])) {
+        options.quantized = NValueToBool(env, GetNamedProperty(env, args[5], "quantized"));
+        napi_value jsThreads = GetNamedProperty(env, args[5], "threads");
+        if (!IsNValueUndefined(env, jsThreads)) {
+            options.threads = NValueToUInt32(env, jsThreads);
+        }
+    }
+    napi_value promise = nullptr;
+    VectorSearchWork *work = new VectorSearchWork();
+    NAPI_CALL(napi_create_promise(env, &work->deferred, &promise));
+    if (!_db->RetainTask()) {
+        napi_reject_deferred(env, work->deferred, StringToNValue(env, "database is closed"));
+        delete work;
+        return promise;
+    }
+    work->db = _db;
+    work->query = std::move(query);
+    work->options = options;
+    napi_create_async_work(env, nullptr, StringToNValue(env, "searchVectors"), ExecuteVectorSearch,
+                           CompleteVectorSearch, work, &work->work);
+    napi_queue_async_work(env, work->work);
+    return promise;
+}
+
+static const char *const kSchemaFieldTypeNames[] = { "bool", "int32", "int64", "double", "string" };
+
+// export const defineSchema: (ptr: number, name: string, fields: SchemaField[]) => void;
+static napi_value defineSchema(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string name = NValueToString(env, args[1]);
+    std::vector<SchemaField> fields;
+    uint32_t length = 0;
+    napi_get_array_length(env, args[2], &length);
+    for (uint32_t index = 0; index < length; index++) {
+        napi_value jsField = nullptr;
+        napi_get_element(env, args[2], index, &jsField);
+        SchemaField field;
+        field.name = NValueToString(env, GetNamedProperty(env, jsField, "name"), true);
+        std::string typeName = NValueToString(env, GetNamedProperty(env, jsField, "type"), true);
+        auto begin = std::begin(kSchemaFieldTypeNames);
+        auto found = std::find(begin, std::end(kSchemaFieldTypeNames), typeName);
+        if (found == std::end(kSchemaFieldTypeNames)) {
+            napi_throw_range_error(env, nullptr, ("unknown field type: " + typeName).c_str());
+            return NAPIUndefined(env);
+        }
+        field.type = static_cast<SchemaFieldType>(found - begin);
+        fields.push_back(std::move(field));
+    }
+    std::string error;
+    if (!_db->DefineSchema(name, fields, &error)) {
+        napi_throw_error(env, nullptr, error.c_str());
+    }
+    return NAPIUndefined(env);
+}
+
+// export const putRecord: (ptr: number, key: LevelDBKey, schema: string, record: Object, options?: PutOptions) => void;
+static napi_value putRecord(napi_env env, napi_callback_info info) {
+    size_t argc = 5;
+    napi_value args[5] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    std::string schema = NValueToString(env, args[2]);
+    JsonValue record;
+    if (!NValueToJsonValue(env, args[3], record)) {
+        return NAPIUndefined(env);
+    }
+    std::string error;
+    if (!_db->PutRecord(key, schema, record, NValueToTtlMs(env, args[4]), &error) && !error.empty()) {
+        napi_throw_type_error(env, nullptr, error.c_str());
+    }
+    return NAPIUndefined(env);
+}
+
+// export const getFields: (ptr: number, key: LevelDBKey, fields: string[]) => Object | undefined;
+static napi_value getFields(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    std::vector<std::string> fields;
+    NValueToStrings(env, args[2], fields);
+    JsonValue record;
+    if (!_db->GetFields(key, fields, record)) {
+        return NAPIUndefined(env);
+    }
+    return JsonValueToNValue(env, record);
+}
+
+// export const defineIndex: (ptr: number, name: string, options?: IndexOptions) => void;
+static napi_value defineIndex(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    IndexSpec spec;
+    spec.name = NValueToString(env, args[1]);
+    if (!IsNValueUndefined(env, args[2])) {
+        spec.field = NValueToString(env, GetNamedProperty(env, args[2], "field"), true);
+        napi_value jsKeyPrefix = GetNamedProperty(env, args[2], "keyPrefix");
+        if (!IsNValueUndefined(env, jsKeyPrefix) && !NValueToKey(env, jsKeyPrefix, spec.keyPrefix)) {
+            return NAPIUndefined(env);
+        }
+        napi_value jsType = GetNamedProperty(env, args[2], "type");
+        if (!IsNValueUndefined(env, jsType)) {
+            std::string typeName = NValueToString(env, jsType);
+            auto begin = std::begin(kIndexValueTypeNames);
+            auto found = std::find(begin, std::end(kIndexValueTypeNames), typeName);
+            if (found == std::end(kIndexValueTypeNames)) {
+                napi_throw_error(env, nullptr, ("unknown index type: " + typeName).c_str());
+                return NAPIUndefined(env);
+            }
+            spec.type = static_cast<IndexValueType>(found - begin);
+        }
+        spec.scoreField = NValueToString(env, GetNamedProperty(env, args[2], "scoreField"), true);
+    }
+    std::string error;
+    if (!_db->DefineIndex(spec, &error)) {
+        napi_throw_error(env, nullptr, error.c_str());
+    }
+    return NAPIUndefined(env);
+}
+
+// export const dropIndex: (ptr: number, name: string) => boolean;
+static napi_value dropIndex(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    return BoolToNValue(env, _db->DropIndex(NValueToString(env, args[1])));
+}
+
+// export const indexes: (ptr: number) => IndexDefinition[];
+static napi_value indexes(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::vector<IndexSpec> specs = _db->GetIndexes();
+    napi_value result = nullptr;
+    napi_create_array_with_length(env, specs.size(), &result);
+    for (size_t index = 0; index < specs.size(); index++) {
+        napi_value jsSpec = NAPIObject(env);
+        SetNamedProperty(env, jsSpec, "name", StringToNValue(env, specs[index].name));
+        SetNamedProperty(env, jsSpec, "field", StringToNValue(env, specs[index].field));
+        SetNamedProperty(env, jsSpec, "keyPrefix", StringToNValue(env, specs[index].keyPrefix));
+        SetNamedProperty(env, jsSpec, "type", StringToNValue(env, kIndexValueTypeNames[specs[index].type]));
+        if (specs[index].type == kIndexValueCompletion) {
+            SetNamedProperty(env, jsSpec, "scoreField", StringToNValue(env, specs[index].scoreField));
+        }
+        napi_set_element(env, result, index, jsSpec);
+    }
+    return result;
+}
+
+// export const queryIndex: (ptr: number, name: string, query?: IndexQuery) => ScanEntry[];
+static napi_value queryIndex(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string name = NValueToString(env, args[1]);
+    IndexQuery query;
+    std::string keyEncoding = "utf8";
+    if (!IsNValueUndefined(env, args[2])) {
+        napi_value jsQuery = args[2];
+        if (!NValueToIndexBound(env, jsQuery, "gte", "gt", query.hasLower, query.lowerInclusive, query.lower) ||
+            !NValueToIndexBound(env, jsQuery, "lte", "lt", query.hasUpper, query.upperInclusive, query.upper)) {
+            return NAPIUndefined(env);
+        }
+        napi_value jsLimit = GetNamedProperty(env, jsQuery, "limit");
+        if (!IsNValueUndefined(env, jsLimit)) {
+            query.limit = NValueToUInt32(env, jsLimit);
+        }
+        query.reverse = NValueToBool(env, GetNamedProperty(env, jsQuery, "reverse"));
+        keyEncoding = NValueToKeyEncoding(env, jsQuery);
+    }
+    std::vector<ScanEntry> entries;
+    if (!_db->QueryIndex(name, query, entries)) {
+        napi_throw_error(env, nullptr, ("unknown index or bound of the wrong type: " + name).c_str());
+        return NAPIUndefined(env);
+    }
+    return ScanEntriesToNValue(env, entries, keyEncoding);
+}
+
+// export const queryTags: (ptr: number, name: string, expression: string, options?: TagQueryOptions) => LevelDBKey[];
+static napi_value queryTags(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string name = NValueToString(env, args[1]);
+    std::string expression = NValueToString(env, args[2]);
+    size_t limit = 0;
+    std::string keyEncoding = "utf8";
+    if (argc > 3 && !IsNValueUndefined(env, args[3])) {
+        napi_value jsLimit = GetNamedProperty(env, args[3], "limit");
+        if (!IsNValueUndefined(env, jsLimit)) {
+            limit = NValueToUInt32(env, jsLimit);
+        }
+        keyEncoding = NValueToKeyEncoding(env, args[3]);
+    }
+    std::vector<std::string> keys;
+    std::string error;
+    if (!_db->QueryTags(name, expression, limit, keys, &error)) {
+        napi_throw_error(env, nullptr, error.c_str());
+        return NAPIUndefined(env);
+    }
+    napi_value result = nullptr;
+    napi_create_array_with_length(env, keys.size(), &result);
+    for (size_t index = 0; index < keys.size(); index++) {
+        napi_set_element(env, result, index, KeyToNValue(env, keys[index], keyEncoding));
+    }
+    return result;
+}
+
+// export const countTags: (ptr: number, name: string, expression: string) => number;
+static napi_value countTags(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    uint64_t count = 0;
+    std::string error;
+    if (!_db->CountTags(NValueToString(env, args[1]), NValueToString(env, args[2]), count, &error)) {
+        napi_throw_error(env, nullptr, error.c_str());
+        return NAPIUndefined(env);
+    }
+    return DoubleToNValue(env, static_cast<double>(count));
+}
+
+// export const complete: (ptr: number, name: string, input: string, k: number, options?: CompletionOptions) => CompletionMatch[];
+static napi_value complete(napi_env env, napi_callback_info info) {
+    size_t argc = 5;
+    napi_value args[5] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string name = NValueToString(env, args[1]);
+    std::string keyEncoding = "utf8";
+    if (argc > 4 && !IsNValueUndefined(env, args[4])) {
+        keyEncoding = NValueToKeyEncoding(env, args[4]);
+    }
+    std::vector<CompletionMatch> matches;
+    if (!_db->Complete(name, NValueToString(env, args[2]), NValueToUInt32(env, args[3]), matches)) {
+        napi_throw_error(env, nullptr, ("unknown completion index: " + name).c_str());
+        return NAPIUndefined(env);
+    }
+    napi_value result = nullptr;
+    napi_create_array_with_length(env, matches.size(), &result);
+    for (size_t index = 0; index < matches.size(); index++) {
+        napi_value jsMatch = NAPIObject(env);
+        SetNamedProperty(env, jsMatch, "key", KeyToNValue(env, matches[index].key, keyEncoding));
+        SetNamedProperty(env, jsMatch, "term", StringToNValue(env, matches[index].term));
+        SetNamedProperty(env, jsMatch, "score", DoubleToNValue(env, matches[index].score));
+        napi_set_element(env, result, index, jsMatch);
+    }
+    return result;
+}
+
+// export const putPoint: (ptr: number, key: LevelDBKey, lat: number, lon: number) => boolean;
+static napi_value putPoint(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    return BoolToNValue(env, _db->PutPoint(key, NValueToDouble(env, args[2]), NValueToDouble(env, args[3])));
+}
+
+// export const getPoint: (ptr: number, key: LevelDBKey) => GeoPoint | undefined;
+static napi_value getPoint(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    double lat = 0;
+    double lon = 0;
+    if (!_db->GetPoint(key, lat, lon)) {
+        return NAPIUndefined(env);
+    }
+    napi_value point = NAPIObject(env);
+    SetNamedProperty(env, point, "lat", DoubleToNValue(env, lat));
+    SetNamedProperty(env, point, "lon", DoubleToNValue(env, lon));
+    return point;
+}
+
+// export const removePoint: (ptr: number, key: LevelDBKey) => boolean;
+static napi_value removePoint(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    std::string key;
+    if (!NValueToKey(env, args[1], key)) {
+        return NAPIUndefined(env);
+    }
+    return BoolToNValue(env, _db->RemovePoint(key));
+}
+
+// Reads GeoQueryOptions; false when a JS exception is pending.
+static bool NValueToGeoQueryOptions(napi_env env, napi_value value, GeoQueryOptions &options,
+                                    std::string &keyEncoding) {
+    keyEncoding = "utf8";
+    if (IsNValueUndefined(env, value)) {
+        return true;
+    }
+    napi_value prefix = GetNamedProperty(env, value, "prefix");
+    if (!IsNValueUndefined(env, prefix) && !NValueToKey(env, prefix, options.prefix)) {
+        return false;
+    }
+    napi_value limit = GetNamedProperty(env, value, "limit");
+    if (!IsNValueUndefined(env, limit)) {
+        options.limit = NValueToUInt32(env, limit);
+    }
+    keyEncoding = NValueToKeyEncoding(env, value);
+    return true;
+}
+
+static napi_value GeoMatchesToNValue(napi_env env, const std::vector<GeoMatch> &matches,
+                                     const std::string &keyEncoding, bool distance) {
+    napi_value result = nullptr;
+    napi_create_array_with_length(env, matches.size(), &result);
+    for (size_t index = 0; index < matches.size(); index++) {
+        napi_value jsMatch = NAPIObject(env);
+        SetNamedProperty(env, jsMatch, "key", KeyToNValue(env, matches[index].key, keyEncoding));
+        SetNamedProperty(env, jsMatch, "lat", DoubleToNValue(env, matches[index].lat));
+        SetNamedProperty(env, jsMatch, "lon", DoubleToNValue(env, matches[index].lon));
+        if (distance) {
+            SetNamedProperty(env, jsMatch, "distance", DoubleToNValue(env, matches[index].distance));
+        }
+        napi_set_element(env, result, index, jsMatch);
+    }
+    return result;
+}
+
+// export const queryRadius: (ptr: number, lat: number, lon: number, radiusMeters: number, options?: GeoQueryOptions) => GeoMatch[];
+static napi_value queryRadius(napi_env env, napi_callback_info info) {
+    size_t argc = 5;
+    napi_value args[5] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    double lat = NValueToDouble(env, args[1]);
+    double lon = NValueToDouble(env, args[2]);
+    double radiusMeters = NValueToDouble(env, args[3]);
+    if (!IsValidGeoPoint(lat, lon) || !(radiusMeters >= 0)) {
+        napi_throw_range_error(env, nullptr, "invalid center or radius");
+        return NAPIUndefined(env);
+    }
+    GeoQueryOptions options;
+    std::string keyEncoding;
+    if (!NValueToGeoQueryOptions(env, args[4], options, keyEncoding)) {
+        return NAPIUndefined(env);
+    }
+    return GeoMatchesToNValue(env, _db->QueryRadius(lat, lon, radiusMeters, options), keyEncoding, true);
+}
+
+// export const queryBox: (ptr: number, box: GeoBox, options?: GeoQueryOptions) => GeoMatch[];
+static napi_value queryBox(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3] = {nullptr};
+    NAPI_CALL(napi_get_cb_info(env, info, &argc, args, nullptr, nullptr));
+    
+    int64_t _db_instance_ptr = NValueToInt64(env, args[0]);
+    LevelDB* _db = reinterpret_cast<LevelDB*>(_db_instance_ptr);
+    if (!_db) {
+        return NAPIUndefined(env);
+    }
+    
+    GeoBox box;
+    box.minLat = NValueToDouble(env, GetNamedProperty(env, args[1], "minLat"));
+    box.minLon = NValueToDouble(env, GetNamedProperty(env, args[1], "minLon"));
+    box.maxLat = NValueToDouble(env, GetNamedProperty(env, args[1], "maxLat"));
+    box.maxLon = NValueToDouble(env, GetNamedProperty(env, args[1], "maxLon"));
+    if (!IsValidGeoBox(box)) {
+        napi_throw_range_error(env, nullptr, "invalid box");
+        return NAPIUndefined(env);
+    }
+    GeoQueryOptions options;
+    std::string keyEncoding;
+    if (!NValueToGeoQueryOptions(env, args[2], options, keyEncoding)) {
+        return NAPIUndefined(env);
+    }
+    return GeoMatchesToNValue(env, _db->QueryBox(box, options), keyEncoding, false);
+}
+
 EXTERN_C_START
 static napi_value Init(napi_env env, napi_value exports) {
     napi_property_descriptor desc[] = {
@@ -583,6 +3238,78 @@ static napi_value Init(napi_env env, napi_value exports) {
         { "setUInt64Value", nullptr, setUInt64Value, nullptr, nullptr, nullptr, napi_default, nullptr },
         { "setFloatValue", nullptr, setFloatValue, nullptr, nullptr, nullptr, napi_default, nullptr },
         { "setDoubleValue", nullptr, setDoubleValue, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "setObject", nullptr, setObject, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "objectForKey", nullptr, objectForKey, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "getProperty", nullptr, getProperty, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "getStats", nullptr, getStats, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "approximateSize", nullptr, approximateSize, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "compactAsync", nullptr, compactAsync, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "cancelCompaction", nullptr, cancelCompaction, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "setIdleCompaction", nullptr, setIdleCompaction, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "reportDeviceState", nullptr, reportDeviceState, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "setTombstoneCompaction", nullptr, setTombstoneCompaction, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "tombstoneStats", nullptr, tombstoneStats, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "writePressure", nullptr, writePressure, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "onWritePressure", nullptr, onWritePressure, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "sweepExpired", nullptr, sweepExpired, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "setExpirySweep", nullptr, setExpirySweep, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "increment", nullptr, increment, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "compareAndSwap", nullptr, compareAndSwap, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "getAndSet", nullptr, getAndSet, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "merge", nullptr, merge, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "setMergeCollapseThreshold", nullptr, setMergeCollapseThreshold, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "beginTransaction", nullptr, beginTransaction, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "txnGet", nullptr, txnGet, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "txnPut", nullptr, txnPut, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "txnRemove", nullptr, txnRemove, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "txnCommit", nullptr, txnCommit, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "txnRelease", nullptr, txnRelease, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "encodeKey", nullptr, encodeKey, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "decodeKey", nullptr, decodeKey, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "scan", nullptr, scan, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "aggregate", nullptr, aggregate, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "zadd", nullptr, zadd, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "zrem", nullptr, zrem, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "zscore", nullptr, zscore, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "zcard", nullptr, zcard, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "zrank", nullptr, zrank, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "zrangeByScore", nullptr, zrangeByScore, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "enqueue", nullptr, enqueue, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "peek", nullptr, peek, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "ack", nullptr, ack, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "queueLength", nullptr, queueLength, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "collectBlobGarbage", nullptr, collectBlobGarbage, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "trainCompressionDictionary", nullptr, trainCompressionDictionary, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "openWriteStream", nullptr, openWriteStream, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "streamWrite", nullptr, streamWrite, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "streamFinish", nullptr, streamFinish, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "streamAbort", nullptr, streamAbort, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "openReadStream", nullptr, openReadStream, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "streamRead", nullptr, streamRead, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "streamReadAt", nullptr, streamReadAt, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "streamSize", nullptr, streamSize, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "streamRelease", nullptr, streamRelease, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "streamLength", nullptr, streamLength, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "removeStream", nullptr, removeStream, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "putVector", nullptr, putVector, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "getVector", nullptr, getVector, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "removeVector", nullptr, removeVector, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "searchVectors", nullptr, searchVectors, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "defineSchema", nullptr, defineSchema, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "putRecord", nullptr, putRecord, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "getFields", nullptr, getFields, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "defineIndex", nullptr, defineIndex, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "dropIndex", nullptr, dropIndex, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "indexes", nullptr, indexes, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "queryIndex", nullptr, queryIndex, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "queryTags", nullptr, queryTags, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "countTags", nullptr, countTags, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "complete", nullptr, complete, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "putPoint", nullptr, putPoint, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "getPoint", nullptr, getPoint, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "removePoint", nullptr, removePoint, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "queryRadius", nullptr, queryRadius, nullptr, nullptr, nullptr, napi_default, nullptr },
+        { "queryBox", nullptr, queryBox, nullptr, nullptr, nullptr, napi_default, nullptr },
     };
     napi_define_properties(env, exports, sizeof(desc) / sizeof(desc[0]), desc);
     return exports;
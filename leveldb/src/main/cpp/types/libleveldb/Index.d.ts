@@ -1,21 +1,424 @@
-export const open: (path: string) => number;
+export interface KeyRange {
+  start?: LevelDBKey;
+  limit?: LevelDBKey;
+}
+
+export interface LevelDBLevelStats {
+  level: number;
+  files: number;
+  sizeMB: number;
+  timeSec: number;
+  readMB: number;
+  writeMB: number;
+}
+
+export interface LevelDBStats {
+  filesAtLevel: number[];
+  totalFiles: number;
+  levels: LevelDBLevelStats[];
+  approximateMemoryUsage: number;
+  stats: string;
+  sstables: string;
+}
+
+export interface CompactionResult {
+  sizeBefore: number;
+  sizeAfter: number;
+  totalRanges: number;
+  completedRanges: number;
+  cancelled: boolean;
+}
+
+export interface IdleCompactionOptions {
+  enabled: boolean;
+  intervalMs?: number;
+  maxRanges?: number;
+}
+
+export interface DeviceState {
+  idle: boolean;
+  charging: boolean;
+}
+
+export interface TombstoneCompactionOptions {
+  enabled: boolean;
+  threshold?: number;
+  delimiters?: string;
+}
+
+export interface TombstoneStats {
+  prefix: string;
+  count: number;
+  start: string;
+  limit: string;
+}
+
+export interface WritePressure {
+  level: number;
+  l0Files: number;
+  memtableBytes: number;
+  writeBufferSize: number;
+  avgWriteLatencyUs: number;
+  maxWriteLatencyUs: number;
+}
+
+export interface PutOptions {
+  ttlMs?: number;
+}
+
+export interface ExpirySweepOptions {
+  intervalMs?: number;
+  batchSize?: number;
+}
+
+export type MergeOperator = 'add' | 'max' | 'append';
+
+// uint64BE/int64BE：8 字节 key 按大端无符号/有符号整数排序，其他长度的 key 排在其后
+export type ComparatorId = 'bytewise' | 'uint64BE' | 'int64BE' | 'reverseBytewise' | 'caseInsensitiveAscii';
+
+// lru: 读写都会刷新访问顺序；fifo: 只按写入顺序淘汰
+export type CacheEviction = 'lru' | 'fifo';
+
+export interface OpenOptions {
+  comparator?: ComparatorId;
+  // 大于 0 时启用缓存模式：磁盘占用超过上限后在后台按 eviction 策略淘汰
+  maxBytes?: number;
+  eviction?: CacheEviction;
+  // 不小于 blobThreshold 字节的值写入独立的追加式 blob 文件，LSM 中只保存指针（0 为关闭）
+  blobThreshold?: number;
+  // blob 文件中仍被引用的比例低于该值时在后台重写，默认 0.5
+  blobGcRatio?: number;
+  // lz：值在包装层压缩(不小于 compressionMinBytes 字节且压缩后更小时)，读取时自动解压
+  compression?: ValueCompression;
+  compressionMinBytes?: number;
+  // 不小于 dedupThreshold 字节的值按内容哈希只存一份并记录引用计数，内容相同的 key 共享（0 为关闭）
+  dedupThreshold?: number;
+}
+
+export type ValueCompression = 'none' | 'lz';
+
+// 从 prefix 下的前 sampleCount 个值中训练字典，字典不超过 maxSize 字节(最大 32KB)
+export interface DictionaryOptions {
+  prefix?: LevelDBKey;
+  sampleCount?: number;
+  maxSize?: number;
+}
+
+// 元组 key 的元素：string、number(double)、bigint(int64)、Uint8Array(bytes)、{ uint64 }
+export interface UInt64KeyPart {
+  uint64: bigint;
+}
+
+export type KeyPart = string | number | bigint | Uint8Array | UInt64KeyPart;
+
+// 字符串、二进制或元组(按保序编码写入)
+export type LevelDBKey = string | Uint8Array | ArrayBuffer | KeyPart[];
+
+export type KeyEncoding = 'utf8' | 'binary' | 'tuple';
+
+// 'object' 将 JSON 值解析为对象返回，其余值仍为字符串
+export type ValueEncoding = 'utf8' | 'object';
+
+export type WhereValue = string | number | bigint | boolean | null;
+
+// field 为点分路径(为空表示整个值)，同一条件内的多个运算符同时生效
+export interface WherePredicate {
+  field?: string;
+  eq?: WhereValue;
+  gt?: WhereValue;
+  gte?: WhereValue;
+  lt?: WhereValue;
+  lte?: WhereValue;
+  exists?: boolean;
+}
+
+export interface ScanOptions {
+  gt?: LevelDBKey;
+  gte?: LevelDBKey;
+  lt?: LevelDBKey;
+  lte?: LevelDBKey;
+  prefix?: LevelDBKey;
+  limit?: number;
+  reverse?: boolean;
+  keyEncoding?: KeyEncoding;
+  // 所有条件都满足的条目才会返回，limit 按返回条目计数
+  where?: WherePredicate[];
+  valueEncoding?: ValueEncoding;
+  // 只返回这些字段(点分路径)组成的对象；按 schema 打包的记录只解码这些列（仅 scan 使用）
+  project?: string[];
+}
+
+// [min, max) 等宽分桶，区间外的值计入 below/above
+export interface HistogramOptions {
+  min: number;
+  max: number;
+  buckets: number;
+}
+
+export interface AggregateOptions {
+  // JSON 字段的点分路径，为空时统计值本身
+  field?: string;
+  histogram?: HistogramOptions;
+}
+
+export interface HistogramResult {
+  buckets: number[];
+  below: number;
+  above: number;
+}
+
+// count 为数值条目数，skipped 为非数值条目数；count 为 0 时没有 min/max/mean
+export interface AggregateResult {
+  count: number;
+  skipped: number;
+  sum: number;
+  min?: number;
+  max?: number;
+  mean?: number;
+  histogram?: HistogramResult;
+}
+
+export interface SortedSetMember {
+  member: string;
+  score: number;
+}
+
+// 分数范围，offset 跳过前若干个结果后再应用 limit
+export interface ScoreRange {
+  gt?: number;
+  gte?: number;
+  lt?: number;
+  lte?: number;
+  offset?: number;
+  limit?: number;
+  reverse?: boolean;
+}
+
+export interface BlobGcResult {
+  filesRewritten: number;
+  bytesMoved: number;
+  bytesReclaimed: number;
+}
+
+// seq 为入队时分配的递增序号
+export interface QueueItem {
+  seq: number;
+  value: string;
+}
+
+export interface ScanEntry {
+  key: string | Uint8Array | KeyPart[];
+  value: string | Object;
+}
+
+// 默认按 utf8 字符串返回 key；二进制或元组 key 需指定 'binary' 或 'tuple'，否则会被当作 UTF-8 解码而损坏
+export interface KeyListOptions {
+  keyEncoding?: KeyEncoding;
+}
+
+// int64 超出 2^53 时以 bigint 返回
+export type SchemaFieldType = 'bool' | 'int32' | 'int64' | 'double' | 'string';
+
+export interface SchemaField {
+  name: string;
+  type: SchemaFieldType;
+}
+
+// dot 与 cosine 越大越相似，l2 为欧氏距离，越小越相似
+export type VectorMetric = 'dot' | 'cosine' | 'l2';
+
+export interface VectorPutOptions {
+  // 额外保存 int8 量化副本，供 quantized 搜索使用
+  quantize?: boolean;
+}
+
+export interface VectorSearchOptions {
+  // 先用量化副本粗筛，再用原始向量重新计算得分；没有量化副本的向量被跳过
+  quantized?: boolean;
+  // 按 key 范围分片并行扫描的线程数，默认按 CPU 核数，最多 8
+  threads?: number;
+}
+
+export interface VectorMatch {
+  key: string;
+  score: number;
+}
+
+// auto：JSON 数字按 double、字符串按字符串、布尔按 0/1 索引，非 JSON 的值按原文本索引
+// tags：字段为字符串数组(或单个字符串、值为 true 的对象成员)时每个元素是一个标签，用 queryTags 查询
+// completion：字段文本(或字符串数组)中每个词开头的前缀，按 scoreField 排序，用 complete 查询
+export type IndexValueType = 'auto' | 'string' | 'number' | 'int64' | 'tags' | 'completion';
+
+export interface IndexOptions {
+  // JSON 字段路径，如 'email'、'address.city'；为空时索引整个 value
+  field?: string;
+  // 只索引以该前缀开头的 key
+  keyPrefix?: LevelDBKey;
+  type?: IndexValueType;
+  // completion 索引的排序依据(数字字段路径)，缺失时得分为 0
+  scoreField?: string;
+}
+
+export interface IndexDefinition {
+  name: string;
+  field: string;
+  keyPrefix: string;
+  type: IndexValueType;
+  scoreField?: string;
+}
+
+export type IndexFieldValue = string | number | bigint | boolean;
+
+export interface IndexQuery {
+  eq?: IndexFieldValue;
+  gt?: IndexFieldValue;
+  gte?: IndexFieldValue;
+  lt?: IndexFieldValue;
+  lte?: IndexFieldValue;
+  limit?: number;
+  reverse?: boolean;
+  keyEncoding?: KeyEncoding;
+}
+
+export interface TagQueryOptions {
+  limit?: number;
+  keyEncoding?: KeyEncoding;
+}
+
+export interface CompletionOptions {
+  keyEncoding?: KeyEncoding;
+}
+
+// term 为匹配到的词(已转小写)，同一个 key 只返回一次
+export interface CompletionMatch {
+  key: LevelDBKey;
+  term: string;
+  score: number;
+}
+
+// 纬度范围 [-90, 90]，经度范围 [-180, 180]，单位为度
+export interface GeoPoint {
+  lat: number;
+  lon: number;
+}
+
+// minLon 大于 maxLon 时表示跨越 180 度经线的区域
+export interface GeoBox {
+  minLat: number;
+  minLon: number;
+  maxLat: number;
+  maxLon: number;
+}
+
+export interface GeoQueryOptions {
+  // 只返回以该前缀开头的 key
+  prefix?: LevelDBKey;
+  limit?: number;
+  keyEncoding?: KeyEncoding;
+}
+
+// distance 为到圆心的距离(米)，只有 queryRadius 返回
+export interface GeoMatch {
+  key: LevelDBKey;
+  lat: number;
+  lon: number;
+  distance?: number;
+}
+
+export const open: (path: string, options?: OpenOptions) => number;
 export const close: (ptr: number) => void;
-export const allKeys: (ptr: number) => string[];
-export const removeValueForKey: (ptr: number, key: string) => void;
-export const removeValuesForKeys: (ptr: number, keys: string[]) => void;
-export const stringForKey: (ptr: number, key: string) => string;
-export const boolForKey: (ptr: number, key: string) => boolean;
-export const int32ForKey: (ptr: number, key: string) => number;
-export const int64ForKey: (ptr: number, key: string) => bigint;
-export const uint32ForKey: (ptr: number, key: string) => number;
-export const uint64ForKey: (ptr: number, key: string) => bigint;
-export const floatForKey: (ptr: number, key: string) => number;
-export const doubleForKey: (ptr: number, key: string) => number;
-export const setStringValue: (ptr: number, key: string, value: string) => void;
-export const setBoolValue: (ptr: number, key: string, value: boolean) => void;
-export const setInt32Value: (ptr: number, key: string, value: number) => void;
-export const setInt64Value: (ptr: number, key: string, value: bigint) => void;
-export const setUInt32Value: (ptr: number, key: string, value: number) => void;
-export const setUInt64Value: (ptr: number, key: string, value: bigint) => void;
-export const setFloatValue: (ptr: number, key: string, value: number) => void;
-export const setDoubleValue: (ptr: number, key: string, value: number) => void;
\ No newline at end of file
+export const allKeys: (ptr: number, options?: KeyListOptions) => LevelDBKey[];
+export const removeValueForKey: (ptr: number, key: LevelDBKey) => void;
+export const removeValuesForKeys: (ptr: number, keys: LevelDBKey[]) => void;
+export const stringForKey: (ptr: number, key: LevelDBKey) => string;
+export const boolForKey: (ptr: number, key: LevelDBKey) => boolean;
+export const int32ForKey: (ptr: number, key: LevelDBKey) => number;
+export const int64ForKey: (ptr: number, key: LevelDBKey) => bigint;
+export const uint32ForKey: (ptr: number, key: LevelDBKey) => number;
+export const uint64ForKey: (ptr: number, key: LevelDBKey) => bigint;
+export const floatForKey: (ptr: number, key: LevelDBKey) => number;
+export const doubleForKey: (ptr: number, key: LevelDBKey) => number;
+export const setStringValue: (ptr: number, key: LevelDBKey, value: string, options?: PutOptions) => void;
+export const setBoolValue: (ptr: number, key: LevelDBKey, value: boolean, options?: PutOptions) => void;
+export const setInt32Value: (ptr: number, key: LevelDBKey, value: number, options?: PutOptions) => void;
+export const setInt64Value: (ptr: number, key: LevelDBKey, value: bigint, options?: PutOptions) => void;
+export const setUInt32Value: (ptr: number, key: LevelDBKey, value: number, options?: PutOptions) => void;
+export const setUInt64Value: (ptr: number, key: LevelDBKey, value: bigint, options?: PutOptions) => void;
+export const setFloatValue: (ptr: number, key: LevelDBKey, value: number, options?: PutOptions) => void;
+export const setDoubleValue: (ptr: number, key: LevelDBKey, value: number, options?: PutOptions) => void;
+export const setObject: (ptr: number, key: LevelDBKey, value: Object, options?: PutOptions) => void;
+export const objectForKey: (ptr: number, key: LevelDBKey) => Object | undefined;
+export const getProperty: (ptr: number, name: string) => string | undefined;
+export const getStats: (ptr: number) => LevelDBStats;
+export const approximateSize: (ptr: number, ranges: KeyRange[]) => number[];
+export const compactAsync: (ptr: number, range?: KeyRange,
+  onProgress?: (completed: number, total: number) => void) => Promise<CompactionResult>;
+export const cancelCompaction: (ptr: number) => void;
+export const setIdleCompaction: (ptr: number, options: IdleCompactionOptions) => void;
+export const reportDeviceState: (ptr: number, state: DeviceState) => void;
+export const setTombstoneCompaction: (ptr: number, options: TombstoneCompactionOptions) => void;
+export const tombstoneStats: (ptr: number) => TombstoneStats[];
+export const writePressure: (ptr: number) => WritePressure;
+export const onWritePressure: (ptr: number, callback?: (pressure: WritePressure) => void) => void;
+export const sweepExpired: (ptr: number, maxKeys?: number) => number;
+export const setExpirySweep: (ptr: number, options: ExpirySweepOptions) => void;
+export const increment: (ptr: number, key: LevelDBKey, delta: bigint) => bigint | undefined;
+export const compareAndSwap: (ptr: number, key: LevelDBKey, expected: string | undefined, value: string) => boolean;
+export const getAndSet: (ptr: number, key: LevelDBKey, value: string) => string | undefined;
+export const merge: (ptr: number, key: LevelDBKey, op: MergeOperator, operand: bigint | number | string) => boolean;
+export const setMergeCollapseThreshold: (ptr: number, threshold: number) => void;
+export const beginTransaction: (ptr: number) => number;
+export const txnGet: (txn: number, key: LevelDBKey) => string | undefined;
+export const txnPut: (txn: number, key: LevelDBKey, value: string) => void;
+export const txnRemove: (txn: number, key: LevelDBKey) => void;
+export const txnCommit: (txn: number) => boolean;
+export const txnRelease: (txn: number) => void;
+export const encodeKey: (parts: KeyPart[]) => Uint8Array;
+export const decodeKey: (key: Uint8Array | ArrayBuffer) => KeyPart[] | undefined;
+export const scan: (ptr: number, options?: ScanOptions) => ScanEntry[];
+export const aggregate: (ptr: number, range?: ScanOptions, options?: AggregateOptions) => AggregateResult;
+export const zadd: (ptr: number, name: string, members: SortedSetMember[]) => number;
+export const zrem: (ptr: number, name: string, members: string[]) => number;
+export const zscore: (ptr: number, name: string, member: string) => number | undefined;
+export const zcard: (ptr: number, name: string) => number;
+export const zrank: (ptr: number, name: string, member: string, reverse?: boolean) => number | undefined;
+export const zrangeByScore: (ptr: number, name: string, range?: ScoreRange) => SortedSetMember[];
+export const enqueue: (ptr: number, name: string, items: string[]) => number | undefined;
+export const peek: (ptr: number, name: string, maxItems: number) => QueueItem[];
+export const ack: (ptr: number, name: string, upToSeq: number) => number;
+export const queueLength: (ptr: number, name: string) => number;
+export const collectBlobGarbage: (ptr: number, sealActive?: boolean) => Promise<BlobGcResult>;
+export const trainCompressionDictionary: (ptr: number, options?: DictionaryOptions) => Promise<number>;
+export const openWriteStream: (ptr: number, key: LevelDBKey, chunkSize?: number) => number;
+export const streamWrite: (writer: number, data: string | Uint8Array | ArrayBuffer) => boolean;
+export const streamFinish: (writer: number) => boolean;
+export const streamAbort: (writer: number) => void;
+export const openReadStream: (ptr: number, key: LevelDBKey) => number | undefined;
+export const streamRead: (reader: number, maxBytes: number) => Uint8Array | undefined;
+export const streamReadAt: (reader: number, offset: number, length: number) => Uint8Array | undefined;
+export const streamSize: (reader: number) => number;
+export const streamRelease: (reader: number) => void;
+export const streamLength: (ptr: number, key: LevelDBKey) => number | undefined;
+export const removeStream: (ptr: number, key: LevelDBKey) => boolean;
+export const defineSchema: (ptr: number, name: string, fields: SchemaField[]) => void;
+export const putRecord: (ptr: number, key: LevelDBKey, schema: string, record: Object, options?: PutOptions) => void;
+export const getFields: (ptr: number, key: LevelDBKey, fields: string[]) => Object | undefined;
+export const putVector: (ptr: number, key: LevelDBKey, vector: Float32Array, options?: VectorPutOptions) => boolean;
+export const getVector: (ptr: number, key: LevelDBKey) => Float32Array | undefined;
+export const removeVector: (ptr: number, key: LevelDBKey) => boolean;
+export const searchVectors: (ptr: number, prefix: LevelDBKey, query: Float32Array, k: number, metric?: VectorMetric,
+  options?: VectorSearchOptions) => Promise<VectorMatch[]>;
+export const defineIndex: (ptr: number, name: string, options?: IndexOptions) => void;
+export const dropIndex: (ptr: number, name: string) => boolean;
+export const indexes: (ptr: number) => IndexDefinition[];
+export const queryIndex: (ptr: number, name: string, query?: IndexQuery) => ScanEntry[];
+export const queryTags: (ptr: number, name: string, expression: string, options?: TagQueryOptions) => LevelDBKey[];
+export const countTags: (ptr: number, name: string, expression: string) => number;
+export const complete: (ptr: number, name: string, input: string, k: number,
+  options?: CompletionOptions) => CompletionMatch[];
+export const putPoint: (ptr: number, key: LevelDBKey, lat: number, lon: number) => boolean;
+export const getPoint: (ptr: number, key: LevelDBKey) => GeoPoint | undefined;
+export const removePoint: (ptr: number, key: LevelDBKey) => boolean;
+export const queryRadius: (ptr: number, lat: number, lon: number, radiusMeters: number,
+  options?: GeoQueryOptions) => GeoMatch[];
+export const queryBox: (ptr: number, box: GeoBox, options?: GeoQueryOptions) => GeoMatch[];
@@ -0,0 +1,129 @@
+#include "Coding.h"
+#include "Comparators.h"
+#include "TestHarness.h"
+#include <random>
+
+static std::string Fixed64(uint64_t value) {
+    std::string key;
+    PutFixed64BE(key, value);
+    return key;
+}
+
+// Keys of the shapes the comparators distinguish: 8-byte numbers, other
+// lengths, mixed-case text, 0xff bytes and internal keys.
+static std::vector<std::string> SampleKeys() {
+    std::mt19937 random(11);
+    std::vector<std::string> keys = {"", "a", "A", "ab", "aB", "b", "\xff", "\xff\xff", InternalKey("ttl:"),
+                                     InternalKey("ttl:a"), InternalKey("merge:")};
+    const char alphabet[] = {'a', 'b', 'A', 'B', '\0', '\x7f', '\x80', '\xff'};
+    for (int i = 0; i < 200; i++) {
+        std::string key;
+        size_t length = i % 3 == 0 ? 8 : random() % 12;
+        for (size_t j = 0; j < length; j++) {
+            key.push_back(alphabet[random() % sizeof(alphabet)]);
+        }
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+static const char *const kComparatorIds[] = {"bytewise", "uint64BE", "int64BE", "reverseBytewise",
+                                             "caseInsensitiveAscii"};
+
+TEST(FindsComparatorsById) {
+    CHECK(FindComparator("") == leveldb::BytewiseComparator());
+    CHECK(FindComparator("bytewise") == leveldb::BytewiseComparator());
+    for (const char *id : kComparatorIds) {
+        CHECK(FindComparator(id) != nullptr);
+        CHECK(FindComparator(id) == FindComparator(id));
+    }
+    CHECK(FindComparator("uint64BE")->Name() != FindComparator("int64BE")->Name());
+    CHECK(FindComparator("Bytewise") == nullptr);
+    CHECK(FindComparator("numeric") == nullptr);
+}
+
+TEST(OrdersFixedWidthIntegers) {
+    const leveldb::Comparator *unsignedOrder = FindComparator("uint64BE");
+    const leveldb::Comparator *signedOrder = FindComparator("int64BE");
+    std::string minusOne = Fixed64(UINT64_MAX);
+    std::string one = Fixed64(1);
+    std::string big = Fixed64(uint64_t(1) << 40);
+    CHECK(unsignedOrder->Compare(one, big) < 0);
+    CHECK(unsignedOrder->Compare(minusOne, one) > 0);
+    CHECK(signedOrder->Compare(minusOne, one) < 0);
+    CHECK(signedOrder->Compare(Fixed64(uint64_t(1) << 63), minusOne) < 0);
+    CHECK(signedOrder->Compare(one, one) == 0);
+    // Keys of any other length come after every number.
+    CHECK(unsignedOrder->Compare(minusOne, "") < 0);
+    CHECK(unsignedOrder->Compare("a", "b") < 0);
+}
+
+TEST(OrdersReverseAndCaseInsensitive) {
+    const leveldb::Comparator *reverse = FindComparator("reverseBytewise");
+    CHECK(reverse->Compare("b", "a") < 0);
+    CHECK(reverse->Compare("ab", "a") < 0);
+    CHECK(reverse->Compare("a", "") < 0);
+
+    const leveldb::Comparator *folded = FindComparator("caseInsensitiveAscii");
+    CHECK(folded->Compare("apple", "Banana") < 0);
+    CHECK(folded->Compare("Zoo", "apple") > 0);
+    CHECK(folded->Compare("abc", "ABCD") < 0);
+    // Ties are broken bytewise, so distinct keys never compare equal.
+    CHECK(folded->Compare("ABC", "abc") < 0);
+    CHECK(folded->Compare("\xc3\x89", "\xc3\xa9") < 0);
+}
+
+TEST(SortsInternalKeysLast) {
+    for (const char *id : kComparatorIds) {
+        if (FindComparator(id) == leveldb::BytewiseComparator()) {
+            continue;
+        }
+        const leveldb::Comparator *comparator = FindComparator(id);
+        for (const std::string &key : SampleKeys()) {
+            if (!IsInternalKey(key)) {
+                CHECK(comparator->Compare(key, InternalKey("")) < 0);
+                CHECK(comparator->Compare(InternalKey("ttl:"), key) > 0);
+            }
+        }
+        CHECK(comparator->Compare(InternalKey("a"), InternalKey("b")) < 0);
+        CHECK(comparator->Compare(InternalKey("b"), InternalKey("a")) > 0);
+    }
+}
+
+TEST(IsATotalOrder) {
+    std::vector<std::string> keys = SampleKeys();
+    for (const char *id : kComparatorIds) {
+        const leveldb::Comparator *comparator = FindComparator(id);
+        for (const std::string &a : keys) {
+            for (const std::string &b : keys) {
+                int forward = comparator->Compare(a, b);
+                int backward = comparator->Compare(b, a);
+                CHECK((forward < 0) == (backward > 0));
+                CHECK((forward == 0) == (a == b));
+            }
+        }
+    }
+}
+
+TEST(ShortensWithinTheOrder) {
+    std::vector<std::string> keys = SampleKeys();
+    for (const char *id : kComparatorIds) {
+        const leveldb::Comparator *comparator = FindComparator(id);
+        for (const std::string &start : keys) {
+            for (const std::string &limit : keys) {
+                if (comparator->Compare(start, limit) >= 0) {
+                    continue;
+                }
+                std::string separator = start;
+                comparator->FindShortestSeparator(&separator, limit);
+                CHECK(separator.size() <= start.size());
+                CHECK(comparator->Compare(start, separator) <= 0);
+                CHECK(comparator->Compare(separator, limit) < 0);
+            }
+            std::string successor = start;
+            comparator->FindShortSuccessor(&successor);
+            CHECK(successor.size() <= start.size());
+            CHECK(comparator->Compare(start, successor) <= 0);
+        }
+    }
+}
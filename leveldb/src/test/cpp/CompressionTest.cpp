@@ -0,0 +1,108 @@
+#include "Compression.h"
+#include "TestHarness.h"
+#include <random>
+
+static bool RoundTrips(const std::string &value, const std::string &dictionary = std::string()) {
+    std::string compressed;
+    LzCompress(value, dictionary, compressed);
+    std::string restored;
+    return LzDecompress(compressed, dictionary, value.size(), restored) && restored == value;
+}
+
+static std::string RandomBytes(size_t size, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::string bytes(size, '\0');
+    for (auto& byte : bytes) {
+        byte = static_cast<char>(random() & 0xff);
+    }
+    return bytes;
+}
+
+static std::string Record(int id) {
+    return "{\"id\":" + std::to_string(id) + ",\"status\":\"active\",\"country\":\"CN\",\"plan\":\"premium\"}";
+}
+
+TEST(RoundTripsAssortedInputs) {
+    CHECK(RoundTrips(""));
+    CHECK(RoundTrips("a"));
+    CHECK(RoundTrips("abcd"));
+    CHECK(RoundTrips(std::string(100000, 'x')));
+    CHECK(RoundTrips(RandomBytes(5000, 1)));
+    std::string mixed;
+    for (int i = 0; i < 2000; i++) {
+        mixed += Record(i) + RandomBytes(i % 40, i);
+    }
+    CHECK(RoundTrips(mixed));
+}
+
+TEST(RoundTripsLongLiteralAndMatchRuns) {
+    // Literal and match lengths of 15 and more need extra length bytes.
+    for (size_t length : {14, 15, 16, 18, 19, 20, 270, 271, 272, 600}) {
+        CHECK(RoundTrips(RandomBytes(length, static_cast<uint32_t>(length))));
+        CHECK(RoundTrips("head" + std::string(length, 'q') + "tail"));
+    }
+}
+
+TEST(RoundTripsBeyondTheWindow) {
+    std::string block = RandomBytes(1000, 7);
+    std::string value;
+    while (value.size() < 3 * kLzWindowSize) {
+        value += block + RandomBytes(kLzWindowSize / 2, static_cast<uint32_t>(value.size()));
+    }
+    CHECK(RoundTrips(value));
+}
+
+TEST(ShrinksRepetitiveInput) {
+    std::string value;
+    for (int i = 0; i < 100; i++) {
+        value += Record(i);
+    }
+    std::string compressed;
+    LzCompress(value, std::string(), compressed);
+    CHECK(compressed.size() < value.size() / 4);
+}
+
+TEST(DictionaryHelpsSmallValues) {
+    std::vector<std::string> samples;
+    for (int i = 0; i < 50; i++) {
+        samples.push_back(Record(i));
+    }
+    std::string dictionary = TrainDictionary(samples, 1024);
+    CHECK(!dictionary.empty());
+    CHECK(dictionary.size() <= 1024);
+
+    std::string value = Record(12345);
+    std::string plain;
+    std::string primed;
+    LzCompress(value, std::string(), plain);
+    LzCompress(value, dictionary, primed);
+    CHECK(primed.size() < plain.size());
+    CHECK(RoundTrips(value, dictionary));
+    // The dictionary is part of the format: another one cannot decode it.
+    std::string restored;
+    CHECK(!LzDecompress(primed, std::string(), value.size(), restored) || restored != value);
+}
+
+TEST(TrainingCapsTheDictionarySize) {
+    std::vector<std::string> samples;
+    for (int i = 0; i < 200; i++) {
+        samples.push_back(RandomBytes(4000, 99) + std::to_string(i));
+    }
+    CHECK(TrainDictionary(samples, 1 << 20).size() <= kMaxDictionarySize);
+    CHECK(TrainDictionary({RandomBytes(500, 1), RandomBytes(500, 2)}, 1024).empty());
+}
+
+TEST(RejectsMalformedInput) {
+    std::string value = RandomBytes(300, 3) + std::string(300, 'z');
+    std::string compressed;
+    LzCompress(value, std::string(), compressed);
+    std::string restored;
+    CHECK(!LzDecompress(leveldb::Slice(compressed.data(), compressed.size() / 2), std::string(), value.size(),
+                        restored));
+    restored.clear();
+    CHECK(!LzDecompress(compressed, std::string(), value.size() + 1, restored));
+    restored.clear();
+    // A match before the start of the output.
+    std::string backwards("\x40" "abcd" "\xff\x00", 7);
+    CHECK(!LzDecompress(backwards, std::string(), 8, restored));
+}
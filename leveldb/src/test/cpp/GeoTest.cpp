@@ -0,0 +1,149 @@
+#include "Geo.h"
+#include "TestHarness.h"
+#include <cmath>
+#include <random>
+
+static bool Near(double a, double b, double tolerance) {
+    return std::fabs(a - b) <= tolerance;
+}
+
+static bool Covered(const std::vector<GeoCellRange> &ranges, uint64_t cell) {
+    for (const auto& range : ranges) {
+        if (cell >= range.first && cell <= range.last) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Sorted, disjoint, not adjacent and within the budget.
+static bool WellFormed(const std::vector<GeoCellRange> &ranges) {
+    if (ranges.empty() || ranges.size() > kMaxGeoCoverRanges) {
+        return false;
+    }
+    for (size_t i = 0; i < ranges.size(); i++) {
+        if (ranges[i].first > ranges[i].last || (i > 0 && ranges[i].first <= ranges[i - 1].last + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(MeasuresGreatCircleDistances) {
+    CHECK(Near(GeoDistance(0, 0, 0, 1), 111195.08, 0.01));
+    CHECK(Near(GeoDistance(48.8566, 2.3522, 51.5074, -0.1278), 343556.53, 0.01));
+    CHECK(Near(GeoDistance(0, 179.5, 0, -179.5), 111195.08, 0.01));
+    CHECK(Near(GeoDistance(90, 0, -90, 0), M_PI * kEarthRadiusMeters, 0.01));
+    CHECK(GeoDistance(31.23, 121.47, 31.23, 121.47) == 0);
+}
+
+TEST(ValidatesCoordinates) {
+    CHECK(IsValidGeoPoint(90, 180));
+    CHECK(IsValidGeoPoint(-90, -180));
+    CHECK(!IsValidGeoPoint(90.5, 0));
+    CHECK(!IsValidGeoPoint(0, -180.5));
+    CHECK(!IsValidGeoPoint(NAN, 0));
+    GeoBox box;
+    box.minLat = 10;
+    box.maxLat = 5;
+    CHECK(!IsValidGeoBox(box));
+}
+
+TEST(RoundTripsPointsAndCellKeys) {
+    double lat = 0;
+    double lon = 0;
+    CHECK(DecodeGeoPoint(EncodeGeoPoint(-33.8688, 151.2093), lat, lon));
+    CHECK(lat == -33.8688 && lon == 151.2093);
+    CHECK(!DecodeGeoPoint("short", lat, lon));
+
+    std::string entry = GeoCellKey(GeoCell(lat, lon), std::string("shop\0:1", 7));
+    uint64_t cell = 0;
+    leveldb::Slice key;
+    CHECK(DecodeGeoCellKey(entry, cell, key));
+    CHECK(cell == GeoCell(lat, lon));
+    CHECK(key == leveldb::Slice("shop\0:1", 7));
+    CHECK(!DecodeGeoCellKey(GeoCellPrefix() + "1234", cell, key));
+}
+
+TEST(OrdersCellsByQuadrant) {
+    // Longitude is the high bit of each pair, so the western half sorts first.
+    CHECK(GeoCell(80, -1) < GeoCell(-80, 1));
+    CHECK(GeoCell(-1, -90) < GeoCell(1, -90));
+    CHECK(GeoCell(-90, -180) == 0);
+    CHECK(GeoCell(90, 180) == UINT64_MAX);
+}
+
+TEST(SplitsBoxesAtTheAntimeridian) {
+    GeoBox box;
+    box.minLat = -10;
+    box.maxLat = 10;
+    box.minLon = 170;
+    box.maxLon = -170;
+    std::vector<GeoBox> boxes = SplitGeoBox(box);
+    CHECK(boxes.size() == 2);
+    CHECK(GeoBoxesContain(boxes, 0, 175));
+    CHECK(GeoBoxesContain(boxes, 0, -175));
+    CHECK(!GeoBoxesContain(boxes, 0, 0));
+
+    boxes = GeoBoxesAround(0, 179.99, 10000);
+    CHECK(boxes.size() == 2);
+    CHECK(GeoBoxesContain(boxes, 0, -179.99));
+}
+
+TEST(WidensCirclesAtThePoles) {
+    std::vector<GeoBox> boxes = GeoBoxesAround(89.99, 0, 5000);
+    CHECK(boxes.size() == 1);
+    CHECK(boxes[0].minLon == -180 && boxes[0].maxLon == 180 && boxes[0].maxLat == 90);
+    CHECK(GeoBoxesContain(boxes, 89.99, 180));
+}
+
+TEST(CoversEveryPointInsideTheCircle) {
+    std::mt19937 random(17);
+    std::uniform_real_distribution<double> latitude(-89, 89);
+    std::uniform_real_distribution<double> longitude(-180, 180);
+    std::uniform_real_distribution<double> unit(-1, 1);
+    for (int query = 0; query < 300; query++) {
+        double lat = latitude(random);
+        double lon = longitude(random);
+        double radius = std::pow(10.0, 1 + 5 * (unit(random) + 1) / 2);
+        std::vector<GeoBox> boxes = GeoBoxesAround(lat, lon, radius);
+        std::vector<GeoCellRange> ranges = CoverGeoBoxes(boxes, kMaxGeoCoverRanges);
+        CHECK(WellFormed(ranges));
+        double spanLat = radius / kEarthRadiusMeters * 180 / M_PI;
+        for (int sample = 0; sample < 100; sample++) {
+            double pointLat = lat + unit(random) * spanLat;
+            double pointLon = lon + unit(random) * spanLat / std::max(std::cos(lat * M_PI / 180), 0.01);
+            pointLon = pointLon > 180 ? pointLon - 360 : (pointLon < -180 ? pointLon + 360 : pointLon);
+            if (!IsValidGeoPoint(pointLat, pointLon) || GeoDistance(lat, lon, pointLat, pointLon) > radius) {
+                continue;
+            }
+            CHECK(GeoBoxesContain(boxes, pointLat, pointLon));
+            CHECK(Covered(ranges, GeoCell(pointLat, pointLon)));
+        }
+    }
+}
+
+TEST(KeepsSmallQueriesNarrow) {
+    std::vector<GeoCellRange> ranges = CoverGeoBoxes(GeoBoxesAround(31.2304, 121.4737, 1000), kMaxGeoCoverRanges);
+    CHECK(WellFormed(ranges));
+    // The ranges span a tiny part of the cell space, so a scan reads only
+    // points in the neighbourhood.
+    double cells = 0;
+    for (const auto& range : ranges) {
+        cells += static_cast<double>(range.last - range.first) + 1;
+    }
+    CHECK(cells / 18446744073709551616.0 < 1e-6);
+    CHECK(!Covered(ranges, GeoCell(31.30, 121.4737)));
+    CHECK(!Covered(ranges, GeoCell(-31.2304, 121.4737)));
+}
+
+TEST(CoversTheWholeWorld) {
+    GeoBox world;
+    world.minLat = -90;
+    world.maxLat = 90;
+    world.minLon = -180;
+    world.maxLon = 180;
+    std::vector<GeoCellRange> ranges = CoverGeoBoxes({world}, kMaxGeoCoverRanges);
+    CHECK(ranges.size() == 1);
+    CHECK(ranges[0].first == 0 && ranges[0].last == UINT64_MAX);
+}
@@ -0,0 +1,52 @@
+#include <algorithm>
+#include <leveldb/comparator.h>
+#include <leveldb/slice.h>
+
+// Host stand-ins for the leveldb symbols the codecs reference; they behave
+// like leveldb's util/comparator.cc.
+namespace leveldb {
+
+Comparator::~Comparator() = default;
+
+class HostBytewiseComparator : public Comparator {
+public:
+    int Compare(const Slice &a, const Slice &b) const override {
+        return a.compare(b);
+    }
+
+    const char *Name() const override {
+        return "leveldb.BytewiseComparator";
+    }
+
+    void FindShortestSeparator(std::string *start, const Slice &limit) const override {
+        size_t minLength = std::min(start->size(), limit.size());
+        size_t diff = 0;
+        while (diff < minLength && (*start)[diff] == limit[diff]) {
+            diff++;
+        }
+        if (diff < minLength) {
+            uint8_t byte = static_cast<uint8_t>((*start)[diff]);
+            if (byte < 0xff && byte + 1 < static_cast<uint8_t>(limit[diff])) {
+                (*start)[diff]++;
+                start->resize(diff + 1);
+            }
+        }
+    }
+
+    void FindShortSuccessor(std::string *key) const override {
+        for (size_t i = 0; i < key->size(); i++) {
+            if (static_cast<uint8_t>((*key)[i]) != 0xff) {
+                (*key)[i]++;
+                key->resize(i + 1);
+                return;
+            }
+        }
+    }
+};
+
+const Comparator *BytewiseComparator() {
+    static const HostBytewiseComparator *comparator = new HostBytewiseComparator();
+    return comparator;
+}
+
+} // namespace leveldb
@@ -0,0 +1,160 @@
+#include "KeyCodec.h"
+#include "Coding.h"
+#include "TestHarness.h"
+#include <cmath>
+#include <limits>
+
+static KeyPart StringPart(const std::string &value) {
+    KeyPart part;
+    part.type = kKeyPartString;
+    part.bytes = value;
+    return part;
+}
+
+static KeyPart BytesPart(const std::string &value) {
+    KeyPart part;
+    part.type = kKeyPartBytes;
+    part.bytes = value;
+    return part;
+}
+
+static KeyPart Int64Part(int64_t value) {
+    KeyPart part;
+    part.type = kKeyPartInt64;
+    part.int64 = value;
+    return part;
+}
+
+static KeyPart UInt64Part(uint64_t value) {
+    KeyPart part;
+    part.type = kKeyPartUInt64;
+    part.uint64 = value;
+    return part;
+}
+
+static KeyPart DoublePart(double value) {
+    KeyPart part;
+    part.type = kKeyPartDouble;
+    part.number = value;
+    return part;
+}
+
+static bool SamePart(const KeyPart &a, const KeyPart &b) {
+    if (a.type != b.type) {
+        return false;
+    }
+    switch (a.type) {
+        case kKeyPartBytes:
+        case kKeyPartString:
+            return a.bytes == b.bytes;
+        case kKeyPartInt64:
+            return a.int64 == b.int64;
+        case kKeyPartUInt64:
+            return a.uint64 == b.uint64;
+        case kKeyPartDouble:
+            return a.number == b.number;
+    }
+    return false;
+}
+
+// Every tuple must encode below the next one.
+static bool EncodesInOrder(const std::vector<std::vector<KeyPart>> &tuples) {
+    for (size_t i = 1; i < tuples.size(); i++) {
+        if (!(EncodeKeyTuple(tuples[i - 1]) < EncodeKeyTuple(tuples[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(RoundTripsEveryPartType) {
+    std::vector<KeyPart> parts = {
+        StringPart("user"), BytesPart(std::string("\x00\x01\xff", 3)), Int64Part(-42),
+        UInt64Part(UINT64_MAX), DoublePart(-3.25), StringPart(""),
+    };
+    std::vector<KeyPart> decoded;
+    CHECK(DecodeKeyTuple(EncodeKeyTuple(parts), decoded));
+    CHECK(decoded.size() == parts.size());
+    for (size_t i = 0; i < parts.size(); i++) {
+        CHECK(SamePart(decoded[i], parts[i]));
+    }
+}
+
+TEST(EscapesEmbeddedZeros) {
+    std::string value("a\0b\0\0", 5);
+    std::vector<KeyPart> decoded;
+    CHECK(DecodeKeyTuple(EncodeKeyTuple({StringPart(value), Int64Part(1)}), decoded));
+    CHECK(decoded.size() == 2);
+    CHECK(decoded[0].bytes == value);
+    CHECK(decoded[1].int64 == 1);
+}
+
+TEST(OrdersSignedIntegers) {
+    std::vector<std::vector<KeyPart>> tuples;
+    for (int64_t value : {std::numeric_limits<int64_t>::min(), int64_t(-300), int64_t(-1), int64_t(0), int64_t(1),
+                          int64_t(255), int64_t(256), std::numeric_limits<int64_t>::max()}) {
+        tuples.push_back({Int64Part(value)});
+    }
+    CHECK(EncodesInOrder(tuples));
+}
+
+TEST(OrdersUnsignedIntegers) {
+    std::vector<std::vector<KeyPart>> tuples;
+    for (uint64_t value : {uint64_t(0), uint64_t(9), uint64_t(10), uint64_t(1) << 40, UINT64_MAX}) {
+        tuples.push_back({UInt64Part(value)});
+    }
+    CHECK(EncodesInOrder(tuples));
+}
+
+TEST(OrdersDoubles) {
+    double infinity = std::numeric_limits<double>::infinity();
+    std::vector<std::vector<KeyPart>> tuples;
+    for (double value : {-infinity, -1e300, -2.5, -1.0, -1e-300, 0.0, 1e-300, 1.0, 2.5, 1e300, infinity}) {
+        tuples.push_back({DoublePart(value)});
+    }
+    CHECK(EncodesInOrder(tuples));
+}
+
+TEST(OrdersStringsAndPrefixTuples) {
+    CHECK(EncodesInOrder({
+        {StringPart("")},
+        {StringPart("a")},
+        {StringPart("a"), Int64Part(-1)},
+        {StringPart("a"), Int64Part(7)},
+        {StringPart(std::string("a\0", 2))},
+        {StringPart("a\x01")},
+        {StringPart("ab")},
+        {StringPart("b")},
+    }));
+}
+
+TEST(OrdersPartTypesByTag) {
+    CHECK(EncodesInOrder({
+        {BytesPart("z")},
+        {StringPart("a")},
+        {Int64Part(-5)},
+        {UInt64Part(0)},
+        {DoublePart(-1.0)},
+    }));
+}
+
+TEST(StaysOutOfTheInternalNamespace) {
+    std::vector<std::vector<KeyPart>> tuples = {
+        {BytesPart("\xff\xff")}, {StringPart("\xff")}, {UInt64Part(UINT64_MAX)}, {DoublePart(NAN)},
+    };
+    for (const auto& tuple : tuples) {
+        std::string key = EncodeKeyTuple(tuple);
+        CHECK(!IsInternalKey(key));
+        CHECK(!IsReservedKey(key));
+    }
+}
+
+TEST(RejectsMalformedTuples) {
+    std::vector<KeyPart> decoded;
+    std::string integer = EncodeKeyTuple({Int64Part(5)});
+    CHECK(!DecodeKeyTuple(leveldb::Slice(integer.data(), integer.size() - 1), decoded));
+    std::string text = EncodeKeyTuple({StringPart("abc")});
+    CHECK(!DecodeKeyTuple(leveldb::Slice(text.data(), text.size() - 1), decoded));
+    CHECK(!DecodeKeyTuple(std::string("\x7f", 1), decoded));
+    CHECK(!DecodeKeyTuple(std::string("\x02" "a\x00\x01", 4), decoded));
+}
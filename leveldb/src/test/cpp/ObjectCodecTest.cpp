@@ -0,0 +1,86 @@
+#include "ObjectCodec.h"
+#include "TestHarness.h"
+
+static bool Encode(const std::string &json, std::string &encoded) {
+    JsonValue value;
+    if (!ParseJson(json, value)) {
+        return false;
+    }
+    encoded.clear();
+    EncodeObject(value, encoded);
+    return true;
+}
+
+static std::string RoundTrip(const std::string &json) {
+    std::string encoded;
+    std::string result;
+    if (!Encode(json, encoded) || !ObjectToJson(encoded, result)) {
+        return "<malformed>";
+    }
+    return result;
+}
+
+TEST(RoundTripsDocuments) {
+    CHECK(RoundTrip("null") == "null");
+    CHECK(RoundTrip("[true,false,null]") == "[true,false,null]");
+    CHECK(RoundTrip("\"caf\\u00e9\\n\"") == "\"caf\xc3\xa9\\n\"");
+    CHECK(RoundTrip(" { \"b\" : 1, \"a\" : [ ] , \"c\" : { } } ") == "{\"b\":1,\"a\":[],\"c\":{}}");
+    CHECK(RoundTrip("[-1,0,42,-9223372036854775808,9223372036854775807]") ==
+          "[-1,0,42,-9223372036854775808,9223372036854775807]");
+    CHECK(RoundTrip("[0.5,-2.25,1e300]") == "[0.5,-2.25,1e+300]");
+}
+
+TEST(KeepsLargeIntegersExact) {
+    std::string encoded;
+    CHECK(Encode("{\"id\":9007199254740993}", encoded));
+    JsonValue value;
+    CHECK(DecodeObject(encoded, value));
+    const JsonValue *id = value.Find("id");
+    CHECK(id != nullptr && id->type == JsonValue::kNumber);
+    CHECK(id->text == "9007199254740993");
+    CHECK(RoundTrip("{\"id\":9007199254740993}") == "{\"id\":9007199254740993}");
+}
+
+TEST(EncodesSmallIntegersCompactly) {
+    std::string encoded;
+    CHECK(Encode("[1,-1,63,-64]", encoded));
+    // Array tag and count, then a tag and one varint byte per integer.
+    CHECK(encoded.size() == 2 + 4 * 2);
+}
+
+TEST(FindsFieldsByPath) {
+    std::string encoded;
+    CHECK(Encode("{\"name\":\"ann\",\"tags\":[1,2],\"address\":{\"city\":\"Oslo\",\"zip\":\"0150\"}}", encoded));
+    JsonValue value;
+    CHECK(FindObjectField(encoded, "name", value));
+    CHECK(value.type == JsonValue::kString && value.text == "ann");
+    CHECK(FindObjectField(encoded, "address.zip", value));
+    CHECK(value.type == JsonValue::kString && value.text == "0150");
+    CHECK(FindObjectField(encoded, "tags", value));
+    CHECK(value.type == JsonValue::kArray && value.items.size() == 2);
+    CHECK(!FindObjectField(encoded, "address.country", value));
+    CHECK(!FindObjectField(encoded, "name.first", value));
+    CHECK(!FindObjectField(encoded, "tags.0", value));
+}
+
+TEST(RejectsMalformedInput) {
+    std::string encoded;
+    CHECK(Encode("{\"a\":[1,\"xyz\",2.5],\"b\":{\"c\":true}}", encoded));
+    JsonValue value;
+    std::string json;
+    for (size_t size = 0; size < encoded.size(); size++) {
+        CHECK(!DecodeObject(leveldb::Slice(encoded.data(), size), value));
+        CHECK(!ObjectToJson(leveldb::Slice(encoded.data(), size), json));
+    }
+    CHECK(!DecodeObject(encoded + "x", value));
+    CHECK(!DecodeObject("\x09", value));
+    // A huge element count with nothing behind it is refused up front.
+    CHECK(!DecodeObject("\x06\xff\xff\xff\xff\x0f", value));
+
+    std::string nested;
+    for (int i = 0; i < 100; i++) {
+        nested += std::string("\x06\x01", 2);
+    }
+    nested.push_back('\x00');
+    CHECK(!DecodeObject(nested, value));
+}
@@ -0,0 +1,116 @@
+#include "Roaring.h"
+#include "TestHarness.h"
+#include <algorithm>
+#include <random>
+#include <set>
+
+static RoaringBitmap FromIds(const std::set<uint32_t> &ids) {
+    RoaringBitmap bitmap;
+    for (uint32_t id : ids) {
+        bitmap.Add(id);
+    }
+    return bitmap;
+}
+
+static bool Matches(const RoaringBitmap &bitmap, const std::set<uint32_t> &expected) {
+    std::vector<uint32_t> ids;
+    bitmap.ToIds(ids);
+    return bitmap.Cardinality() == expected.size() && std::equal(ids.begin(), ids.end(), expected.begin()) &&
+           ids.size() == expected.size();
+}
+
+// Sparse ids in several containers plus one dense container.
+static std::set<uint32_t> RandomIds(uint32_t seed) {
+    std::mt19937 random(seed);
+    std::set<uint32_t> ids;
+    for (int i = 0; i < 3000; i++) {
+        ids.insert(random() % (4 << 16));
+    }
+    for (int i = 0; i < 20000; i++) {
+        ids.insert((7u << 16) | (random() & 0xffff));
+    }
+    ids.insert(UINT32_MAX);
+    return ids;
+}
+
+TEST(AddsAndRemovesIds) {
+    RoaringBitmap bitmap;
+    CHECK(bitmap.Empty());
+    bitmap.Add(5);
+    bitmap.Add(5);
+    bitmap.Add(70000);
+    CHECK(bitmap.Cardinality() == 2);
+    CHECK(bitmap.Contains(5) && bitmap.Contains(70000) && !bitmap.Contains(6));
+    bitmap.Remove(5);
+    bitmap.Remove(70000);
+    CHECK(bitmap.Empty());
+    CHECK(bitmap.Containers().empty());
+}
+
+TEST(SwitchesBetweenArrayAndBitmap) {
+    RoaringContainer container;
+    for (uint32_t value = 0; value < kRoaringArrayMax; value++) {
+        CHECK(container.Add(static_cast<uint16_t>(value * 3)));
+    }
+    CHECK(!container.IsBitmap());
+    CHECK(!container.Add(0));
+    CHECK(container.Add(1));
+    CHECK(container.IsBitmap());
+    CHECK(container.cardinality == kRoaringArrayMax + 1);
+    CHECK(container.Contains(1) && container.Contains(3) && !container.Contains(2));
+    CHECK(container.Remove(1));
+    CHECK(!container.Remove(1));
+    CHECK(container.cardinality == kRoaringArrayMax);
+}
+
+TEST(MatchesSetAlgebra) {
+    std::set<uint32_t> a = RandomIds(1);
+    std::set<uint32_t> b = RandomIds(2);
+    std::set<uint32_t> both;
+    std::set<uint32_t> either;
+    std::set<uint32_t> onlyA;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::inserter(both, both.end()));
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::inserter(either, either.end()));
+    std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::inserter(onlyA, onlyA.end()));
+
+    RoaringBitmap left = FromIds(a);
+    RoaringBitmap right = FromIds(b);
+    CHECK(Matches(left, a));
+    CHECK(Matches(left.And(right), both));
+    CHECK(Matches(left.Or(right), either));
+    CHECK(Matches(left.AndNot(right), onlyA));
+    CHECK(Matches(left.AndNot(left), {}));
+    CHECK(left.AndNot(left).Containers().empty());
+}
+
+TEST(ListsIdsInOrderUpToTheLimit) {
+    RoaringBitmap bitmap = FromIds({900000, 3, 65536, 1});
+    std::vector<uint32_t> ids;
+    bitmap.ToIds(ids, 3);
+    CHECK((ids == std::vector<uint32_t>{1, 3, 65536}));
+}
+
+TEST(EncodesContainers) {
+    for (uint32_t seed : {3u, 4u}) {
+        RoaringBitmap bitmap = FromIds(RandomIds(seed));
+        for (const auto& entry : bitmap.Containers()) {
+            RoaringContainer decoded;
+            CHECK(DecodeRoaringContainer(EncodeRoaringContainer(entry.second), decoded));
+            CHECK(decoded.IsBitmap() == entry.second.IsBitmap());
+            CHECK(decoded.cardinality == entry.second.cardinality);
+            CHECK(decoded.array == entry.second.array && decoded.bits == entry.second.bits);
+        }
+    }
+}
+
+TEST(RejectsMalformedContainers) {
+    RoaringContainer container;
+    CHECK(!DecodeRoaringContainer("", container));
+    CHECK(!DecodeRoaringContainer(std::string("\x00\x01", 2), container));
+    CHECK(!DecodeRoaringContainer(std::string("\x01\x00\x00", 3), container));
+    CHECK(!DecodeRoaringContainer(std::string("\x02\x00\x01", 3), container));
+    // Array values must be strictly ascending.
+    CHECK(!DecodeRoaringContainer(std::string("\x00\x00\x02\x00\x02", 5), container));
+    CHECK(DecodeRoaringContainer(std::string("\x00\x00\x01\x00\x02", 5), container));
+    CHECK(container.cardinality == 2);
+}
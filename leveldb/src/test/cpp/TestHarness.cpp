@@ -0,0 +1,34 @@
+#include "TestHarness.h"
+#include <cstdio>
+#include <vector>
+
+struct TestCase {
+    const char *name;
+    void (*body)();
+};
+
+static std::vector<TestCase> &Tests() {
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+static int failures = 0;
+
+void RegisterTest(const char *name, void (*body)()) {
+    Tests().push_back({name, body});
+}
+
+void ReportFailure(const char *file, int line, const char *condition) {
+    fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, condition);
+    failures++;
+}
+
+int main() {
+    for (const auto& test : Tests()) {
+        int before = failures;
+        test.body();
+        printf("[%s] %s\n", failures == before ? "  OK  " : " FAIL ", test.name);
+    }
+    printf("%zu tests, %d failed\n", Tests().size(), failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,34 @@
+//
+// Created on 2026/10/19.
+//
+// Just enough of a test framework for the native unit tests: TEST(name)
+// defines a case, CHECK fails it (and returns) when a condition is false.
+// Every test executable links TestHarness.cpp, whose main() runs the cases
+// and exits non-zero if any failed.
+
+#ifndef LEVELDB_TEST_HARNESS_H
+#define LEVELDB_TEST_HARNESS_H
+
+void RegisterTest(const char *name, void (*body)());
+void ReportFailure(const char *file, int line, const char *condition);
+
+struct TestRegistrar {
+    TestRegistrar(const char *name, void (*body)()) {
+        RegisterTest(name, body);
+    }
+};
+
+#define TEST(name)                                                \
+    static void name();                                           \
+    static TestRegistrar name##Registrar(#name, name);            \
+    static void name()
+
+#define CHECK(condition)                                          \
+    do {                                                          \
+        if (!(condition)) {                                       \
+            ReportFailure(__FILE__, __LINE__, #condition);        \
+            return;                                               \
+        }                                                         \
+    } while (0)
+
+#endif // LEVELDB_TEST_HARNESS_H